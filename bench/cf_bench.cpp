@@ -0,0 +1,832 @@
+// Accuracy and throughput benchmark of the cf functions against libm.
+//
+// Every function is swept over dense and adversarial input ranges in each
+// of its forms: long double, the D and F tiers and the double batch API.
+// For each (function, form, range) it reports max and mean ULP error
+// versus the long double libm result (rounded to the tested format), the
+// number of special-value mismatches (NaN / inf where libm disagrees),
+// ns/call and calls/sec, and the ns/call of the matching libm routine.
+// The special-value range (zeros, infinities, NaN, extremes) is checked for
+// accuracy only; it is too short to time.
+//
+// Build:
+//   g++ -std=c++17 -O2 bench/cf_bench.cpp cf/cf.c cf/cf_batch.c cf/cf_tiers.c cf/cf_adaptive.c -o cf_bench
+//
+// Usage:
+//   cf_bench [--samples N] [--filter NAME] [--json FILE] [--timeout S]
+//            [--baseline FILE [--ulp-slack U] [--time-slack R]]
+//
+// A (function, form, range) that does not finish within S seconds
+// (default 30) is reported as timed out instead of hanging the run; the
+// memory it held at that point is leaked.
+//
+// --json writes the results as JSON (one result object per line).
+// --baseline reads such a file from an earlier run and exits with status 1
+// if any function got less accurate (max ULP up by more than U, default
+// 0.5) or slower (ns/call up by more than a factor R, default 1.25).
+// R = 0 compares accuracy only, which is how bench/cf_baseline.json (the
+// accuracy bounds at the default sample count) is meant to be used:
+//   cf_bench --baseline bench/cf_baseline.json --time-slack 0
+
+#include "../cf/cf.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <climits>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csetjmp>
+#include <csignal>
+#include <unistd.h>
+#define CF_BENCH_WATCHDOG 1
+#endif
+
+using namespace std;
+
+typedef vector<long double> Inputs;
+
+// ---- input generators ----
+
+// xorshift64*, fixed seed so that every run sees the same inputs
+static unsigned long long rngState = 0x9e3779b97f4a7c15ULL;
+
+static long double uniform01()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (long double)((rngState * 0x2545f4914f6cdd1dULL) >> 11) * ldexpl(1, -53);
+}
+
+static void genUniform(Inputs &v, size_t n, long double lo, long double hi)
+{
+    for (size_t i = 0; i < n; i++)
+        v.push_back(lo + (hi - lo) * uniform01());
+}
+
+// magnitudes log-uniform in [lo, hi], lo > 0
+static void genLog(Inputs &v, size_t n, long double lo, long double hi)
+{
+    long double a = logl(lo), b = logl(hi);
+    for (size_t i = 0; i < n; i++)
+        v.push_back(expl(a + (b - a) * uniform01()));
+}
+
+static void genLogSigned(Inputs &v, size_t n, long double lo, long double hi)
+{
+    genLog(v, n, lo, hi);
+    for (size_t i = 0; i < v.size(); i += 2)
+        v[i] = -v[i];
+}
+
+// within a few thousand ulps of k*pi/2 for random k up to hi*2/pi,
+// where the reduction has to cancel the most bits
+static void genNearHalfPi(Inputs &v, size_t n, long double lo, long double hi)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        long double k = floorl(lo + (hi - lo) * uniform01());
+        long double x = k * (long double)MY_PI_BY_2;
+        long double ulp = x == 0 ? ldexpl(1, -64) : ldexpl(1, ilogbl(x) - 52);
+        v.push_back(x + (uniform01() - 0.5L) * 4096 * ulp);
+    }
+}
+
+// both sides of the point lo, up to hi away, log-uniform in the distance
+static void genNearPoint(Inputs &v, size_t n, long double lo, long double hi)
+{
+    long double a = logl(ldexpl(1, -60)), b = logl(hi);
+    for (size_t i = 0; i < n; i++)
+    {
+        long double d = expl(a + (b - a) * uniform01());
+        v.push_back(i & 1 ? lo + d : lo - d);
+    }
+}
+
+static void genSpecial(Inputs &v, size_t, long double, long double)
+{
+    const long double inf = numeric_limits<long double>::infinity();
+    const long double values[] = {0.0L, -0.0L, inf, -inf, numeric_limits<long double>::quiet_NaN(),
+                                  1.0L, -1.0L, 0.5L, -0.5L, 2.0L, -2.0L,
+                                  (long double)numeric_limits<double>::denorm_min(),
+                                  (long double)numeric_limits<double>::min(),
+                                  (long double)numeric_limits<double>::max(),
+                                  (long double)numeric_limits<float>::min(),
+                                  (long double)numeric_limits<float>::max()};
+    v.insert(v.end(), values, values + sizeof values / sizeof values[0]);
+}
+
+struct Range
+{
+    const char *label;
+    void (*gen)(Inputs &v, size_t n, long double lo, long double hi);
+    long double lo;
+    long double hi;
+};
+
+// ---- error measurement ----
+
+// |got - ref| in units of the last place of ref in the format T (ref
+// rounded to T first, so that a correctly rounded result scores <= 0.5).
+// Returns -1 for a special-value mismatch.
+template <typename T>
+static long double ulpError(long double got, long double ref)
+{
+    if (isnan(ref) || isnan(got))
+        return isnan(ref) && isnan(got) ? 0 : -1;
+    long double rounded = (long double)(T)ref;
+    if (got == rounded)
+        return 0;
+    if (isinf(got) || isinf(rounded))
+        return -1;
+    int e = ilogbl(ref);
+    int minExp = numeric_limits<T>::min_exponent - 1;
+    if (ref == 0 || e < minExp)
+        e = minExp;
+    long double ulp = ldexpl(1, e - (numeric_limits<T>::digits - 1));
+    return fabsl(got - ref) / ulp;
+}
+
+// drop inputs that do not survive rounding to T (overflow to inf, flush to
+// zero); the special-value range keeps everything
+template <typename T>
+static Inputs toFormat(const Inputs &in, bool keepAll)
+{
+    Inputs out;
+    out.reserve(in.size());
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        long double x = (long double)(T)in[i];
+        if (!keepAll && isfinite(in[i]) && (!isfinite(x) || (x == 0 && in[i] != 0)))
+            continue;
+        out.push_back(x);
+    }
+    return out;
+}
+
+// ---- timing ----
+
+static volatile double sink;
+
+typedef chrono::steady_clock Clock;
+
+static double elapsedNs(Clock::time_point start)
+{
+    return (double)chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// enough passes over the inputs to fill about timeBudgetNs, at least one
+static const double timeBudgetNs = 20e6;
+
+template <typename T, typename Fn>
+static double timeScalar(Fn fn, const vector<T> &xs)
+{
+    int passes = 1;
+    for (;;)
+    {
+        Clock::time_point start = Clock::now();
+        T acc = 0;
+        for (int p = 0; p < passes; p++)
+            for (size_t i = 0; i < xs.size(); i++)
+                acc += fn(xs[i]);
+        double ns = elapsedNs(start);
+        sink = (double)acc;
+        if (ns >= timeBudgetNs / 4 || passes >= (1 << 20))
+            return ns / ((double)passes * xs.size());
+        passes *= ns > 0 ? (int)min(16.0, timeBudgetNs / ns) + 1 : 16;
+    }
+}
+
+typedef void (*BatchFunction)(const double *in, double *out, size_t n);
+
+static double timeBatch(BatchFunction fn, const vector<double> &xs, vector<double> &ys)
+{
+    int passes = 1;
+    for (;;)
+    {
+        Clock::time_point start = Clock::now();
+        for (int p = 0; p < passes; p++)
+            fn(xs.data(), ys.data(), xs.size());
+        double ns = elapsedNs(start);
+        sink = ys[0];
+        if (ns >= timeBudgetNs / 4 || passes >= (1 << 20))
+            return ns / ((double)passes * xs.size());
+        passes *= ns > 0 ? (int)min(16.0, timeBudgetNs / ns) + 1 : 16;
+    }
+}
+
+// ---- the function table ----
+
+template <long long N>
+static long double iPowerN(long double x) { return iPower(x, N); }
+template <long long N>
+static double iPowerDN(double x) { return iPowerD(x, N); }
+template <long long N>
+static float iPowerFN(float x) { return iPowerF(x, N); }
+template <long long N>
+static void iPowerBatchN(const double *in, double *out, size_t n) { iPowerBatch(in, N, out, n); }
+// glibc's powl returns inf for (-inf)^-2^63; C99 says +0
+template <long long N>
+static long double powlN(long double x)
+{
+    if (isinf(x) && N < 0)
+        return x < 0 && (N & 1) ? -0.0L : 0.0L;
+    return powl(x, (long double)N);
+}
+template <long long N>
+static double powN(double x) { return pow(x, (double)N); }
+
+// x^(P/Q) with the exponent rounded to double first, as rPowerBatch sees it
+template <int P, int Q>
+static long double rPowerPQ(long double x) { return rPower(x, (double)P / Q); }
+template <int P, int Q>
+static long double powlPQ(long double x) { return powl(x, (double)P / Q); }
+template <int P, int Q>
+static double powPQ(double x) { return pow(x, (double)P / Q); }
+template <int P, int Q>
+static float powfPQ(float x) { return powf(x, (float)((double)P / Q)); }
+template <int P, int Q>
+static void rPowerBatchPQ(const double *in, double *out, size_t n)
+{
+    double y[256];
+    for (size_t i = 0; i < 256; i++)
+        y[i] = (double)P / Q;
+    for (size_t i = 0; i < n; i += 256)
+        rPowerBatch(in + i, y, out + i, min(n - i, (size_t)256));
+}
+template <long long N>
+static float powfN(float x) { return powf(x, (float)N); }
+
+static long double refRSqrt(long double x) { return 1 / sqrtl(x); }
+static long double refCsc(long double x) { return 1 / sinl(x); }
+static long double refSec(long double x) { return 1 / cosl(x); }
+static long double refCot(long double x) { return 1 / tanl(x); }
+// asin(1/x) and acos(1/x) magnify the rounding of 1/x near |x| = 1
+static long double refLeg(long double x) { return sqrtl((fabsl(x) - 1) * (fabsl(x) + 1)); }
+static long double refAcsc(long double x) { return atan2l(copysignl(1, x), refLeg(x)); }
+static long double refAsec(long double x) { return atan2l(refLeg(x), copysignl(1, x)); }
+static long double refAcot(long double x) { return atanl(1 / x); }
+static long double refCsch(long double x) { return 1 / sinhl(x); }
+static long double refSech(long double x) { return 1 / coshl(x); }
+static long double refCoth(long double x) { return 1 / tanhl(x); }
+static long double refAcsch(long double x) { return asinhl(1 / x); }
+// 1/x would round before the cancellation near 1; 1 - x and |x| - 1 are exact
+static long double refAsech(long double x)
+{
+    if (x == 0)
+        return INFINITY;
+    if (x < 0x1p-30L)
+        return x < 0 ? NAN : logl(2 / x);
+    long double d = 1 - x;
+    return log1pl(d / x + sqrtl(d * (1 + x)) / x);
+}
+static long double refAcoth(long double x)
+{
+    long double ax = fabsl(x);
+    long double y = ax == 1 ? INFINITY : 0.5L * log1pl(2 / (ax - 1));
+    return ax < 1 ? NAN : x < 0 ? -y : y;
+}
+
+static double libRSqrt(double x) { return 1 / sqrt(x); }
+static double libCsc(double x) { return 1 / sin(x); }
+static double libSec(double x) { return 1 / cos(x); }
+static double libCot(double x) { return 1 / tan(x); }
+static double libAcsc(double x) { return asin(1 / x); }
+static double libAsec(double x) { return acos(1 / x); }
+static double libAcot(double x) { return atan(1 / x); }
+static double libCsch(double x) { return 1 / sinh(x); }
+static double libSech(double x) { return 1 / cosh(x); }
+static double libCoth(double x) { return 1 / tanh(x); }
+static double libAcsch(double x) { return asinh(1 / x); }
+static double libAsech(double x) { return acosh(1 / x); }
+static double libAcoth(double x) { return atanh(1 / x); }
+
+static float libRSqrtF(float x) { return 1 / sqrtf(x); }
+static float libCscF(float x) { return 1 / sinf(x); }
+static float libSecF(float x) { return 1 / cosf(x); }
+static float libCotF(float x) { return 1 / tanf(x); }
+static float libAcscF(float x) { return asinf(1 / x); }
+static float libAsecF(float x) { return acosf(1 / x); }
+static float libAcotF(float x) { return atanf(1 / x); }
+static float libCschF(float x) { return 1 / sinhf(x); }
+static float libSechF(float x) { return 1 / coshf(x); }
+static float libCothF(float x) { return 1 / tanhf(x); }
+static float libAcschF(float x) { return asinhf(1 / x); }
+static float libAsechF(float x) { return acoshf(1 / x); }
+static float libAcothF(float x) { return atanhf(1 / x); }
+
+// the libm overloads need a cast to pick the right one
+#define LDL(f) ((long double (*)(long double))(f))
+#define DBL(f) ((double (*)(double))(f))
+#define FLT(f) ((float (*)(float))(f))
+
+static const Range specialRange = {"special", genSpecial, 0, 0};
+
+struct Entry
+{
+    const char *name;
+    long double (*cfL)(long double);
+    double (*cfD)(double); // NULL when there is no double or float tier
+    float (*cfF)(float);
+    BatchFunction cfBatch; // NULL when there is no batch form
+    long double (*refL)(long double);
+    double (*libD)(double);
+    float (*libF)(float);
+    vector<Range> ranges;
+    double (*cfA)(double) = nullptr; // adaptive-precision form, if any
+};
+
+static vector<Entry> buildEntries()
+{
+    const Range positive = {"log [1e-300,1e300]", genLog, 1e-300L, 1e300L};
+    const Range nearOne = {"near 1", genNearPoint, 1, 0.25L};
+    const Range trigDense = {"dense [-10,10]", genUniform, -10, 10};
+    const Range trigLarge = {"large |x| [1e2,1e15]", genLogSigned, 1e2L, 1e15L};
+    const Range trigHuge = {"huge |x| [1e15,1e300]", genLogSigned, 1e15L, 1e300L};
+    const Range halfPi = {"near k*pi/2, k < 1e6", genNearHalfPi, 0, 1e6L};
+    const Range halfPiSmall = {"near k*pi/2, k < 8", genNearHalfPi, -8, 8};
+    const Range tiny = {"tiny |x| [1e-20,1e-2]", genLogSigned, 1e-20L, 1e-2L};
+    const Range wide = {"log |x| [1e-10,1e10]", genLogSigned, 1e-10L, 1e10L};
+    const Range unit = {"dense [-1,1]", genUniform, -1, 1};
+    const Range nearPlusOne = {"near +1", genNearPoint, 1, 1e-3L};
+    const Range nearMinusOne = {"near -1", genNearPoint, -1, 1e-3L};
+    const Range outsideUnit = {"log |x| [1,1e10]", genLogSigned, 1, 1e10L};
+    const Range hyp = {"dense [-20,20]", genUniform, -20, 20};
+    const Range hypLarge = {"large |x| [20,700]", genLogSigned, 20, 700};
+    const Range powBase = {"log |x| [1e-4,1e4]", genLogSigned, 1e-4L, 1e4L};
+    const Range powNear1 = {"log |x| [0.5,2]", genLogSigned, 0.5L, 2};
+    const Range powHuge = {"near 1, |x-1| < 1e-17", genNearPoint, 1, 1e-17L};
+    const Range powReal = {"log [1e-3,1e3]", genLog, 1e-3L, 1e3L};
+
+    vector<Entry> e;
+    e.push_back({"iPower(x,2)", iPowerN<2>, iPowerDN<2>, iPowerFN<2>, iPowerBatchN<2>, powlN<2>, powN<2>, powfN<2>, {powBase}});
+    e.push_back({"iPower(x,7)", iPowerN<7>, iPowerDN<7>, iPowerFN<7>, iPowerBatchN<7>, powlN<7>, powN<7>, powfN<7>, {powBase}});
+    e.push_back({"iPower(x,-3)", iPowerN<-3>, iPowerDN<-3>, iPowerFN<-3>, iPowerBatchN<-3>, powlN<-3>, powN<-3>, powfN<-3>, {powBase}});
+    // long chains, where plain square-and-multiply roundings add up, and the
+    // exponents whose magnitude does not fit a long long
+    e.push_back({"iPower(x,31)", iPowerN<31>, iPowerDN<31>, iPowerFN<31>, iPowerBatchN<31>, powlN<31>, powN<31>, powfN<31>, {powNear1}});
+    e.push_back({"iPower(x,63)", iPowerN<63>, iPowerDN<63>, iPowerFN<63>, iPowerBatchN<63>, powlN<63>, powN<63>, powfN<63>, {powNear1}});
+    e.push_back({"iPower(x,-50)", iPowerN<-50>, iPowerDN<-50>, iPowerFN<-50>, iPowerBatchN<-50>, powlN<-50>, powN<-50>, powfN<-50>, {powNear1}});
+    e.push_back({"iPower(x,LLONG_MIN)", iPowerN<LLONG_MIN>, iPowerDN<LLONG_MIN>, iPowerFN<LLONG_MIN>, iPowerBatchN<LLONG_MIN>,
+                 powlN<LLONG_MIN>, powN<LLONG_MIN>, powfN<LLONG_MIN>, {powHuge}});
+    e.push_back({"iPower(x,LLONG_MAX)", iPowerN<LLONG_MAX>, iPowerDN<LLONG_MAX>, iPowerFN<LLONG_MAX>, iPowerBatchN<LLONG_MAX>,
+                 powlN<LLONG_MAX>, powN<LLONG_MAX>, powfN<LLONG_MAX>, {powHuge}});
+    // rPower has no float or double tier
+    e.push_back({"rPower(x,2.5)", rPowerPQ<5, 2>, nullptr, nullptr, rPowerBatchPQ<5, 2>, powlPQ<5, 2>, powPQ<5, 2>,
+                 powfPQ<5, 2>, {powReal, powNear1}});
+    e.push_back({"rPower(x,-1.75)", rPowerPQ<-7, 4>, nullptr, nullptr, rPowerBatchPQ<-7, 4>, powlPQ<-7, 4>,
+                 powPQ<-7, 4>, powfPQ<-7, 4>, {powReal, powNear1}});
+    e.push_back({"rPower(x,0.3)", rPowerPQ<3, 10>, nullptr, nullptr, rPowerBatchPQ<3, 10>, powlPQ<3, 10>,
+                 powPQ<3, 10>, powfPQ<3, 10>, {powReal, powNear1}});
+    e.push_back({"Sqrt", Sqrt, SqrtD, SqrtF, SqrtBatch, LDL(sqrtl), DBL(sqrt), FLT(sqrtf), {positive}});
+    e.push_back({"RSqrt", RSqrt, RSqrtD, RSqrtF, RSqrtBatch, refRSqrt, libRSqrt, libRSqrtF, {positive}});
+    e.push_back({"Exp", Exp, ExpD, ExpF, ExpBatch, LDL(expl), DBL(exp), FLT(expf),
+                 {{"dense [-745,709]", genUniform, -745, 709},
+                  {"small [-1,1]", genUniform, -1, 1},
+                  tiny,
+                  {"near ln2/2", genNearPoint, 0.5L * (long double)LN2, 0.01L}}});
+    e.back().cfA = ExpA;
+    e.push_back({"Ln", Ln, LnD, LnF, LnBatch, LDL(logl), DBL(log), FLT(logf), {positive, nearOne}});
+    e.back().cfA = LnA;
+    e.push_back({"Log", Log, LogD, LogF, LogBatch, LDL(log10l), DBL(log10), FLT(log10f), {positive, nearOne}});
+    e.back().cfA = LogA;
+    e.push_back({"Lg", Lg, LgD, LgF, LgBatch, LDL(log2l), DBL(log2), FLT(log2f), {positive, nearOne}});
+    e.back().cfA = LgA;
+    e.push_back({"Sine", Sine, SineD, SineF, SineBatch, LDL(sinl), DBL(sin), FLT(sinf),
+                 {trigDense, trigLarge, trigHuge, halfPi}});
+    e.back().cfA = SineA;
+    e.push_back({"Cosine", Cosine, CosineD, CosineF, CosineBatch, LDL(cosl), DBL(cos), FLT(cosf),
+                 {trigDense, trigLarge, trigHuge, halfPi}});
+    e.back().cfA = CosineA;
+    e.push_back({"Tangent", Tangent, TangentD, TangentF, TangentBatch, LDL(tanl), DBL(tan), FLT(tanf),
+                 {trigDense, trigLarge, halfPi}});
+    e.push_back({"Cosecant", Cosecant, CosecantD, CosecantF, CosecantBatch, refCsc, libCsc, libCscF,
+                 {trigDense, halfPiSmall}});
+    e.push_back({"Secant", Secant, SecantD, SecantF, SecantBatch, refSec, libSec, libSecF,
+                 {trigDense, halfPiSmall}});
+    e.push_back({"Cotangent", Cotangent, CotangentD, CotangentF, CotangentBatch, refCot, libCot, libCotF,
+                 {trigDense, halfPiSmall}});
+    e.push_back({"arcTangent", arcTangent, arcTangentD, arcTangentF, arcTangentBatch, LDL(atanl), DBL(atan),
+                 FLT(atanf), {{"dense [-2,2]", genUniform, -2, 2}, wide}});
+    e.push_back({"arcSine", arcSine, arcSineD, arcSineF, arcSineBatch, LDL(asinl), DBL(asin), FLT(asinf),
+                 {unit, nearPlusOne, nearMinusOne}});
+    e.push_back({"arcCosine", arcCosine, arcCosineD, arcCosineF, arcCosineBatch, LDL(acosl), DBL(acos),
+                 FLT(acosf), {unit, nearPlusOne, nearMinusOne}});
+    e.push_back({"arcCosecant", arcCosecant, arcCosecantD, arcCosecantF, arcCosecantBatch, refAcsc, libAcsc,
+                 libAcscF, {outsideUnit, nearPlusOne}});
+    e.push_back({"arcSecant", arcSecant, arcSecantD, arcSecantF, arcSecantBatch, refAsec, libAsec, libAsecF,
+                 {outsideUnit, nearPlusOne}});
+    e.push_back({"arcCotangent", arcCotangent, arcCotangentD, arcCotangentF, arcCotangentBatch, refAcot,
+                 libAcot, libAcotF, {wide}});
+    e.push_back({"Sinh", Sinh, SinhD, SinhF, SinhBatch, LDL(sinhl), DBL(sinh), FLT(sinhf), {hyp, tiny, hypLarge}});
+    e.push_back({"Cosh", Cosh, CoshD, CoshF, CoshBatch, LDL(coshl), DBL(cosh), FLT(coshf), {hyp, tiny, hypLarge}});
+    e.push_back({"Tanh", Tanh, TanhD, TanhF, TanhBatch, LDL(tanhl), DBL(tanh), FLT(tanhf), {hyp, tiny}});
+    e.push_back({"Csch", Csch, CschD, CschF, CschBatch, refCsch, libCsch, libCschF, {hyp, tiny}});
+    e.push_back({"Sech", Sech, SechD, SechF, SechBatch, refSech, libSech, libSechF, {hyp, tiny}});
+    e.push_back({"Coth", Coth, CothD, CothF, CothBatch, refCoth, libCoth, libCothF, {hyp, tiny}});
+    e.push_back({"arcSinh", arcSinh, arcSinhD, arcSinhF, arcSinhBatch, LDL(asinhl), DBL(asinh), FLT(asinhf),
+                 {{"log |x| [1e-20,1e300]", genLogSigned, 1e-20L, 1e300L}, tiny}});
+    e.push_back({"arcCosh", arcCosh, arcCoshD, arcCoshF, arcCoshBatch, LDL(acoshl), DBL(acosh), FLT(acoshf),
+                 {{"log [1,1e300]", genLog, 1, 1e300L}, {"just above 1", genNearPoint, 1, 1e-3L}}});
+    e.push_back({"arcTanh", arcTanh, arcTanhD, arcTanhF, arcTanhBatch, LDL(atanhl), DBL(atanh), FLT(atanhf),
+                 {unit, tiny, nearPlusOne}});
+    e.push_back({"arcCsch", arcCsch, arcCschD, arcCschF, arcCschBatch, refAcsch, libAcsch, libAcschF,
+                 {{"log |x| [1e-10,1e20]", genLogSigned, 1e-10L, 1e20L}}});
+    e.push_back({"arcSech", arcSech, arcSechD, arcSechF, arcSechBatch, refAsech, libAsech, libAsechF,
+                 {{"log [1e-20,1]", genLog, 1e-20L, 1}, nearPlusOne}});
+    e.push_back({"arcCoth", arcCoth, arcCothD, arcCothF, arcCothBatch, refAcoth, libAcoth, libAcothF,
+                 {outsideUnit, nearPlusOne}});
+    return e;
+}
+
+// ---- running ----
+
+struct Result
+{
+    string function;
+    string format;
+    string range;
+    bool timedOut;
+    size_t samples;
+    long double maxUlp;
+    long double meanUlp;
+    long double worstInput;
+    size_t specialFailures;
+    double nsPerCall;
+    double libmNsPerCall;
+};
+
+struct Accuracy
+{
+    long double maxUlp = 0;
+    long double sumUlp = 0;
+    long double worstInput = 0;
+    size_t counted = 0;
+    size_t specialFailures = 0;
+
+    void add(long double x, long double err)
+    {
+        if (err < 0)
+        {
+            specialFailures++;
+            return;
+        }
+        if (err > maxUlp)
+        {
+            maxUlp = err;
+            worstInput = x;
+        }
+        sumUlp += err;
+        counted++;
+    }
+};
+
+static Result makeResult(const Entry &e, const char *format, const Range &r, const Inputs &xs,
+                         const Accuracy &acc, double ns, double libNs)
+{
+    Result res;
+    res.function = e.name;
+    res.format = format;
+    res.range = r.label;
+    res.timedOut = false;
+    res.samples = xs.size();
+    res.maxUlp = acc.maxUlp;
+    res.meanUlp = acc.counted ? acc.sumUlp / acc.counted : 0;
+    res.worstInput = acc.worstInput;
+    res.specialFailures = acc.specialFailures;
+    res.nsPerCall = ns;
+    res.libmNsPerCall = libNs;
+    return res;
+}
+
+template <typename T>
+static Result runScalar(const Entry &e, const char *format, T (*fn)(T), T (*lib)(T), const Range &r,
+                        const Inputs &raw)
+{
+    Inputs xs = toFormat<T>(raw, r.gen == genSpecial);
+    vector<T> typed(xs.begin(), xs.end());
+    Accuracy acc;
+    for (size_t i = 0; i < xs.size(); i++)
+        acc.add(xs[i], ulpError<T>((long double)fn(typed[i]), e.refL(xs[i])));
+    if (r.gen == genSpecial)
+        return makeResult(e, format, r, xs, acc, 0, 0);
+    double ns = timeScalar<T>(fn, typed);
+    double libNs = timeScalar<T>(lib, typed);
+    return makeResult(e, format, r, xs, acc, ns, libNs);
+}
+
+static Result runBatch(const Entry &e, const Range &r, const Inputs &raw)
+{
+    Inputs xs = toFormat<double>(raw, r.gen == genSpecial);
+    vector<double> typed(xs.begin(), xs.end()), ys(xs.size());
+    e.cfBatch(typed.data(), ys.data(), typed.size());
+    Accuracy acc;
+    for (size_t i = 0; i < xs.size(); i++)
+        acc.add(xs[i], ulpError<double>(ys[i], e.refL(xs[i])));
+    if (r.gen == genSpecial)
+        return makeResult(e, "batch", r, xs, acc, 0, 0);
+    double ns = timeBatch(e.cfBatch, typed, ys);
+    double libNs = timeScalar<double>(e.libD, typed);
+    return makeResult(e, "batch", r, xs, acc, ns, libNs);
+}
+
+#ifdef CF_BENCH_WATCHDOG
+static sigjmp_buf watchdogJump;
+
+static void onWatchdog(int)
+{
+    siglongjmp(watchdogJump, 1);
+}
+#endif
+
+// runs one measurement, abandoning it after the given number of seconds
+template <typename Run>
+static Result guarded(unsigned seconds, const Entry &e, const char *format, const Range &r, Run run)
+{
+    Result res;
+#ifdef CF_BENCH_WATCHDOG
+    signal(SIGALRM, onWatchdog);
+    if (sigsetjmp(watchdogJump, 1) == 0)
+    {
+        alarm(seconds);
+        res = run();
+        alarm(0);
+        return res;
+    }
+#else
+    (void)seconds;
+    return run();
+#endif
+    res.function = e.name;
+    res.format = format;
+    res.range = r.label;
+    res.timedOut = true;
+    res.samples = 0;
+    res.maxUlp = res.meanUlp = res.worstInput = numeric_limits<long double>::quiet_NaN();
+    res.specialFailures = 0;
+    res.nsPerCall = res.libmNsPerCall = 0;
+    return res;
+}
+
+// ---- output ----
+
+static void printNumber(FILE *f, long double v)
+{
+    if (isfinite(v))
+        fprintf(f, "%.6Lg", v);
+    else
+        fprintf(f, "null");
+}
+
+static void printResultJson(FILE *f, const Result &r)
+{
+    if (r.timedOut)
+    {
+        fprintf(f, "    {\"function\": \"%s\", \"format\": \"%s\", \"range\": \"%s\", \"timed_out\": true}",
+                r.function.c_str(), r.format.c_str(), r.range.c_str());
+        return;
+    }
+    fprintf(f, "    {\"function\": \"%s\", \"format\": \"%s\", \"range\": \"%s\", \"samples\": %zu, ",
+            r.function.c_str(), r.format.c_str(), r.range.c_str(), r.samples);
+    fprintf(f, "\"max_ulp\": ");
+    printNumber(f, r.maxUlp);
+    fprintf(f, ", \"mean_ulp\": ");
+    printNumber(f, r.meanUlp);
+    fprintf(f, ", \"worst_input\": ");
+    if (isfinite(r.worstInput))
+        fprintf(f, "%.21Lg", r.worstInput);
+    else
+        fprintf(f, "null");
+    fprintf(f, ", \"special_failures\": %zu, \"ns_per_call\": %.3f, \"calls_per_sec\": %.6g, "
+               "\"libm_ns_per_call\": %.3f}",
+            r.specialFailures, r.nsPerCall, r.nsPerCall > 0 ? 1e9 / r.nsPerCall : 0.0, r.libmNsPerCall);
+}
+
+static bool writeJson(const char *path, const vector<Result> &results, size_t samples)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "cf_bench: cannot write %s\n", path);
+        return false;
+    }
+    fprintf(f, "{\n  \"version\": 1,\n  \"batch_isa\": \"%s\",\n  \"adaptive_fma\": %s,\n",
+            batchIsaName(batchIsa()), adaptiveFma() ? "true" : "false");
+    fprintf(f, "  \"samples_per_range\": %zu,\n", samples);
+    fprintf(f, "  \"reference\": \"long double libm\",\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        printResultJson(f, results[i]);
+        fprintf(f, i + 1 < results.size() ? ",\n" : "\n");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+static void printResultText(const Result &r)
+{
+    if (r.timedOut)
+    {
+        printf("%-14s %-11s %-24s timed out\n", r.function.c_str(), r.format.c_str(), r.range.c_str());
+        fflush(stdout);
+        return;
+    }
+    printf("%-14s %-11s %-24s %8.3Lg %9.3Lg %5zu %9.2f %9.2f\n", r.function.c_str(), r.format.c_str(),
+           r.range.c_str(), r.maxUlp, r.meanUlp, r.specialFailures, r.nsPerCall, r.libmNsPerCall);
+    fflush(stdout);
+}
+
+// ---- baseline comparison ----
+
+// reads "key": value from one result line written by printResultJson
+static string jsonField(const string &line, const char *key)
+{
+    string pattern = string("\"") + key + "\": ";
+    size_t p = line.find(pattern);
+    if (p == string::npos)
+        return "";
+    p += pattern.size();
+    if (line[p] == '"')
+    {
+        size_t end = line.find('"', p + 1);
+        return line.substr(p + 1, end - p - 1);
+    }
+    size_t end = line.find_first_of(",}", p);
+    return line.substr(p, end - p);
+}
+
+static int compareBaseline(const char *path, const vector<Result> &results, double ulpSlack, double timeSlack)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "cf_bench: cannot read %s\n", path);
+        return 2;
+    }
+    int regressions = 0;
+    char buf[4096];
+    while (fgets(buf, sizeof buf, f))
+    {
+        string line = buf;
+        string name = jsonField(line, "function");
+        if (name.empty())
+            continue;
+        string format = jsonField(line, "format"), range = jsonField(line, "range");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &r = results[i];
+            if (r.function != name || r.format != format || r.range != range)
+                continue;
+            bool oldTimedOut = jsonField(line, "timed_out") == "true";
+            if (r.timedOut || oldTimedOut)
+            {
+                if (r.timedOut && !oldTimedOut)
+                {
+                    printf("timeout regression: %s %s %s\n", name.c_str(), format.c_str(), range.c_str());
+                    regressions++;
+                }
+                continue;
+            }
+            string ulp = jsonField(line, "max_ulp"), ns = jsonField(line, "ns_per_call");
+            double oldUlp = ulp == "null" ? HUGE_VAL : atof(ulp.c_str());
+            double oldNs = atof(ns.c_str());
+            size_t oldSpecial = (size_t)atol(jsonField(line, "special_failures").c_str());
+            // the file keeps 6 significant digits
+            if ((double)r.maxUlp > oldUlp * (1 + 1e-5) + ulpSlack || r.specialFailures > oldSpecial)
+            {
+                printf("accuracy regression: %s %s %s: max ulp %.3g -> %.3Lg, special %zu -> %zu\n",
+                       name.c_str(), format.c_str(), range.c_str(), oldUlp, r.maxUlp, oldSpecial,
+                       r.specialFailures);
+                regressions++;
+            }
+            if (timeSlack > 0 && oldNs > 0 && r.nsPerCall > oldNs * timeSlack)
+            {
+                printf("speed regression: %s %s %s: %.2f -> %.2f ns/call\n", name.c_str(), format.c_str(),
+                       range.c_str(), oldNs, r.nsPerCall);
+                regressions++;
+            }
+        }
+    }
+    fclose(f);
+    printf("%d regression(s) against %s\n", regressions, path);
+    return regressions ? 1 : 0;
+}
+
+// ---- main ----
+
+static void usage()
+{
+    fprintf(stderr, "usage: cf_bench [--samples N] [--filter NAME] [--json FILE] [--timeout S]\n"
+                    "                [--baseline FILE [--ulp-slack U] [--time-slack R]]\n");
+}
+
+int main(int argc, char **argv)
+{
+    size_t samples = 20000;
+    const char *filter = NULL, *jsonPath = NULL, *baseline = NULL;
+    double ulpSlack = 0.5, timeSlack = 1.25;
+    unsigned timeout = 30;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--samples") && hasValue)
+            samples = (size_t)atol(argv[++i]);
+        else if (!strcmp(argv[i], "--filter") && hasValue)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--json") && hasValue)
+            jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--timeout") && hasValue)
+            timeout = (unsigned)atol(argv[++i]);
+        else if (!strcmp(argv[i], "--baseline") && hasValue)
+            baseline = argv[++i];
+        else if (!strcmp(argv[i], "--ulp-slack") && hasValue)
+            ulpSlack = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--time-slack") && hasValue)
+            timeSlack = atof(argv[++i]);
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (samples == 0 || timeout == 0)
+    {
+        usage();
+        return 2;
+    }
+
+    printf("batch ISA: %s, adaptive kernels: %s, %zu samples per range, ULP against long double libm\n\n",
+           batchIsaName(batchIsa()), adaptiveFma() ? "fma" : "plain", samples);
+    printf("%-14s %-11s %-24s %8s %9s %5s %9s %9s\n", "function", "format", "range", "max ulp", "mean ulp",
+           "spec", "ns/call", "libm ns");
+
+    vector<Entry> entries = buildEntries();
+    vector<Result> results;
+    for (size_t k = 0; k < entries.size(); k++)
+    {
+        const Entry &e = entries[k];
+        if (filter && strcmp(filter, e.name))
+            continue;
+        vector<Range> ranges = e.ranges;
+        ranges.push_back(specialRange);
+        for (size_t j = 0; j < ranges.size(); j++)
+        {
+            const Range &r = ranges[j];
+            Inputs raw;
+            r.gen(raw, samples, r.lo, r.hi);
+
+            results.push_back(guarded(timeout, e, "long double", r, [&]() {
+                return runScalar<long double>(e, "long double", e.cfL, e.refL, r, raw);
+            }));
+            printResultText(results.back());
+            if (e.cfD)
+            {
+                results.push_back(guarded(timeout, e, "double", r, [&]() {
+                    return runScalar<double>(e, "double", e.cfD, e.libD, r, raw);
+                }));
+                printResultText(results.back());
+            }
+            if (e.cfF)
+            {
+                results.push_back(guarded(timeout, e, "float", r, [&]() {
+                    return runScalar<float>(e, "float", e.cfF, e.libF, r, raw);
+                }));
+                printResultText(results.back());
+            }
+            if (e.cfBatch)
+            {
+                results.push_back(guarded(timeout, e, "batch", r, [&]() { return runBatch(e, r, raw); }));
+                printResultText(results.back());
+            }
+            if (e.cfA)
+            {
+                results.push_back(guarded(timeout, e, "adaptive", r, [&]() {
+                    return runScalar<double>(e, "adaptive", e.cfA, e.libD, r, raw);
+                }));
+                printResultText(results.back());
+                // the same kernels without FMA, to show what it buys
+                if (adaptiveFma() && setAdaptiveFma(0) == 0)
+                {
+                    results.push_back(guarded(timeout, e, "adapt plain", r, [&]() {
+                        return runScalar<double>(e, "adapt plain", e.cfA, e.libD, r, raw);
+                    }));
+                    printResultText(results.back());
+                    setAdaptiveFma(1);
+                }
+            }
+        }
+    }
+
+    if (jsonPath && !writeJson(jsonPath, results, samples))
+        return 2;
+    if (baseline)
+        return compareBaseline(baseline, results, ulpSlack, timeSlack);
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include "cf.h"
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
+#include <stdint.h>
 
 #define HRD_e 2.7182818284590452353602874713526624977
 #define HRD_PI 3.1415926535897932384626433832795028841
@@ -33,136 +35,107 @@ long double myNaN() { return 0.0L / 0.0L; }
 long double minusInf() { return -1.0L / .0L; }
 long double plusInf() { return 1.0L / .0L; }
 
-long double iPower(long double x, long long n)
+// 2^(2^i) for every i with 2^i below the long double exponent range
+static const long double pow2Pow2[] = {
+    0x1p1L, 0x1p2L, 0x1p4L, 0x1p8L, 0x1p16L, 0x1p32L, 0x1p64L, 0x1p128L, 0x1p256L, 0x1p512L,
+#if LDBL_MAX_EXP > 1024
+    0x1p1024L, 0x1p2048L, 0x1p4096L, 0x1p8192L,
+#endif
+};
+#define POW2POW2_LAST ((int)(sizeof(pow2Pow2) / sizeof(pow2Pow2[0])) - 1)
+
+// 2^k by binary powering, at most 15 steps for any long double exponent
+static long double pow2i(long long k)
 {
-    if (!(x == x))
-        return x; // NaN
-    if (n < 0)
+    if (k >= -1000 && k <= 1000)
     {
-        x = 1 / x;
-        n = -n;
-    } // calc. (1/x) ^n)
-    if (n == 0)
-        return 1.0L;
-    else
-    {
-        if (x = plusInf())
-            return x;
-        if (x == minusInf())
-        {
-            if (n % 2)
-                return x;
-            else
-                return -x;
-        }
+        // straight from the exponent field of a double
+        uint64_t bits = (uint64_t)(k + 1023) << 52;
+        double d;
+        memcpy(&d, &bits, sizeof d);
+        return d;
     }
-    long double y = 1.0L;
-    while (n)
+    long double b = k < 0 ? 0.5L : 2.0L;
+    long double r = 1.0L;
+    unsigned long long m = k < 0 ? -k : k;
+    while (m)
     {
-        if ((n % 2) == 1)
-            y *= x;
-        x *= x;
-        n >>= 1;
-        x = y;
-        return x;
+        if (m & 1)
+            r *= b;
+        b *= b;
+        m >>= 1;
     }
+    return r;
 }
 
-long double rPower(long double x, long long y)
+// finite x > 0 as f * 2^e with f in [1, 2), in a bounded number of steps
+static long double splitExponent(long double x, int *e)
 {
-
-    if (!(y == y) && x == 0.0L)
-        return y;
-
-    if ((y = minusInf()) && x == 0.0L)
-        return plusInf();
-
-    if (y == 0)
-        return 1.0L;
-
-    else if (x == 0.0L)
-        return 0.0L;
-
-    else if (x == 1.0L)
-        return 1.0L;
-
-    if (!(x == x))
-        return x;
-
-    if (!(y == y))
-        return y;
-
-    if (x == plusInf() && y == plusInf())
-        return x;
-
-    else if (x == plusInf() && y == minusInf())
-        return 0.0L;
-
-    else if (x == plusInf() && y < 0.0L)
-        return 0.0L;
-
-    else if (x == plusInf() && y > 0.0L)
-        return x;
-
-    if (x == minusInf())
+    if (x >= 0x1p-1000L && x <= 0x1p1000L)
     {
-        if (y == plusInf())
-            return y;
-
-        if (y == minusInf())
-            return 0.0L;
-
-        if ((long long)y == y)
+        // read the exponent off the double nearest x; rounding can only overshoot by one
+        double d = (double)x;
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof bits);
+        int k = (int)(bits >> 52) - 1023;
+        long double f = x * pow2i(-k);
+        if (f < 1)
         {
-
-            if (y == 0.0L)
-                return 1.0L;
-
-            if (y < 0.0L)
-                return 0.0L;
-
-            else
-            {
-                if ((long long)y % 2)
-                    return x;
-                else
-                    return -x;
-            }
+            f *= 2;
+            k--;
         }
-        else
-            return myNaN();
+        *e = k;
+        return f;
     }
 
-    if (ABS(y) == plusInf())
+    int k = 0;
+    if (x < LDBL_MIN)
     {
-        if (ABS(x) == 1.0L)
-            return 1.0L;
-
-        if (y == minusInf() && ABS(x) < 1.0L)
-            return plusInf();
-
-        else if (y == minusInf())
-            return 0.0L;
-
-        else if (y == plusInf() && ABS(x) < 1.0L)
-            return 0.0L;
-
-        if ((long long)y == y)
+        x *= 0x1p64L;
+        k = -64;
+    }
+    for (int i = POW2POW2_LAST; i >= 0; i--)
+    {
+        if (x >= pow2Pow2[i])
         {
-            if (y == 0.0L)
-                return 1.0L;
-
-            return iPower(x, (long long)y);
+            x /= pow2Pow2[i];
+            k += 1 << i;
         }
+    }
+    for (int i = POW2POW2_LAST; i >= 0; i--)
+    {
+        if (x < 2 / pow2Pow2[i])
+        {
+            x *= pow2Pow2[i];
+            k -= 1 << i;
+        }
+    }
+    *e = k;
+    return x;
+}
+
+#define SQRT_MAX_STEPS 8
 
-        return Exp(y * Ln(x));
+// x = m * 4^k with m in [1, 4); sqrt(m) is then within 6% of (m + 2) / 3
+static long double sqrtSeed(long double x, int *k)
+{
+    int e;
+    long double m = splitExponent(x, &e);
+    if (e & 1)
+    {
+        m *= 2;
+        e--;
     }
+    *k = e / 2;
+    return m;
 }
+
 long double Sqrt(long double x)
 {
-    if (x == plusInf())
+    // compile-time infinities: plusInf() divides by zero at run time, which is slow
+    if (x == HRD_INFINITE)
         return x;
-    if (x == minusInf())
+    if (x == -HRD_INFINITE)
         return myNaN();
     if (!(x == x))
         return x;
@@ -173,144 +146,771 @@ long double Sqrt(long double x)
     if (x < 0)
         return myNaN();
 
-    long double term = 2;
+    int k;
+    long double m = sqrtSeed(x, &k);
+    long double term = (m + 2) / 3;
 
-    for (int i = 0; i < MAXITERATION; i++)
+    // after one step the iterates decrease towards sqrt(m); stop when they no longer do
+    term = (term + m / term) * 0.5L;
+    for (int i = 0; i < SQRT_MAX_STEPS; i++)
     {
-        term = (term + x / term) * 0.5;
+        long double next = (term + m / term) * 0.5L;
+        if (next >= term)
+            break;
+        term = next;
     }
-    return term;
+    return term * pow2i(k);
 }
 
-long double Exp(long double x)
+long double RSqrt(long double x)
 {
+    if (!(x == x))
+        return x;
+    if (x < 0)
+        return myNaN();
+    if (x == 0.0L)
+        return HRD_INFINITE;
     if (x == HRD_INFINITE)
+        return 0.0L;
+
+    int k;
+    long double m = sqrtSeed(x, &k);
+    long double y = 3 / (m + 2);
+
+    // y <- y * (3 - m*y^2) / 2, no division per step
+    for (int i = 0; i < SQRT_MAX_STEPS; i++)
+    {
+        long double c = 0.5L - 0.5L * m * y * y;
+        y += y * c;
+        if (ABS(c) <= LDBL_EPSILON)
+            break;
+    }
+    return y * pow2i(-k);
+}
+
+// 2^(j/32), j = 0..31
+static const long double expTable[32] = {
+    1.0000000000000000000000L, 1.0218971486541166782344L, 1.0442737824274138403219L, 1.0671404006768236181695L,
+    1.0905077326652576592070L, 1.1143867425958925363088L, 1.1387886347566916537038L, 1.1637248587775775138135L,
+    1.1892071150027210667175L, 1.2152473599804688781165L, 1.2418578120734840485936L, 1.2690509571917332225544L,
+    1.2968395546510096659337L, 1.3252366431597412946295L, 1.3542555469368927282980L, 1.3839098819638319548726L,
+    1.4142135623730950488016L, 1.4451808069770466200370L, 1.4768261459394993113869L, 1.5091644275934227397660L,
+    1.5422108254079408236122L, 1.5759808451078864864552L, 1.6104903319492543081795L, 1.6457554781539648445187L,
+    1.6817928305074290860622L, 1.7186192981224779156293L, 1.7562521603732994831121L, 1.7947090750031071864277L,
+    1.8340080864093424634870L, 1.8741676341102999013299L, 1.9152065613971472938726L, 1.9571441241754002690183L,
+};
+
+#define EXP_INV_LN2_32 46.166241308446828903551758979206055L
+#define EXP_LN2_32_HI 0.02166084939250367824570275843143463134765625L // 40 bits, n * HI is exact
+#define EXP_LN2_32_LO -5.3873264142546358666135952968708012e-15L
+
+// e^(x + xl) for a non-NaN x and a tail |xl| <= ulp(x) (0 for plain Exp):
+// x = (32k + j) * ln2/32 + r with |r| <= ln2/64, so
+// e^x = 2^k * 2^(j/32) * e^r and e^r needs only a degree 7 polynomial.
+static long double expKernel(long double x, long double xl)
+{
+    if (x > LN2 * (LDBL_MAX_EXP + 1))
         return HRD_INFINITE;
-    if (x == -HRD_INFINITE)
+    if (x < LN2 * (LDBL_MIN_EXP - LDBL_MANT_DIG - 1))
         return 0;
-    if (x == 1)
-        return MY_E;
-    if (x == 0)
-        return 1;
 
-    long double temp = 1.;
-    long double term = 1.;
-    int i = 0;
+    long double t = x * EXP_INV_LN2_32;
+    long long n = (long long)(t < 0 ? t - 0.5L : t + 0.5L);
+    long double r = ((x - n * EXP_LN2_32_HI) - n * EXP_LN2_32_LO) + xl;
+    int j = (int)(n & 31);
+    long long k = (n - j) / 32;
+
+    long double p = 1.0L / 5040;
+    p = p * r + 1.0L / 720;
+    p = p * r + 1.0L / 120;
+    p = p * r + 1.0L / 24;
+    p = p * r + 1.0L / 6;
+    p = p * r + 0.5L;
+    p = p * r * r + r;
+
+    long double y = expTable[j] + expTable[j] * p;
+    // split the scaling so subnormal results and 2^LDBL_MAX_EXP don't overflow an intermediate
+    return (y * pow2i(k / 2)) * pow2i(k - k / 2);
+}
+
+long double Exp(long double x)
+{
+    if (!(x == x))
+        return x;
+    return expKernel(x, 0);
+}
+
+// e^r - 1 for |r| <= ln2/2 by its Taylor series, so that there is no
+// cancellation near 0; the last term is below 2^-64 of the result
+#define EXPM1_POLY_MAX (LN2 / 2)
+static const long double expm1Coeffs[14] = {
+    1.0L / 2, 1.0L / 6, 1.0L / 24, 1.0L / 120, 1.0L / 720, 1.0L / 5040, 1.0L / 40320,
+    1.0L / 362880, 1.0L / 3628800, 1.0L / 39916800, 1.0L / 479001600, 1.0L / 6227020800,
+    1.0L / 87178291200, 1.0L / 1307674368000};
 
-    while (hrd_abs(term) > HRD_PCS)
+static long double expm1Poly(long double r)
+{
+    long double p = expm1Coeffs[13];
+    for (int i = 12; i >= 0; i--)
+        p = p * r + expm1Coeffs[i];
+    return r + r * r * p;
+}
+
+// ln, log2 and log10 of c_j = 1 + j/64 for j = -19..27, with 1/c_j: the
+// grid points that the mantissa m in [sqrt(1/2), sqrt(2)) is reduced to
+#define LN_TABLE_MIN -19
+#define LN_TABLE_SIZE 47
+static const long double invC[LN_TABLE_SIZE] = {
+    1.4222222222222222222222222e+0L, 1.3913043478260869565217391e+0L, 1.3617021276595744680851064e+0L,
+    1.3333333333333333333333333e+0L, 1.3061224489795918367346939e+0L, 1.2800000000000000000000000e+0L,
+    1.2549019607843137254901961e+0L, 1.2307692307692307692307692e+0L, 1.2075471698113207547169811e+0L,
+    1.1851851851851851851851852e+0L, 1.1636363636363636363636364e+0L, 1.1428571428571428571428571e+0L,
+    1.1228070175438596491228070e+0L, 1.1034482758620689655172414e+0L, 1.0847457627118644067796610e+0L,
+    1.0666666666666666666666667e+0L, 1.0491803278688524590163934e+0L, 1.0322580645161290322580645e+0L,
+    1.0158730158730158730158730e+0L, 1.0000000000000000000000000e+0L, 9.8461538461538461538461538e-1L,
+    9.6969696969696969696969697e-1L, 9.5522388059701492537313433e-1L, 9.4117647058823529411764706e-1L,
+    9.2753623188405797101449275e-1L, 9.1428571428571428571428571e-1L, 9.0140845070422535211267606e-1L,
+    8.8888888888888888888888889e-1L, 8.7671232876712328767123288e-1L, 8.6486486486486486486486486e-1L,
+    8.5333333333333333333333333e-1L, 8.4210526315789473684210526e-1L, 8.3116883116883116883116883e-1L,
+    8.2051282051282051282051282e-1L, 8.1012658227848101265822785e-1L, 8.0000000000000000000000000e-1L,
+    7.9012345679012345679012346e-1L, 7.8048780487804878048780488e-1L, 7.7108433734939759036144578e-1L,
+    7.6190476190476190476190476e-1L, 7.5294117647058823529411765e-1L, 7.4418604651162790697674419e-1L,
+    7.3563218390804597701149425e-1L, 7.2727272727272727272727273e-1L, 7.1910112359550561797752809e-1L,
+    7.1111111111111111111111111e-1L, 7.0329670329670329670329670e-1L};
+static const long double lnC[LN_TABLE_SIZE] = {
+    -3.5222059358935209911214292e-1L, -3.3024168687057685627940778e-1L, -3.0873548164961326968244206e-1L,
+    -2.8768207245178092743921901e-1L, -2.6706278524904524629268724e-1L, -2.4686007793152579788464194e-1L,
+    -2.2705745063534608485861287e-1L, -2.0763936477824450161544104e-1L, -1.8859116980755002235892359e-1L,
+    -1.6989903679539747290042490e-1L, -1.5154989812720093784068982e-1L, -1.3353139262452262314634362e-1L,
+    -1.1583181552512170509912006e-1L, -9.8440072813252519902888575e-2L, -8.1345639453952405887342355e-2L,
+    -6.4538521137571171672923916e-2L, -4.8009219186360607752003625e-2L, -3.1748698314580301156996283e-2L,
+    -1.5748356968139168607549511e-2L, 0.0000000000000000000000000e+25L, 1.5504186535965254150854046e-2L,
+    3.0771658666753688371028208e-2L, 4.5809536031294203166679268e-2L, 6.0624621816434842580606132e-2L,
+    7.5223421237587525698605340e-2L, 8.9612158689687132619951469e-2L, 1.0379679368164356482606180e-1L,
+    1.1778303565638345453879411e-1L, 1.3157635778871927258871613e-1L, 1.4518200984449789728193506e-1L,
+    1.5860503017663858409337117e-1L, 1.7185025692665922234009895e-1L, 1.8492233849401199266390359e-1L,
+    1.9782574332991988036257207e-1L, 2.1056476910734963766955281e-1L, 2.2314355131420975576629509e-1L,
+    2.3556607131276690907758822e-1L, 2.4783616390458125678060277e-1L, 2.5995752443692606697207949e-1L,
+    2.7193371548364175883166949e-1L, 2.8376817313064459834690122e-1L, 2.9546421289383587638668191e-1L,
+    3.0702503529491186207512454e-1L, 3.1845373111853461581024721e-1L, 3.2975328637246798181442281e-1L,
+    3.4092658697059321030508920e-1L, 3.5197642315717818465544746e-1L};
+static const long double lgC[LN_TABLE_SIZE] = {
+    -5.0814690367032528922220268e-1L, -4.7643804394298712770585176e-1L, -4.4541114832236262782918925e-1L,
+    -4.1503749927884381854626106e-1L, -3.8529015588479178511606137e-1L, -3.5614381022527530425936114e-1L,
+    -3.2757465802850441029219505e-1L, -2.9956028185890783960318735e-1L, -2.7207954543680082071922198e-1L,
+    -2.4511249783653145563878317e-1L, -2.1864028647534039593031752e-1L, -1.9264507794239589255803068e-1L,
+    -1.6710998583525832475274163e-1L, -1.4201900487242787928022668e-1L, -1.1735695063815874119259307e-1L,
+    -9.3109404391481470675941627e-2L, -6.9262662437113723527797777e-2L, -4.5803689613124791193876401e-2L,
+    -2.2720076500083529650552795e-2L, 0.0000000000000000000000000e+75L, 2.2367813028454508267132084e-2L,
+    4.4394119358453437653101991e-2L, 6.6089190457772432929277009e-2L, 8.7462841250339408254066011e-2L,
+    1.0852445677816905374788719e-1L, 1.2928301694496645531228875e-1L, 1.4974711950468206140674679e-1L,
+    1.6992500144231236290747789e-1L, 1.8982455888001722986401717e-1L, 2.0945336562894978185780418e-1L,
+    2.2881869049588087719437780e-1L, 2.4792751344358549379351942e-1L, 2.6678654069490136364133236e-1L,
+    2.8540221886224834185055160e-1L, 3.0378074817710292442728634e-1L, 3.2192809488736234787031943e-1L,
+    3.3985000288462472581495578e-1L, 3.5755200461808369316597131e-1L, 3.7503943134692475635962759e-1L,
+    3.9231742277876028889570826e-1L, 4.0939093613770175612438544e-1L, 4.2626475470209793888414164e-1L,
+    4.4294349584872830217351227e-1L, 4.5943161863729725619936305e-1L, 4.7573343096639775496428015e-1L,
+    4.9185309632967471077779732e-1L, 5.0779464019869626783878197e-1L};
+static const long double logC[LN_TABLE_SIZE] = {
+    -1.5296746020854349190611646e-1L, -1.4342214230231309720091736e-1L, -1.3408211604816970686821397e-1L,
+    -1.2493873660829995313244989e-1L, -1.1598389395537350985800085e-1L, -1.0720996964786836649617226e-1L,
+    -9.8609797885950805447235571e-2L, -9.0176630349088011648450421e-2L, -8.1904104383098125649441077e-2L,
+    -7.3786214160918664183610764e-2L, -6.5817284489643325745972292e-2L, -5.7991946977686754929000426e-2L,
+    -5.0305118311395772451071989e-2L, -4.2751980420949888735847711e-2L, -3.5327962341742981021776984e-2L,
+    -2.8028723600243538773666570e-2L, -2.0850138973120137396684855e-2L, -1.3788284485633296401990374e-2L,
+    -6.8394245303054659801613032e-3L, 0.0000000000000000000000000e+74L, 6.7333826589684027103328949e-3L,
+    1.3363961557981501976533401e-2L, 1.9894828716939262866698261e-2L, 2.6328938722349147685214315e-2L,
+    3.2669116753368144880371647e-2L, 3.8918066030369659429782890e-2L, 4.5078374735188114810396067e-2L,
+    5.1152522447381288948839122e-2L, 5.7142886136568729791953532e-2L, 6.3051745747089020739756216e-2L,
+    6.8881289407812875585116745e-2L, 7.4633618296904180681377897e-2L, 8.0310751188594700179982861e-2L,
+    8.5914628706593230432838588e-2L, 9.1447117306554256712388018e-2L, 9.6910013008056414358783316e-2L,
+    1.0230504489476257789767824e-1L, 1.0763387839982951844071738e-1L, 1.1289811839218673255032698e-1L,
+    1.1809931207799448715228858e-1L, 1.2323895173040556204399763e-1L, 1.2831847725968055033639368e-1L,
+    1.3333927863473135334544130e-1L, 1.3830269816628145510898329e-1L, 1.4321003266102561344111000e-1L,
+    1.4806253545543770330762244e-1L, 1.5286141833720642863628805e-1L};
+
+// ln2 and log10(2) split so that k * HI is exact for every exponent k
+#define LN_LN2_HI 0xb17217f7d1cfp-48L
+#define LN_LN2_LO 1.6885250050761978067903961e-15L
+#define LN_LOG2_HI 0x9a209a84fbd0p-49L
+#define LN_LOG2_LO -5.8314879359042997360194701e-17L
+
+// ln(1 + r) = r + r^2 * (-1/2 + r/3 - ...) for |r| <= 0.0112; the first
+// dropped term is below 2^-68 of the result
+static const long double ln1pCoeffs[9] = {
+    -1.0L / 2, 1.0L / 3, -1.0L / 4, 1.0L / 5, -1.0L / 6, 1.0L / 7, -1.0L / 8, 1.0L / 9, -1.0L / 10};
+
+// x = 2^k * c_j * (1 + r) with m = x / 2^k in [sqrt(1/2), sqrt(2)) and c_j
+// the grid point nearest m, so |r| <= (1/128) / c_j. m - c_j is exact, and
+// for x near 1 (j = 0) r = m - 1 exactly. Returns ln(1 + r); the table row
+// goes to *j, the exponent to *k. x must be finite and > 0.
+static long double lnReduce(long double x, int *j, int *k)
+{
+    long double m = splitExponent(x, k);
+    if (m > SQRT2)
     {
-        term *= (x / (i + 1));
-        temp += term;
-        i++;
+        m *= 0.5L;
+        (*k)++;
     }
+    // rounded through double: long double to int conversion is slow on x87
+    int i = (int)((double)(m - 1) * 64 + 64.5) - 64;
+    long double r = (m - (1 + i * (1.0L / 64))) * invC[i - LN_TABLE_MIN];
+    *j = i - LN_TABLE_MIN;
+
+    // even and odd halves as two independent chains in r^2, which halves
+    // the latency of the x87 multiply-add sequence
+    long double z = r * r;
+    long double pe = ln1pCoeffs[8], po = ln1pCoeffs[7];
+    for (int n = 6; n >= 0; n -= 2)
+        pe = pe * z + ln1pCoeffs[n];
+    for (int n = 5; n >= 1; n -= 2)
+        po = po * z + ln1pCoeffs[n];
+    return r + z * (pe + r * po);
+}
 
-    return temp;
+// shared special cases: NaN, +inf and x <= 0; returns 1 if *y is the answer
+static int lnSpecial(long double x, long double *y)
+{
+    if (!(x == x) || x == HRD_INFINITE)
+        *y = x;
+    else if (x == 0)
+        *y = -HRD_INFINITE;
+    else if (x < 0)
+        *y = HRD_NOT_A_NUM;
+    else
+        return 0;
+    return 1;
 }
 
+// natural logarithm: k*ln2 + ln(c_j) + ln(1 + r), smallest terms first
 long double Ln(long double x)
 {
-    if (x == 0)
-        return -HRD_INFINITE;
-    if (x == 1)
-        return 0;
-    if (x < 0)
-        return HRD_NOT_A_NUM;
-    if (x == HRD_INFINITE)
+    long double y;
+    if (lnSpecial(x, &y))
+        return y;
+    int j, k;
+    long double p = lnReduce(x, &j, &k);
+    return k * LN_LN2_HI + (lnC[j] + (k * LN_LN2_LO + p));
+}
+
+// log10, built from the same reduction with log10 tables rather than Ln / LN10
+long double Log(long double x)
+{
+    long double y;
+    if (lnSpecial(x, &y))
+        return y;
+    int j, k;
+    long double p = lnReduce(x, &j, &k);
+    return k * LN_LOG2_HI + (logC[j] + (k * LN_LOG2_LO + p * LOGE));
+}
+
+// log2: the exponent is added exactly, so Lg(2^k) == k
+long double Lg(long double x)
+{
+    long double y;
+    if (lnSpecial(x, &y))
+        return y;
+    int j, k;
+    long double p = lnReduce(x, &j, &k);
+    return k + (lgC[j] + p * LGE);
+}
+
+// ---- powers ----
+
+// the part of ln(c_j) that lnC[j] rounds off
+static const long double lnCLo[LN_TABLE_SIZE] = {
+    -4.1652350572128882e-21L, 1.3404966940951739e-20L, -9.6363935101885215e-21L, 3.4560838507429482e-21L,
+    1.0550663043014168e-20L, 2.8560743654699692e-21L, 3.1158822900192066e-21L, -5.0465749409616196e-21L,
+    5.3793376712203043e-21L, -1.0901011745698883e-21L, -3.4465219993443096e-21L, 5.2753315215070841e-21L,
+    -1.6756798660780229e-21L, 5.5699006260190079e-22L, -1.6549359834021836e-21L, -8.4505532992143363e-22L,
+    8.6567560309015025e-22L, 9.2790628034376954e-22L, 7.2914649619424765e-22L, 0.0L,
+    -3.0351701828697648e-23L, -3.7138811670130969e-22L, -1.1701989534100822e-21L, -3.4020156072374160e-22L,
+    -1.3735655131384482e-21L, 9.7419234084270229e-22L, 2.5031862147928844e-21L, 2.2300785527215663e-21L,
+    -3.6239154029017806e-21L, 2.4822721326410781e-21L, -5.1461945105858154e-21L, -5.1317637168209711e-21L,
+    1.4478595540628262e-21L, 5.0368333905140122e-22L, 6.0882122757094963e-21L, 2.4751243973700209e-21L,
+    4.4601571054431325e-21L, -4.5421765874290734e-21L, -1.0192104683784260e-20L, -2.7269373545487005e-21L,
+    2.1349228366462793e-21L, 1.0829791338050818e-20L, 1.2883511920649324e-20L, 9.7250551886245476e-21L,
+    7.8263798502124038e-21L, 1.1481466528125990e-20L, 2.3229310098155371e-21L};
+
+// a = hi + lo exactly, with hi = a rounded (Dekker's split for the
+// 64-bit mantissa: both halves have at most 32 bits)
+#define POW_SPLIT 4294967297.0L // 2^32 + 1
+static long double splitHigh(long double a)
+{
+    long double t = a * POW_SPLIT;
+    return t - (t - a);
+}
+
+// s + *e == a + b exactly
+static long double twoSum(long double a, long double b, long double *e)
+{
+    long double s = a + b;
+    long double bb = s - a;
+    *e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+// ln x as hi + *lo, good to about 2^-75 relative, for finite x > 0: the
+// reduction of lnReduce with r = (m - c_j) / c_j carried as rh + rl and
+// every rounding of the sum k*ln2 + ln(c_j) + ln(1 + r) kept in *lo
+static long double lnExtended(long double x, long double *lo)
+{
+    int k;
+    long double m = splitExponent(x, &k);
+    if (m > SQRT2)
+    {
+        m *= 0.5L;
+        k++;
+    }
+    int i = (int)((double)(m - 1) * 64 + 64.5) - 64;
+    int j = i - LN_TABLE_MIN;
+    long double c = 1 + i * (1.0L / 64);
+    long double d = m - c;
+    long double rh = d * invC[j];
+    // c has 7 bits, so both halves of rh * c are exact
+    long double rhh = splitHigh(rh);
+    long double rl = ((d - rhh * c) - (rh - rhh) * c) * invC[j];
+
+    long double z = rh * rh;
+    long double pe = ln1pCoeffs[8], po = ln1pCoeffs[7];
+    for (int n = 6; n >= 0; n -= 2)
+        pe = pe * z + ln1pCoeffs[n];
+    for (int n = 5; n >= 1; n -= 2)
+        po = po * z + ln1pCoeffs[n];
+    long double t = z * (pe + rh * po);
+
+    long double e1, e2, e3;
+    long double s = twoSum(k * LN_LN2_HI, lnC[j], &e1);
+    s = twoSum(s, rh, &e2);
+    s = twoSum(s, t, &e3);
+    *lo = ((e1 + e2) + e3) + ((k * LN_LN2_LO + lnCLo[j]) + rl * (1 - rh));
+    return s;
+}
+
+// x^y = e^(y ln x) for finite x > 0 and finite y, with y ln x formed as
+// ph + pl so that its rounding does not grow with |y ln x|
+static long double powPositive(long double x, long double y)
+{
+    long double lo;
+    long double hi = lnExtended(x, &lo);
+    long double ph = y * hi;
+    // far outside the exponent range (and where the split below could overflow)
+    if (ph > 0x1p14L)
         return HRD_INFINITE;
-    if (x == 2)
-        return LN2;
-    if (x > 2)
+    if (ph < -0x1p14L)
+        return 0;
+    long double yh = splitHigh(y), hh = splitHigh(hi);
+    long double yl = y - yh, hl = hi - hh;
+    long double pl = (((yh * hh - ph) + yh * hl + yl * hh) + yl * hl) + y * lo;
+    return expKernel(ph, pl);
+}
+
+// y an integer, which every long double of magnitude 2^63 or more is
+static int isInteger(long double y)
+{
+    return ABS(y) >= 0x1p63L || (long double)(long long)y == y;
+}
+
+static int isOddInteger(long double y)
+{
+    return isInteger(y) && !isInteger(0.5L * y);
+}
+
+// (ah + al) * (bh + bl) as hi + *lo, the product ah * bh exactly (Dekker)
+static long double ddMul(long double ah, long double al, long double bh, long double bl, long double *lo)
+{
+    long double p = ah * bh;
+    long double ahh = splitHigh(ah), bhh = splitHigh(bh);
+    long double ahl = ah - ahh, bhl = bh - bhh;
+    long double e = ((ahh * bhh - p) + ahh * bhl + ahl * bhh) + ahl * bhl;
+    e += ah * bl + al * bh;
+    long double s = p + e;
+    *lo = e - (s - p);
+    return s;
+}
+
+// x^m as hi + *lo by binary powering in double long double: one squaring
+// per bit of m, one multiply per set bit, each rounding near 2^-120
+static long double powSquaring(long double x, unsigned long long m, long double *lo)
+{
+    long double yh = 1, yl = 0, xl = 0;
+    for (;;)
     {
-        int c = 0;
-        while (x > 2)
+        if (m & 1)
+            yh = ddMul(yh, yl, x, xl, &yl);
+        m >>= 1;
+        if (!m)
         {
-            c++;
-            x /= 2;
+            *lo = yl;
+            return yh;
         }
+        x = ddMul(x, xl, x, xl, &xl);
+    }
+}
 
-        return (Ln(x) + (LN2 * c));
+// x^-2 to x^3 by plain multiplies stay within 1.5 ulp; past x^+-64
+// e^(n ln x) is the cheaper route
+#define POW_SQUARING_MAX 64
+// x^m range where the splits cannot overflow and the low parts stay normal
+#define POW_SQUARING_LO 0x1p-16000L
+#define POW_SQUARING_HI 0x1p16000L
+
+long double iPower(long double x, long long n)
+{
+    if (n == 0)
+        return 1;
+    if (!(x == x))
+        return x;
+    unsigned long long m = n < 0 ? -(unsigned long long)n : (unsigned long long)n;
+    if ((n >= -2 && n <= 3) || x == 0 || ABS(x) == HRD_INFINITE)
+    {
+        long double y = m == 1 ? x : m == 2 ? x * x : m == 3 ? x * x * x : (m & 1) ? x : x * x;
+        return n > 0 ? y : 1 / y;
     }
-    else if (x > 0 && x < 2)
+    if (m <= POW_SQUARING_MAX)
     {
-        long double temp = 0;
-        long double term = x - 1;
-        double i = 1.;
-        while (hrd_abs(term) > HRD_PCS)
+        long double lo;
+        long double hi = powSquaring(x, m, &lo);
+        if (ABS(hi) >= POW_SQUARING_LO && ABS(hi) <= POW_SQUARING_HI)
         {
-            temp += term;
-            term *= -((x - 1) * (i / (i + 1)));
-            i++;
+            if (n > 0)
+                return hi + lo;
+            // q = 1/x^m, corrected by the residual 1 - x^m * q
+            long double q = 1 / hi;
+            long double e, p = ddMul(hi, 0, q, 0, &e);
+            return q + q * (((1 - p) - e) - lo * q);
         }
-        return temp;
     }
+    long double y = powPositive(ABS(x), (long double)n);
+    return x < 0 && (m & 1) ? -y : y;
 }
 
-long double Log(long double x)
+// C99 pow: integer exponents go to iPower, +-1/2, 3/2 and +-1/4 to Sqrt
+// and RSqrt, the rest through powPositive; negative x only has integer powers
+long double rPower(long double x, long double y)
+{
+    if (y == 0 || x == 1)
+        return 1;
+    if (!(x == x) || !(y == y))
+        return x + y;
+    long double ax = ABS(x);
+    if (ABS(y) == HRD_INFINITE)
+    {
+        if (ax == 1)
+            return 1;
+        return (ax > 1) == (y > 0) ? HRD_INFINITE : 0;
+    }
+    if (ABS(y) < 0x1p63L && isInteger(y))
+        return iPower(x, (long long)y);
+
+    // |y| < 2^63 is not an integer here, so only huge exponents can be odd
+    int odd = isOddInteger(y);
+    long double r;
+    if (ax == 0 || ax == HRD_INFINITE)
+        r = (ax == 0) == (y < 0) ? HRD_INFINITE : 0;
+    else if (x < 0 && !isInteger(y))
+        return HRD_NOT_A_NUM;
+    else if (y == 0.5L)
+        r = Sqrt(ax);
+    else if (y == -0.5L)
+        r = RSqrt(ax);
+    else if (y == 1.5L)
+        r = ax * Sqrt(ax);
+    else if (y == 0.25L)
+        r = Sqrt(Sqrt(ax));
+    else if (y == -0.25L)
+        r = RSqrt(Sqrt(ax));
+    else
+        r = powPositive(ax, y);
+    // an odd power keeps the sign of x, zeros and infinities included
+    return odd && (x < 0 || (x == 0 && 1 / x < 0)) ? -r : r;
+}
+
+// bits of 2/pi, enough for Payne-Hanek reduction of any long double
+static const uint32_t twoOverPi[519] = {
+    0xa2f9836e, 0x4e441529, 0xfc2757d1, 0xf534ddc0, 0xdb629599, 0x3c439041,
+    0xfe5163ab, 0xdebbc561, 0xb7246e3a, 0x424dd2e0, 0x06492eea, 0x09d1921c,
+    0xfe1deb1c, 0xb129a73e, 0xe88235f5, 0x2ebb4484, 0xe99c7026, 0xb45f7e41,
+    0x3991d639, 0x835339f4, 0x9c845f8b, 0xbdf9283b, 0x1ff897ff, 0xde05980f,
+    0xef2f118b, 0x5a0a6d1f, 0x6d367ecf, 0x27cb09b7, 0x4f463f66, 0x9e5fea2d,
+    0x7527bac7, 0xebe5f17b, 0x3d0739f7, 0x8a5292ea, 0x6bfb5fb1, 0x1f8d5d08,
+    0x56033046, 0xfc7b6bab, 0xf0cfbc20, 0x9af4361d, 0xa9e39161, 0x5ee61b08,
+    0x6599855f, 0x14a06840, 0x8dffd880, 0x4d732731, 0x06061556, 0xca73a8c9,
+    0x60e27bc0, 0x8c6b47c4, 0x19c367cd, 0xdce8092a, 0x8359c476, 0x8b961ca6,
+    0xddaf44d1, 0x5719053e, 0xa5ff0705, 0x3f7e33e8, 0x32c2de4f, 0x98327dbb,
+    0xc33d26ef, 0x6b1e5ef8, 0x9f3a1f35, 0xcaf27f1d, 0x87f12190, 0x7c7c246a,
+    0xfa6ed577, 0x2d30433b, 0x15c614b5, 0x9d19c3c2, 0xc4ad414d, 0x2c5d000c,
+    0x467d862d, 0x71e39ac6, 0x9b006233, 0x7cd2b497, 0xa7b4d555, 0x37f63ed7,
+    0x1810a3fc, 0x764d2a9d, 0x64abd770, 0xf87c6357, 0xb07ae715, 0x175649c0,
+    0xd9d63b38, 0x84a7cb23, 0x24778ad6, 0x23545ab9, 0x1f001b0a, 0xf1dfce19,
+    0xff319f6a, 0x1e666157, 0x9947fbac, 0xd87f7eb7, 0x652289e8, 0x3260bfe6,
+    0xcdc4ef09, 0x366cd43f, 0x5dd7de16, 0xde3b5892, 0x9bde2822, 0xd2e88628,
+    0x4d58e232, 0xcac616e3, 0x08cb7de0, 0x50c017a7, 0x1df35be0, 0x1834132e,
+    0x62128301, 0x48835b8e, 0xf57fb0ad, 0xf2e91e43, 0x4a48d367, 0x10d8ddaa,
+    0x425faece, 0x616aa428, 0x0ab499d3, 0xf2a6067f, 0x775c83c2, 0xa3883c61,
+    0x78738a5a, 0x8cafbdd7, 0x6f63a62d, 0xcbbff4ef, 0x818d67c1, 0x2645ca55,
+    0x36d9cad2, 0xa8288d61, 0xc277c912, 0x1426049b, 0x4612c459, 0xc444c5c8,
+    0x91b24df3, 0x1700ad43, 0xd4e54929, 0x10d5fdfc, 0xbe00cc94, 0x1eeece70,
+    0xf53e1380, 0xf1ecc3e7, 0xb328f8c7, 0x9405933e, 0x71c1b309, 0x2ef3450b,
+    0x9c12887b, 0x20ab9fb5, 0x2ec29247, 0x2f327b6d, 0x550c90a7, 0x721fe76b,
+    0x96cb314a, 0x1679e279, 0x4189dff4, 0x9794e884, 0xe6e29731, 0x996bed88,
+    0x365f5f0e, 0xfdbbb49a, 0x486ca467, 0x42727132, 0x5d8db815, 0x9f09e5bc,
+    0x25318d39, 0x74f71c05, 0x30010c0d, 0x68084b58, 0xee2c90aa, 0x4702e774,
+    0x24d6bda6, 0x7df77248, 0x6eef169f, 0xa6948ef6, 0x91b45153, 0xd1f20acf,
+    0x3398207e, 0x4bf56863, 0xb25f3edd, 0x035d407f, 0x89852952, 0x55c06437,
+    0x10d86d32, 0x4832754c, 0x5bd4714e, 0x6e5445c1, 0x090b69f5, 0x2ad56614,
+    0x9d072750, 0x045ddb3b, 0xb4c576ea, 0x17f9877d, 0x6b49ba27, 0x1d296996,
+    0xacccc654, 0x14ad6ae2, 0x9089d988, 0x50722cbe, 0xa4049407, 0x777030f3,
+    0x27fc00a8, 0x71ea49c2, 0x663de064, 0x83dd9797, 0x3fa3fd94, 0x438c860d,
+    0xde41319d, 0x39928c70, 0xdde7b717, 0x3bdf082b, 0x3715a080, 0x5c93805a,
+    0x921110d8, 0xe80faf80, 0x6c4bffdb, 0x0f903876, 0x185915a5, 0x62bbcb61,
+    0xb989c7bd, 0x401004f2, 0xd2277549, 0xf6b6ebbb, 0x22dbaa14, 0x0a2f2689,
+    0x76836433, 0x3b091a94, 0x0eaa3a51, 0xc2a31dae, 0xedaf1226, 0x5c4dc26d,
+    0x9c7a2d97, 0x56c0833f, 0x03f6f009, 0x8c402b99, 0x316d07b4, 0x3915200c,
+    0x5bc3d8c4, 0x92f54bad, 0xc6a5ca4e, 0xcd37a736, 0xa9e69492, 0xab6842dd,
+    0xde6319ef, 0x8c76528b, 0x6837dbfc, 0xaba1ae31, 0x15dfa1ae, 0x00dafb0c,
+    0x664d64b7, 0x05ed3065, 0x29bf5657, 0x3aff47b9, 0xf96af3be, 0x75df9328,
+    0x3080abf6, 0x8c6615cb, 0x040622fa, 0x1de4d9a4, 0xb33d8f1b, 0x5709cd36,
+    0xe9424ea4, 0xbe13b523, 0x331aaaf0, 0xa8654fa5, 0xc1d20f3f, 0x0bcd785b,
+    0x76f92304, 0x8b7b7217, 0x8953a6c6, 0xe26e6f00, 0xebef584a, 0x9bb7dac4,
+    0xba66aacf, 0xcf761d02, 0xd12df1b1, 0xc1998c77, 0xadc3da48, 0x86a05df7,
+    0xf480c62f, 0xf0ac9aec, 0xddbc5c3f, 0x6dded01f, 0xc790b6db, 0x2a3a25a3,
+    0x9aaf0093, 0x53ad0457, 0xb6b42d29, 0x7e804ba7, 0x07da0eaa, 0x76a1597b,
+    0x2a12162d, 0xb7dcfde5, 0xfafedb89, 0xfdbe896c, 0x76e4fca9, 0x0670803e,
+    0x156e85ff, 0x87fd073e, 0x28336761, 0x86182aea, 0xbd4dafe7, 0xb36e6d8f,
+    0x3967955b, 0xbf3148d7, 0x8416df30, 0x432dc735, 0x6125ce70, 0xc9b8cb30,
+    0xfd6cbfa2, 0x00a4e46c, 0x05a0dd5a, 0x476f21d2, 0x1262845c, 0xb9496170,
+    0xe0566b01, 0x52993755, 0x50b7d51e, 0xc4f1335f, 0x6e13e430, 0x5da92e85,
+    0xc3b21d36, 0x32a1a4b7, 0x08d4b1ea, 0x21f716e4, 0x698f77ff, 0x2780030c,
+    0x2d408da0, 0xcd4f99a5, 0x20d3a2b3, 0x0a5d2f42, 0xf9b4cbda, 0x11d0be7d,
+    0xc1db9bbd, 0x17ab81a2, 0xca5c6a08, 0x17552e55, 0x0027f014, 0x7f8607e1,
+    0x640b148d, 0x4196debe, 0x872afdda, 0xb6256b34, 0x897bfef3, 0x059ebfb9,
+    0x4f6a68a8, 0x2a4a5ac4, 0x4fbcf82d, 0x985ad795, 0xc7f48d4d, 0x0da63a20,
+    0x5f57a4b1, 0x3f149538, 0x800120cc, 0x86dd71b6, 0xdec9f560, 0xbf11654d,
+    0x6b0701ac, 0xb08cd0c0, 0xb2485551, 0x0efb1ec3, 0x72953b06, 0xa33540c0,
+    0x7bdc06cc, 0x45e0fa29, 0x4ec8cad6, 0x41f3e8de, 0x647cd864, 0x9b31bed9,
+    0xc397a4d4, 0x5877c5e3, 0x6913daf0, 0x3c3aba46, 0x18465f75, 0x55f5bdd2,
+    0xc6926e5d, 0x2eaced44, 0x0e423e1c, 0x87c461e9, 0xfd29f3d6, 0xe7ca7c22,
+    0x35916fc5, 0xe0088dd7, 0xffe26a6e, 0xc6fdb0c1, 0x0893745d, 0x7cb2ad6b,
+    0x9d6ecd7b, 0x723e6a11, 0xc6a9cff7, 0xdf7329ba, 0xc9b55100, 0xb70db2e2,
+    0x24ba7460, 0x7de58ad8, 0x742c150d, 0x0c188194, 0x667e1629, 0x01767a9f,
+    0xbefdfdef, 0x4556367e, 0xd913d9ec, 0xb9ba8bfc, 0x97c427a8, 0x31c36ef1,
+    0x36c59456, 0xa8d8b5a8, 0xb40ecccf, 0x2d891234, 0x576f8956, 0x2ce3ce99,
+    0xb920d6aa, 0x5e6b9c2a, 0x3ecc5f11, 0x4a0bfdfb, 0xf4e16d3b, 0x8e2c86e2,
+    0x84d4e9a9, 0xb4fcd1ee, 0xefc9352e, 0x61392f44, 0x2138c8d9, 0x1b0afc81,
+    0x6a4afbd8, 0x1c2f84b4, 0x538c994e, 0xcc2254dc, 0x552ad6c6, 0xc096190b,
+    0xb8701a64, 0x9569605a, 0x26ee523f, 0x0f117f11, 0xb5f4f5cb, 0xfc2dbc34,
+    0xeebc34cc, 0x5de8605e, 0xdd9b8e67, 0xef3392b8, 0x17c99b58, 0x61bc57e1,
+    0xc6835110, 0x3ed84871, 0xdddd1c2d, 0xa118af46, 0x2c21d7f3, 0x59987ad9,
+    0xc0549efa, 0x864ffc06, 0x56ae79e5, 0x36228922, 0xad38dc93, 0x67aae855,
+    0x3826829b, 0xe7caa40d, 0x51b13399, 0x0ed7a948, 0x0569f0b2, 0x65a7887f,
+    0x974c8836, 0xd1f9b392, 0x214a827b, 0x21cf98dc, 0x9f405547, 0xdc3a74e1,
+    0x42eb67df, 0x9dfe5fd4, 0x5ea4677b, 0x7aacbaa2, 0xf6552388, 0x2b55ba41,
+    0x086e5986, 0x2a218347, 0x39e6e389, 0xd49ee540, 0xfb49e956, 0xffca0f1c,
+    0x8a59c52b, 0xfa94c5c1, 0xd3cfc50f, 0xae5adb86, 0xc5476243, 0x853b8621,
+    0x94792c87, 0x61107b4c, 0x2a1a2c80, 0x12bf4390, 0x2688893c, 0x78e4c4a8,
+    0x7bdbe5c2, 0x3ac4eaf4, 0x268a67f7, 0xbf920d2b, 0xa365b193, 0x3d0b7cbd,
+    0xdc51a463, 0xdd27dde1, 0x6919949a, 0x9529a828, 0xce68b4ed, 0x09209f44,
+    0xca984e63, 0x8270237c, 0x7e32b90f, 0x8ef5a7e7, 0x561408f1, 0x212a9db5,
+    0x4d7e6f51, 0x19a5abf9, 0xb5d6df82, 0x61dd9602, 0x36169f3a, 0xc4a1a283,
+    0x6ded727a, 0x8d39a9b8, 0x825c326b, 0x5b2746ed, 0x34007700, 0xd255f4fc,
+    0x4d590180, 0x71e0e13f, 0x89b295f3,
+};
+
+#define RED_PIO2_1 1.5707963267923332750797271728515625L // 36 bits
+#define RED_PIO2_2 2.5633441515839557891219546714722810065723024308681488037109375e-12L // 36 bits
+#define RED_PIO2_3 1.0562999066987427112418680980608056604e-23L
+#define RED_PIO2_HI 1.5707963267948966191479842624545426588156260550022125244140625L
+#define RED_PIO2_LO 8.3337429185208783282958644685340386073e-20L
+#define RED_CODY_WAITE_MAX 0x1p28L
+
+// 32 bits of 2/pi starting at bit b (bit 0 is the first after the point)
+static uint32_t twoOverPiBits(long long b)
 {
-    return Ln(x) / LN10;
+    long long w = b >= 0 ? b / 32 : -((-b + 31) / 32);
+    int sh = (int)(b - 32 * w);
+    uint64_t hi = (w >= 0 && w < 519) ? twoOverPi[w] : 0;
+    uint64_t lo = (w + 1 >= 0 && w + 1 < 519) ? twoOverPi[w + 1] : 0;
+    return (uint32_t)((((hi << 32) | lo) << sh) >> 32);
 }
 
-long double Lg(long double x)
+// x >= 1 as m * 2^e with m a 64-bit integer
+static uint64_t splitMantissa(long double x, int *e)
 {
-    return Ln(x) / LN2;
+    long double f = splitExponent(x, e);
+    *e -= 63;
+    return (uint64_t)(f * 0x1p63L);
 }
 
-long double Sine(long double x)
+// Payne-Hanek: x * 2/pi using only the 256 bits of 2/pi that can change
+// the result mod 4, in fixed-point integer arithmetic.
+static int reducePayneHanek(long double x, long double *r)
 {
-    if (x == HRD_INFINITE || x == -HRD_INFINITE)
-        return HRD_NOT_A_NUM;
-    while (x > HRD_PI || x < -HRD_PI)
+    int e;
+    uint64_t m = splitMantissa(x, &e);
+    // bits of 2/pi before index e-2 only add multiples of 4 to x*2/pi
+    long long first = (long long)e - 2;
+    uint32_t w[8], a[2] = {(uint32_t)m, (uint32_t)(m >> 32)}, p[10] = {0};
+    for (int j = 0; j < 8; j++)
+        w[j] = twoOverPiBits(first + 32 * (7 - j));
+    for (int i = 0; i < 2; i++)
     {
-        x += x > HRD_PI ? -2 * HRD_PI : 2 * HRD_PI;
+        uint64_t carry = 0;
+        for (int j = 0; j < 8; j++)
+        {
+            uint64_t t = (uint64_t)a[i] * w[j] + p[i + j] + carry;
+            p[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        p[i + 8] = (uint32_t)carry;
     }
-    if (x < 0)
+
+    // the binary point sits below bit 254 of the product
+    int q = (p[7] >> 30) & 3;
+    uint64_t fhi = ((uint64_t)(p[7] & 0x3fffffff) << 34) | ((uint64_t)p[6] << 2) | (p[5] >> 30);
+    uint64_t flo = ((uint64_t)(p[5] & 0x3fffffff) << 34) | ((uint64_t)p[4] << 2) | (p[3] >> 30);
+    long double sign = 1;
+    if (fhi >> 63)
     {
-        x = -x;
-        return -Sine(x);
+        // fraction >= 1/2: round q up and take 1 - fraction in integers, where it is exact
+        q++;
+        sign = -1;
+        fhi = ~fhi;
+        flo = ~flo + 1;
+        if (flo == 0)
+            fhi++;
     }
-    if (x == HRD_PI)
-        return 0;
-    long double temp = x;
-    long double term = x;
-    double i = 1.;
+    long double f = sign * (fhi * 0x1p-64L + flo * 0x1p-128L);
+    *r = f * RED_PIO2_HI + f * RED_PIO2_LO;
+    return q & 3;
+}
 
-    while (hrd_abs(term) > HRD_PCS)
+// x = q * pi/2 + r with |r| <= pi/4 (up to rounding); returns q mod 4.
+// Cody-Waite with a three-part pi/2 while q fits in 28 bits, Payne-Hanek beyond.
+static int reduceHalfPi(long double x, long double *r)
+{
+    long double ax = ABS(x);
+    if (!(ax > MY_PI_BY_4)) // NaN included
+    {
+        *r = x;
+        return 0;
+    }
+    if (ax < RED_CODY_WAITE_MAX)
     {
-        term *= -1 * x * x / ((2 * i) * (2 * i + 1));
-        temp += term;
-        i++;
+        long long q = (long long)(x * (2 * INV_PI) + (x < 0 ? -0.5L : 0.5L));
+        *r = ((x - q * RED_PIO2_1) - q * RED_PIO2_2) - q * RED_PIO2_3;
+        return (int)(q & 3);
     }
+    int q = reducePayneHanek(ax, r);
+    if (x < 0)
+    {
+        *r = -*r;
+        q = -q;
+    }
+    return q & 3;
+}
 
-    return temp;
+// Taylor coefficients, fixed length: the last term is below 2^-64 on |r| <= pi/4
+static const long double sinCoeffs[10] = {
+    -1.0L / 6, 1.0L / 120, -1.0L / 5040, 1.0L / 362880, -1.0L / 39916800,
+    1.0L / 6227020800, -1.0L / 1307674368000, 1.0L / 355687428096000,
+    -1.0L / 121645100408832000, 1.0L / 51090942171709440000.0L};
+static const long double cosCoeffs[10] = {
+    -1.0L / 2, 1.0L / 24, -1.0L / 720, 1.0L / 40320, -1.0L / 3628800,
+    1.0L / 479001600, -1.0L / 87178291200, 1.0L / 20922789888000,
+    -1.0L / 6402373705728000, 1.0L / 2432902008176640000};
+
+static long double sinKernel(long double r)
+{
+    long double z = r * r;
+    long double p = sinCoeffs[9];
+    for (int i = 8; i >= 0; i--)
+        p = p * z + sinCoeffs[i];
+    return r + r * z * p;
 }
 
-long double Cosine(long double x)
+static long double cosKernel(long double r)
 {
-    if (x == HRD_INFINITE || x == -HRD_INFINITE)
-        return HRD_NOT_A_NUM;
-    while (x > HRD_PI || x < -HRD_PI)
+    long double z = r * r;
+    long double p = cosCoeffs[9];
+    for (int i = 8; i >= 0; i--)
+        p = p * z + cosCoeffs[i];
+    return 1 + z * p;
+}
+
+void SinCos(long double x, long double *s, long double *c)
+{
+    if (!(x == x) || x == HRD_INFINITE || x == -HRD_INFINITE)
     {
-        x += x > HRD_PI ? -2 * HRD_PI : 2 * HRD_PI;
+        *s = *c = HRD_NOT_A_NUM;
+        return;
     }
-    if (x < 0)
+    long double r;
+    int q = reduceHalfPi(x, &r);
+    long double sr = sinKernel(r), cr = cosKernel(r);
+    switch (q)
     {
-        x = -x;
-        return Cosine(x);
+    case 0:
+        *s = sr;
+        *c = cr;
+        break;
+    case 1:
+        *s = cr;
+        *c = -sr;
+        break;
+    case 2:
+        *s = -sr;
+        *c = -cr;
+        break;
+    default:
+        *s = -cr;
+        *c = sr;
+        break;
     }
-    if (x == HRD_PI / 2)
-        return 0;
-    long double temp = 1.0;
-    long double term = 1.0;
-    double i = 1.;
+}
 
-    while (hrd_abs(term) > HRD_PCS)
+long double Sine(long double x)
+{
+    if (x == HRD_INFINITE || x == -HRD_INFINITE)
+        return HRD_NOT_A_NUM;
+    if (x == HRD_PI || x == -HRD_PI)
+        return 0;
+    if (x == 0)
+        return x; // keeps the sign of -0
+    long double r;
+    int q = reduceHalfPi(x, &r);
+    switch (q)
     {
-        term *= -1 * x * x / ((2 * i - 1) * (2 * i));
-        temp += term;
-        i++;
+    case 0:
+        return sinKernel(r);
+    case 1:
+        return cosKernel(r);
+    case 2:
+        return -sinKernel(r);
+    default:
+        return -cosKernel(r);
     }
+}
 
-    return temp;
+long double Cosine(long double x)
+{
+    if (x == HRD_INFINITE || x == -HRD_INFINITE)
+        return HRD_NOT_A_NUM;
+    if (x == HRD_PI / 2 || x == -HRD_PI / 2)
+        return 0;
+    long double r;
+    int q = reduceHalfPi(x, &r);
+    switch (q)
+    {
+    case 0:
+        return cosKernel(r);
+    case 1:
+        return -sinKernel(r);
+    case 2:
+        return -cosKernel(r);
+    default:
+        return sinKernel(r);
+    }
 }
 
 long double Tangent(long double x)
@@ -321,133 +921,271 @@ long double Tangent(long double x)
     {
         return HRD_INFINITE;
     }
-    return Sine(x) / Cosine(x);
+    if (x == 0)
+        return x;
+    long double r;
+    int q = reduceHalfPi(x, &r);
+    if (q & 1)
+        return -cosKernel(r) / sinKernel(r);
+    return sinKernel(r) / cosKernel(r);
 }
 
 long double Cosecant(long double x)
 {
     if (x == HRD_INFINITE || x == -HRD_INFINITE)
         return HRD_NOT_A_NUM;
-    if (Sine(x) == 0)
+    long double s = Sine(x);
+    if (s == 0)
     {
         return HRD_INFINITE;
     }
-    return 1 / Sine(x);
+    return 1 / s;
 }
 
 long double Secant(long double x)
 {
     if (x == HRD_INFINITE || x == -HRD_INFINITE)
         return HRD_NOT_A_NUM;
-    if (Cosine(x) == 0)
+    long double c = Cosine(x);
+    if (c == 0)
     {
         return HRD_INFINITE;
     }
-    return 1 / Cosine(x);
+    return 1 / c;
 }
 
 long double Cotangent(long double x)
 {
     if (x == HRD_INFINITE || x == -HRD_INFINITE)
         return HRD_NOT_A_NUM;
-    if (Sine(x) == 0)
+    long double s, c;
+    SinCos(x, &s, &c);
+    if (s == 0)
     {
         return HRD_INFINITE;
     }
-    return 1 / Tangent(x);
+    return c / s;
 }
 
-long double arcTangent(long double x)
+// atan(a) for a in [0, 1]: a table of atan(j/64) and the difference
+// atan(a) - atan(c) = atan((a - c)/(1 + a c)), |t| <= 1/128, so the odd
+// Taylor series stops at t^9 (the next term is below 2^-70 relative)
+#define ATAN_TABLE_SIZE 65
+static const long double atanC[ATAN_TABLE_SIZE] = {
+    0.0L, 1.5623728620476830802801521e-2L, 3.1239833430268276253711745e-2L,
+    4.6840712915969653752223760e-2L, 6.2418809995957348473979113e-2L, 7.7966633831542306563328649e-2L,
+    9.3476781158589463504527193e-2L, 1.0894195698986579984186086e-1L, 1.2435499454676143503135485e-1L,
+    1.3970887428916364518336778e-1L, 1.5499674192394098230371437e-1L, 1.7021192528547440449049661e-1L,
+    1.8534794999569476488602596e-1L, 2.0039855382587851465394579e-1L, 2.1535769969773804802445963e-1L,
+    2.3021958727684373024017096e-1L, 2.4497866312686415417208248e-1L, 2.5962962940825753102994644e-1L,
+    2.7416745111965879759937190e-1L, 2.8858736189407739562361142e-1L, 3.0288486837497140556055609e-1L,
+    3.1705575320914700980901558e-1L, 3.3109607670413209494433879e-1L, 3.4500217720710510886768129e-1L,
+    3.5877067027057222039592006e-1L, 3.7239844667675422192365504e-1L, 3.8588266939807377589769548e-1L,
+    3.9922076957525256561471670e-1L, 4.1241044159738730689979129e-1L, 4.2544963737004228954226361e-1L,
+    4.3833655985795780544561605e-1L, 4.5106965598852347637563926e-1L, 4.6364760900080611621425623e-1L,
+    4.7606933032276123407510042e-1L, 4.8833395105640552386716496e-1L, 5.0044081314729411403000051e-1L,
+    5.1238946031073770666660102e-1L, 5.2417962878291324832164962e-1L, 5.3581123796046370026908507e-1L,
+    5.4728438098743697398522077e-1L, 5.5859931534356243597150822e-1L, 5.6975645348297844332383489e-1L,
+    5.8075635356767039920327448e-1L, 5.9159971033511143314585266e-1L, 6.0228734613496418168212269e-1L,
+    6.1282020216524132514338464e-1L, 6.2319932993406593099247535e-1L, 6.3342588296914456626869548e-1L,
+    6.4350110879328438680280923e-1L, 6.5342634118076196286389341e-1L, 6.6320299270609325536325431e-1L,
+    6.7283254759376318931140133e-1L, 6.8231655487474807825642998e-1L, 6.9165662185319986298006632e-1L,
+    7.0085440788445017245795128e-1L, 7.0991161846352486119161115e-1L, 7.1882999962162450541701415e-1L,
+    7.2761133262651067878295269e-1L, 7.3625742898142813174283527e-1L, 7.4477012571607518576393109e-1L,
+    7.5315128096219438952473937e-1L, 7.6140276980557842642318554e-1L, 7.6952648040565826040682004e-1L,
+    7.7752431037334776672493082e-1L, 7.8539816339744830961566085e-1L};
+static const long double atanCoeffs[4] = {
+    -1.0L / 3, 1.0L / 5, -1.0L / 7, 1.0L / 9};
+#define ATAN_PI_HI (2 * RED_PIO2_HI)
+#define ATAN_PI_LO (2 * RED_PIO2_LO)
+
+static long double atanKernel(long double a)
 {
-    if (x == HRD_INFINITE)
-        return MY_PI_BY_2;
-    if (x == -HRD_INFINITE)
-        return -MY_PI_BY_2;
-    if (x == 0)
-        return 0;
-    if (x == 1)
-        return MY_PI_BY_4;
-    if (x == -1)
-        return -MY_PI_BY_4;
-    if (x > 0.9 && x < 1.1)  
-        return MY_PI_BY_4 - arcTangent((1 - x) / (1 + x));
+    int j = (int)(a * 64 + 0.5L);
+    long double c = j * (1.0L / 64);
+    long double t = (a - c) / (1 + a * c);
+    long double z = t * t;
+    long double p = atanCoeffs[0] + z * (atanCoeffs[1] + z * (atanCoeffs[2] + z * atanCoeffs[3]));
+    return atanC[j] + (t + t * z * p);
+}
 
-    if (x > 1)
-        return MY_PI_BY_2 - arcTangent(1 / x);
-    if (x < -1)
-        return -MY_PI_BY_2 - arcTangent(1 / x);
+// sign of x, including the sign of zero
+static int isNegative(long double x)
+{
+    return x < 0 || (x == 0 && 1 / x < 0);
+}
 
-    long double temp = x;
-    long double term = x;
-    double i = 1.;
+long double arcTangent(long double x)
+{
+    if (!(x == x))
+        return x;
+    long double ax = ABS(x), y;
+    if (ax <= 1)
+        y = atanKernel(ax);
+    else if (ax == HRD_INFINITE)
+        y = MY_PI_BY_2;
+    else
+        y = RED_PIO2_HI - (atanKernel(1 / ax) - RED_PIO2_LO);
+    return x < 0 ? -y : y;
+}
 
-    while (hrd_abs(term) > HRD_PCS)
+// the angle of (x, y) in [-pi, pi]: the smaller of |y|/|x| and |x|/|y| goes
+// through the kernel, then the quadrant follows the signs (C99 atan2 rules
+// for zeros and infinities)
+long double arcTangent2(long double y, long double x)
+{
+    if (!(x == x) || !(y == y))
+        return x + y;
+    long double ax = ABS(x), ay = ABS(y), a;
+    if (ay == 0)
+        return isNegative(x) ? (isNegative(y) ? -PI : PI) : y;
+    if (ax == HRD_INFINITE || ay == HRD_INFINITE)
     {
-        term *= -1 * x * x * (2 * i - 1) / (2 * i + 1);
-        temp += term;
-        i++;
+        if (ax != HRD_INFINITE)
+            a = MY_PI_BY_2;
+        else if (ay != HRD_INFINITE)
+            a = isNegative(x) ? PI : 0;
+        else
+            a = isNegative(x) ? 3 * MY_PI_BY_4 : MY_PI_BY_4;
+        return y < 0 ? -a : a;
     }
-
-    return temp;
+    // pi - a and pi/2 + a are each formed in one step, with the low part
+    // of pi or pi/2 added last
+    if (ay <= ax)
+    {
+        a = atanKernel(ay / ax);
+        if (isNegative(x))
+            a = ATAN_PI_HI - (a - ATAN_PI_LO);
+    }
+    else
+    {
+        a = atanKernel(ax / ay);
+        a = isNegative(x) ? RED_PIO2_HI + (a + RED_PIO2_LO) : RED_PIO2_HI - (a - RED_PIO2_LO);
+    }
+    return y < 0 ? -a : a;
 }
 
-
+// sqrt((1 - x)(1 + x)) keeps full precision near |x| = 1, where 1 - x*x cancels
 long double arcSine(long double x)
 {
-    if (x < -1 || x > 1)
-    {
+    if (!(ABS(x) <= 1))
         return HRD_NOT_A_NUM;
-    }
-    if (x < 0)
-    {
-        return -arcSine(-x);
-    };
-    return arcTangent(x / Sqrt(1 - x * x));
+    return arcTangent2(x, Sqrt((1 - x) * (1 + x)));
 }
 
 long double arcCosine(long double x)
 {
-    if (x < -1 || x > 1)
-    {
+    if (!(ABS(x) <= 1))
         return HRD_NOT_A_NUM;
-    }
-    ABS(x);
-    return arcTangent(Sqrt(1 - (x * x)) / x);
+    return arcTangent2(Sqrt((1 - x) * (1 + x)), x);
+}
+
+// sqrt(x^2 - 1) for |x| >= 1; past 2^32 it rounds to |x|
+static long double secantLeg(long double ax)
+{
+    return ax > 0x1p32L ? ax : Sqrt((ax - 1) * (ax + 1));
 }
 
 long double arcCosecant(long double x)
 {
-    if (-1 > x || x < 1)
-    {
-        return myNaN();
-    }
-    return arcTangent(1 / Sqrt((x * x) - 1));
+    if (!(ABS(x) >= 1))
+        return HRD_NOT_A_NUM;
+    return arcTangent2(x < 0 ? -1 : 1, secantLeg(ABS(x)));
 }
 
 long double arcSecant(long double x)
 {
-    if (x < -1 || x < 1)
+    if (!(ABS(x) >= 1))
+        return HRD_NOT_A_NUM;
+    return arcTangent2(secantLeg(ABS(x)), x < 0 ? -1 : 1);
+}
+
+// atan(1/x), odd like the quotient; small |x| goes through pi/2 - atan|x| so
+// 1/x never rounds
+long double arcCotangent(long double x)
+{
+    if (!(x == x))
+        return x;
+    long double ax = ABS(x);
+    long double y = ax >= 1 ? atanKernel(1 / ax) : RED_PIO2_HI - (atanKernel(ax) - RED_PIO2_LO);
+    return isNegative(x) ? -y : y;
+}
+
+// beyond this e^-2|x| is below 2^-66 and tanh rounds to +-1
+#define TANH_SAT 23.0L
+// e^|x| overflows past here while sinh and cosh are still finite
+#define HYP_EXP_MAX (LN2 * (LDBL_MAX_EXP - 1))
+
+// sinh and cosh of ax >= 0 from one exponential: e^-x is its reciprocal,
+// and below ln2/2 e^x - 1 keeps sinh (and cosh - 1) free of cancellation
+static void sinhCoshKernel(long double ax, long double *s, long double *c)
+{
+    if (ax <= EXPM1_POLY_MAX)
     {
-        return myNaN();
+        long double em = expm1Poly(ax);
+        long double d = em / (em + 1); // 1 - e^-x
+        *s = 0.5L * (em + d);
+        *c = 1 + 0.5L * em * d;
+    }
+    else if (ax <= HYP_EXP_MAX)
+    {
+        long double e = Exp(ax);
+        long double inv = 1 / e;
+        *s = 0.5L * (e - inv);
+        *c = 0.5L * (e + inv);
+    }
+    else
+    {
+        long double h = Exp(0.5L * ax);
+        *s = *c = (0.5L * h) * h;
     }
-    return arcTangent(Sqrt((x * x) - 1));
 }
 
-long double arcCotangent(long double x) { return arcTangent(1 / x); }
+void SinhCosh(long double x, long double *s, long double *c)
+{
+    if (!(x == x))
+    {
+        *s = *c = x;
+        return;
+    }
+    sinhCoshKernel(ABS(x), s, c);
+    if (x < 0)
+        *s = -*s;
+}
 
 long double Sinh(long double x)
 {
-    return (Exp(x) - Exp(-x)) / 2;
+    long double s, c;
+    SinhCosh(x, &s, &c);
+    return s;
 }
 
 long double Cosh(long double x)
 {
-    return (Exp(x) + Exp(-x)) / 2;
+    long double s, c;
+    SinhCosh(x, &s, &c);
+    return c;
 }
 
+// tanh = (e^2x - 1) / (e^2x + 1) from a single exponential
 long double Tanh(long double x)
 {
-    return Sinh(x) / Cosh(x);
+    if (!(x == x))
+        return x;
+    long double ax = ABS(x), y;
+    if (ax > TANH_SAT)
+        y = 1;
+    else if (2 * ax <= EXPM1_POLY_MAX)
+    {
+        long double t = expm1Poly(2 * ax);
+        y = t / (t + 2);
+    }
+    else
+    {
+        long double e = Exp(2 * ax);
+        y = (e - 1) / (e + 1);
+    }
+    return x < 0 ? -y : y;
 }
 
 long double Csch(long double x)
@@ -469,29 +1207,57 @@ long double Coth(long double x)
     return 1 / Tanh(x);
 }
 
+// ln(1 + x) for x >= 0: u - 1 is the part of x that survived 1 + x, and
+// x / (u - 1) puts the rest back
+static long double lnOnePlus(long double x)
+{
+    long double u = 1 + x;
+    if (u == 1)
+        return x;
+    if (u == HRD_INFINITE)
+        return u;
+    return Ln(u) * (x / (u - 1));
+}
+
+// the forms of the double tier: ln1p of x + x^2 / (1 + sqrt(x^2 + 1)) with
+// no cancellation near 0, and ln 2x once x^2 + 1 rounds to x^2
 long double arcSinh(long double x)
 {
-    if (x == HRD_INFINITE)
-        return HRD_INFINITE;
-    if (x == -HRD_INFINITE)
-        return -HRD_INFINITE;
-    if (!(x == x))
-        return HRD_NOT_A_NUM;
-    return Ln(x + Sqrt(x * x + 1));
+    if (!(x == x) || x == 0 || x == HRD_INFINITE || x == -HRD_INFINITE)
+        return x;
+    long double ax = ABS(x), y;
+    if (ax > 0x1p32L)
+        y = Ln(ax) + LN2;
+    else if (ax > 2)
+        y = Ln(ax + Sqrt(ax * ax + 1));
+    else
+        y = lnOnePlus(ax + ax * ax / (1 + Sqrt(ax * ax + 1)));
+    return x < 0 ? -y : y;
 }
 
+// ln1p(t + sqrt(2t + t^2)) with t = x - 1 exact near 1
 long double arcCosh(long double x)
 {
-    if (x < 1)
+    if (!(x >= 1))
         return HRD_NOT_A_NUM;
-    return Ln(x + Sqrt(x * x - 1));
+    if (x > 0x1p32L)
+        return Ln(x) + LN2;
+    if (x > 2)
+        return Ln(x + Sqrt(x * x - 1));
+    long double t = x - 1;
+    return lnOnePlus(t + Sqrt(2 * t + t * t));
 }
 
+// ln1p(2|x| / (1 - |x|)) / 2, 1 - |x| exact near 1
 long double arcTanh(long double x)
 {
-    if (x >= 1 || x <= -1)
+    if (!(x < 1 && x > -1))
         return HRD_NOT_A_NUM;
-    return 0.5 * Ln((1 + x) / (1 - x));
+    if (x == 0)
+        return x;
+    long double ax = ABS(x);
+    long double y = 0.5L * lnOnePlus(2 * ax / (1 - ax));
+    return x < 0 ? -y : y;
 }
 
 long double arcCsch(long double x)
@@ -501,16 +1267,26 @@ long double arcCsch(long double x)
     return arcSinh(1 / x);
 }
 
+// ln1p((1 - x)/x + sqrt((1 - x)(1 + x))/x): 1 - x is exact for x >= 1/2,
+// where 1/x would round the answer away
 long double arcSech(long double x)
 {
-    if (x <= 0 || x > 1)
+    if (x == 0)
+        return HRD_INFINITE;
+    if (!(x > 0 && x <= 1))
         return HRD_NOT_A_NUM;
-    return arcCosh(1 / x);
+    if (x < 0x1p-32L)
+        return LN2 - Ln(x);
+    long double d = 1 - x;
+    return lnOnePlus(d / x + Sqrt(d * (1 + x)) / x);
 }
 
+// ln1p(2 / (|x| - 1)) / 2, with |x| - 1 exact near 1
 long double arcCoth(long double x)
 {
-    if (x == 0)
+    long double ax = x < 0 ? -x : x;
+    if (!(ax >= 1))
         return HRD_NOT_A_NUM;
-    return arcTanh(1 / x);
+    long double y = ax == 1 ? HRD_INFINITE : 0.5L * lnOnePlus(2 / (ax - 1));
+    return x < 0 ? -y : y;
 }
\ No newline at end of file
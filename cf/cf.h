@@ -53,9 +53,11 @@ long double myNaN();
 long double minusInf();
 long double plusInf();
 
+// x^n for an integer n, and C99 pow(x, y) for a real exponent
 long double iPower(long double x, long long n);
-long double rPower(long double x, long long n);
+long double rPower(long double x, long double y);
 long double Sqrt(long double x);
+long double RSqrt(long double x); // 1 / Sqrt(x)
 
 long double Exp(long double x);
 
@@ -74,6 +76,9 @@ long double Cosecant(long double x);
 long double Secant(long double x);
 long double Cotangent(long double x);
 
+// sine and cosine of x from a single argument reduction
+void SinCos(long double x, long double *s, long double *c);
+
 // inverse trignometric functions
 long double arcTangent(long double x);
 long double arcSine(long double x);
@@ -82,6 +87,9 @@ long double arcCosecant(long double x);
 long double arcSecant(long double x);
 long double arcCotangent(long double x);
 
+// angle of the point (x, y), in [-pi, pi]
+long double arcTangent2(long double y, long double x);
+
 // hyperbolic functions
 long double Sinh(long double x);
 long double Cosh(long double x);
@@ -90,6 +98,9 @@ long double Csch(long double x);
 long double Sech(long double x);
 long double Coth(long double x);
 
+// sinh and cosh of x from a single exponential
+void SinhCosh(long double x, long double *s, long double *c);
+
 // inverse hyperbolic functions
 long double arcSinh(long double x);
 long double arcCosh(long double x);
@@ -98,4 +109,193 @@ long double arcCsch(long double x);
 long double arcSech(long double x);
 long double arcCoth(long double x);
 
+// precision tiers: the same functions computed in float (suffix F) or
+// double (suffix D) instead of long double, with polynomial degrees and
+// tolerances sized for that format. Results are within 4 ULP of the
+// correctly rounded value on their usual domains (most within 2 ULP);
+// trig arguments beyond 2^20 are reduced by the long double code.
+
+float iPowerF(float x, long long n);
+float SqrtF(float x);
+float RSqrtF(float x);
+float ExpF(float x);
+float LnF(float x);
+float LogF(float x);
+float LgF(float x);
+
+float SineF(float x);
+float CosineF(float x);
+float TangentF(float x);
+float CosecantF(float x);
+float SecantF(float x);
+float CotangentF(float x);
+void SinCosF(float x, float *s, float *c);
+
+float arcTangentF(float x);
+float arcSineF(float x);
+float arcCosineF(float x);
+float arcCosecantF(float x);
+float arcSecantF(float x);
+float arcCotangentF(float x);
+float arcTangent2F(float y, float x);
+
+float SinhF(float x);
+float CoshF(float x);
+float TanhF(float x);
+float CschF(float x);
+float SechF(float x);
+float CothF(float x);
+void SinhCoshF(float x, float *s, float *c);
+
+float arcSinhF(float x);
+float arcCoshF(float x);
+float arcTanhF(float x);
+float arcCschF(float x);
+float arcSechF(float x);
+float arcCothF(float x);
+
+double iPowerD(double x, long long n);
+double SqrtD(double x);
+double RSqrtD(double x);
+double ExpD(double x);
+double LnD(double x);
+double LogD(double x);
+double LgD(double x);
+
+double SineD(double x);
+double CosineD(double x);
+double TangentD(double x);
+double CosecantD(double x);
+double SecantD(double x);
+double CotangentD(double x);
+void SinCosD(double x, double *s, double *c);
+
+double arcTangentD(double x);
+double arcSineD(double x);
+double arcCosineD(double x);
+double arcCosecantD(double x);
+double arcSecantD(double x);
+double arcCotangentD(double x);
+double arcTangent2D(double y, double x);
+
+double SinhD(double x);
+double CoshD(double x);
+double TanhD(double x);
+double CschD(double x);
+double SechD(double x);
+double CothD(double x);
+void SinhCoshD(double x, double *s, double *c);
+
+double arcSinhD(double x);
+double arcCoshD(double x);
+double arcTanhD(double x);
+double arcCschD(double x);
+double arcSechD(double x);
+double arcCothD(double x);
+
+// adaptive mode: double results from a fast double kernel that also bounds
+// its own error. Only when the bound cannot guarantee the requested accuracy
+// (setAdaptiveUlp, in ULP of the result; 0.5, correct rounding, by default)
+// is the value recomputed by the long double routine and rounded to double,
+// which can add about 0.001 ULP. adaptiveStats counts calls and fallbacks
+// per function over all threads, so the average cost on real inputs can be
+// read off. On x86 the kernels are also built with FMA, which makes their
+// exact products one instruction; that build is used when the CPU has FMA
+// (setAdaptiveFma(0) selects the plain one, for comparison).
+typedef enum
+{
+    ADAPTIVE_EXP = 0,
+    ADAPTIVE_LN,
+    ADAPTIVE_LOG,
+    ADAPTIVE_LG,
+    ADAPTIVE_SINE,
+    ADAPTIVE_COSINE,
+    ADAPTIVE_COUNT
+} AdaptiveFunction;
+
+typedef struct
+{
+    unsigned long long calls;
+    unsigned long long fallbacks;
+} AdaptiveStats;
+
+double adaptiveUlp();
+double setAdaptiveUlp(double ulp); // raised to at least 0.5; returns the value set
+AdaptiveStats adaptiveStats(AdaptiveFunction f);
+void resetAdaptiveStats();
+const char *adaptiveName(AdaptiveFunction f);
+int adaptiveFma();              // 1 if the FMA build of the kernels is in use
+int setAdaptiveFma(int on);     // limited to what the CPU has; returns the setting in effect
+
+double ExpA(double x);
+double LnA(double x);
+double LogA(double x);
+double LgA(double x);
+double SineA(double x);
+double CosineA(double x);
+
+// batch (array) functions: out[i] = f(in[i]) for i < n, in double precision.
+// in and out may be the same array. Every entry runs vectorized SSE2 / AVX2 /
+// AVX-512 kernels picked from the CPU at first use.
+// They stay within 2 ULP of the correctly rounded result (Tangent, Cotangent,
+// Cosecant, Secant, Csch, Coth, arcCosecant and the inverse hyperbolics
+// 3 ULP), for the circular functions when |x| <= 2^20; larger lanes are
+// handed to the scalar code. SinhCoshBatch fills both s and c from one
+// exponential; arcTangent2Batch takes y and x arrays. iPowerBatch raises
+// every in[i] to the same power p (within 1 ULP); rPowerBatch takes x and y
+// arrays and is vectorized too (within 1 ULP), as e^(y ln x) in
+// double-double, with zeros, infinities, NaN, negative x with a non-integer
+// y and results past the normal range handed to rPower.
+typedef enum
+{
+    BATCH_SCALAR = 0,
+    BATCH_SSE2,
+    BATCH_AVX2,
+    BATCH_AVX512
+} BatchIsa;
+
+BatchIsa batchIsa();
+BatchIsa setBatchIsa(BatchIsa isa); // capped at what the CPU supports
+const char *batchIsaName(BatchIsa isa);
+
+void SqrtBatch(const double *in, double *out, size_t n);
+void RSqrtBatch(const double *in, double *out, size_t n);
+void ExpBatch(const double *in, double *out, size_t n);
+void LnBatch(const double *in, double *out, size_t n);
+void LogBatch(const double *in, double *out, size_t n);
+void LgBatch(const double *in, double *out, size_t n);
+
+void SineBatch(const double *in, double *out, size_t n);
+void CosineBatch(const double *in, double *out, size_t n);
+void TangentBatch(const double *in, double *out, size_t n);
+void CosecantBatch(const double *in, double *out, size_t n);
+void SecantBatch(const double *in, double *out, size_t n);
+void CotangentBatch(const double *in, double *out, size_t n);
+
+void arcTangentBatch(const double *in, double *out, size_t n);
+void arcSineBatch(const double *in, double *out, size_t n);
+void arcCosineBatch(const double *in, double *out, size_t n);
+void arcCosecantBatch(const double *in, double *out, size_t n);
+void arcSecantBatch(const double *in, double *out, size_t n);
+void arcCotangentBatch(const double *in, double *out, size_t n);
+void arcTangent2Batch(const double *y, const double *x, double *out, size_t n);
+
+void iPowerBatch(const double *in, long long p, double *out, size_t n);
+void rPowerBatch(const double *x, const double *y, double *out, size_t n);
+
+void SinhBatch(const double *in, double *out, size_t n);
+void CoshBatch(const double *in, double *out, size_t n);
+void TanhBatch(const double *in, double *out, size_t n);
+void CschBatch(const double *in, double *out, size_t n);
+void SechBatch(const double *in, double *out, size_t n);
+void CothBatch(const double *in, double *out, size_t n);
+void SinhCoshBatch(const double *in, double *s, double *c, size_t n);
+
+void arcSinhBatch(const double *in, double *out, size_t n);
+void arcCoshBatch(const double *in, double *out, size_t n);
+void arcTanhBatch(const double *in, double *out, size_t n);
+void arcCschBatch(const double *in, double *out, size_t n);
+void arcSechBatch(const double *in, double *out, size_t n);
+void arcCothBatch(const double *in, double *out, size_t n);
+
 #endif
\ No newline at end of file
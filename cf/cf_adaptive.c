@@ -0,0 +1,427 @@
+#include "cf.h"
+#include "cf_tables.h"
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+// Adaptive mode of the cf functions. Each one computes its double result
+// as hi + lo in double arithmetic (table-driven, with the leading products
+// and sums kept exact), together with a bound on how far hi + lo can be
+// from the true value. hi is returned when |lo| + bound fits in the
+// requested ULP (Ziv's rounding test); otherwise the long double routine
+// is called and its result rounded to double.
+
+static double tolerance = 0.5;
+
+// shared by all threads: relaxed atomic increments, so concurrent calls are
+// all counted without ordering anything else
+static unsigned long long calls[ADAPTIVE_COUNT];
+static unsigned long long fallbacks[ADAPTIVE_COUNT];
+
+static inline void count(unsigned long long *n)
+{
+    __atomic_fetch_add(n, 1, __ATOMIC_RELAXED);
+}
+
+double adaptiveUlp()
+{
+    return tolerance;
+}
+
+double setAdaptiveUlp(double ulp)
+{
+    // no double result is closer than the final rounding (NaN lands here too)
+    tolerance = ulp > 0.5 ? ulp : 0.5;
+    return tolerance;
+}
+
+AdaptiveStats adaptiveStats(AdaptiveFunction f)
+{
+    AdaptiveStats s = {0, 0};
+    if (f >= 0 && f < ADAPTIVE_COUNT)
+    {
+        s.calls = __atomic_load_n(&calls[f], __ATOMIC_RELAXED);
+        s.fallbacks = __atomic_load_n(&fallbacks[f], __ATOMIC_RELAXED);
+    }
+    return s;
+}
+
+void resetAdaptiveStats()
+{
+    for (int f = 0; f < ADAPTIVE_COUNT; f++)
+    {
+        __atomic_store_n(&calls[f], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&fallbacks[f], 0, __ATOMIC_RELAXED);
+    }
+}
+
+const char *adaptiveName(AdaptiveFunction f)
+{
+    switch (f)
+    {
+    case ADAPTIVE_EXP:
+        return "Exp";
+    case ADAPTIVE_LN:
+        return "Ln";
+    case ADAPTIVE_LOG:
+        return "Log";
+    case ADAPTIVE_LG:
+        return "Lg";
+    case ADAPTIVE_SINE:
+        return "Sine";
+    case ADAPTIVE_COSINE:
+        return "Cosine";
+    default:
+        return "unknown";
+    }
+}
+
+// ---- double-double helpers ----
+
+static inline uint64_t toBits(double x)
+{
+    uint64_t u;
+    memcpy(&u, &x, sizeof u);
+    return u;
+}
+
+static inline double fromBits(uint64_t u)
+{
+    double x;
+    memcpy(&x, &u, sizeof x);
+    return x;
+}
+
+// s + *e == a + b exactly
+static inline double twoSum(double a, double b, double *e)
+{
+    double s = a + b;
+    double bb = s - a;
+    *e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+
+// the unit in the last place of a finite y, subnormals included
+static inline double ulpOf(double y)
+{
+    int e = (int)((toBits(y) >> 52) & 0x7ff);
+    return fromBits(e > 52 ? (uint64_t)(e - 52) << 52 : (uint64_t)1 << (e > 0 ? e - 1 : 0));
+}
+
+// hi is within the requested ULP of the true value when |lo| (what rounding
+// hi + lo to hi dropped) plus the kernel's error bound fits
+static inline int accept(double hi, double lo, double bound)
+{
+    return ABS(lo) + bound <= tolerance * ulpOf(hi);
+}
+
+#define SHIFT 0x1.8p52 // adding it rounds |x| < 2^51 to an integer
+#define SPLITTER 134217729.0 // 2^27 + 1, Dekker's split
+
+// ---- Exp ----
+
+// the results, and their error bounds, are normal numbers in this range
+#define EXP_FAST_MIN -660.0
+#define EXP_FAST_MAX 709.0
+// relative error of hi + lo: a few roundings of 2^-66 in the tail
+#define EXP_EPS 0x1p-62
+
+
+// ---- Ln, Log, Lg ----
+
+// log10 c_i and log2 c_i as hi + lo, on the grid of cf_tables.h
+static const double logHi[LN_TABLE_SIZE] = {
+    -1.52967460208543488e-01, -1.43422142302313094e-01, -1.34082116048169719e-01,
+    -1.24938736608299947e-01, -1.15983893955373507e-01, -1.07209969647868372e-01,
+    -9.86097978859508117e-02, -9.01766303490880161e-02, -8.19041043830981280e-02,
+    -7.37862141609186700e-02, -6.58172844896433296e-02, -5.79919469776867536e-02,
+    -5.03051183113957731e-02, -4.27519804209498880e-02, -3.53279623417429786e-02,
+    -2.80287236002435373e-02, -2.08501389731201373e-02, -1.37882844856332971e-02,
+    -6.83942453030546640e-03, 0.00000000000000000e+00, 6.73338265896840284e-03,
+    1.33639615579815019e-02, 1.98948287169392612e-02, 2.63289387223491489e-02,
+    3.26691167533681437e-02, 3.89180660303696593e-02, 4.50783747351881162e-02,
+    5.11525224473812906e-02, 5.71428861365687324e-02, 6.30517457470890219e-02,
+    6.88812894078128790e-02, 7.46336182969041806e-02, 8.03107511885946951e-02,
+    8.59146287065932351e-02, 9.14471173065542625e-02, 9.69100130080564198e-02,
+    1.02305044894762581e-01, 1.07633878399829519e-01, 1.12898118392186733e-01,
+    1.18099312077994484e-01, 1.23238951730405569e-01, 1.28318477259680541e-01,
+    1.33339278634731356e-01, 1.38302698166281463e-01, 1.43210032661025610e-01,
+    1.48062535455437710e-01, 1.52861418337206428e-01};
+static const double logLo[LN_TABLE_SIZE] = {
+    -4.32966731852888953e-18, -3.51401218478876217e-18, 1.25340248286587348e-17,
+    -6.37042585094220055e-18, -2.75714196366423360e-18, 5.74830908668173562e-18,
+    6.29938925149916854e-18, 4.46577248893575212e-18, 2.36771884564525192e-18,
+    5.84056993501714186e-18, 3.81319971069018093e-18, -1.37857098183211680e-18,
+    6.60821714009408202e-19, -7.51508966435316484e-19, -2.40814242117719820e-18,
+    -1.42868841954030356e-18, -1.43192964283969046e-19, 6.72556792046434943e-19,
+    4.24083948266382844e-19, 0.00000000000000000e+00, -1.33469197534790028e-19,
+    1.05649156421755764e-19, 1.61835619739742380e-18, -1.20797270537308748e-18,
+    1.18962164429832384e-18, 9.37194976161657976e-20, -1.35206931041292728e-18,
+    -1.66679202185511454e-18, -2.59948509762407609e-18, -1.16980317612620117e-18,
+    -3.42584489204563533e-18, 9.23536610443802408e-20, 5.09750402553183950e-18,
+    -4.70838148979161844e-18, -5.80451641182693955e-18, -5.46660342445894596e-18,
+    -3.33358404371022909e-18, -5.49598669910623482e-19, -6.21761980103304990e-19,
+    3.32506284725496920e-18, -6.67457612983203363e-18, 9.14489371010675642e-18,
+    -2.98676904125545886e-18, -7.40171280045049988e-18, 3.19557903122280611e-18,
+    -7.13339544631405954e-18, 2.83473379318464972e-19};
+static const double lgHi[LN_TABLE_SIZE] = {
+    -5.08146903670325334e-01, -4.76438043942987111e-01, -4.45411148322362616e-01,
+    -4.15037499278843813e-01, -3.85290155884791763e-01, -3.56143810225275304e-01,
+    -3.27574658028504384e-01, -2.99560281858907818e-01, -2.72079545436800796e-01,
+    -2.45112497836531468e-01, -2.18640286475340395e-01, -1.92645077942395881e-01,
+    -1.67109985835258323e-01, -1.42019004872427884e-01, -1.17356950638158736e-01,
+    -9.31094043914814651e-02, -6.92626624371137228e-02, -4.58036896131247886e-02,
+    -2.27200765000835289e-02, 0.00000000000000000e+00, 2.23678130284545099e-02,
+    4.43941193584534363e-02, 6.60891904577724371e-02, 8.74628412503394015e-02,
+    1.08524456778169048e-01, 1.29283016944966467e-01, 1.49747119504682058e-01,
+    1.69925001442312373e-01, 1.89824558880017230e-01, 2.09453365628949784e-01,
+    2.28818690495880883e-01, 2.47927513443585490e-01, 2.66786540694901375e-01,
+    2.85402218862248369e-01, 3.03780748177102933e-01, 3.21928094887362348e-01,
+    3.39850002884624747e-01, 3.57552004618083674e-01, 3.75039431346924745e-01,
+    3.92317422778760305e-01, 4.09390936137701777e-01, 4.26264754702097959e-01,
+    4.42943495848728275e-01, 4.59431618637297257e-01, 4.75733430966397752e-01,
+    4.91853096329674722e-01, 5.07794640198696245e-01};
+static const double lgLo[LN_TABLE_SIZE] = {
+    4.46904691120633424e-17, -1.71264283404354969e-17, -1.22699891516296873e-17,
+    -5.22449006139010906e-18, -2.22080242939253037e-17, -7.43403992828536385e-19,
+    -2.62147444500277481e-17, -2.20383463205836117e-17, -2.47647535687858788e-17,
+    1.20821054314585856e-17, -7.52237835008765195e-19, -1.11040121469626519e-17,
+    -1.35827170722987595e-18, 4.89829400968252132e-18, -5.45905252946374968e-18,
+    -5.59619205780437715e-18, -6.92484309629488110e-19, -2.54509722765200257e-18,
+    -7.36310558021185423e-19, 0.00000000000000000e+00, -1.59336660527619404e-18,
+    1.33386800392262232e-18, -4.13024785275673414e-18, 6.76532122699127525e-18,
+    5.40465721380330755e-18, -1.14757141433769200e-17, 3.39573316822624938e-18,
+    -1.04489801227802181e-17, -2.36261711785266720e-19, -1.74780153911659406e-18,
+    -5.96789405421864525e-18, 3.86621835416023350e-18, -1.14845479855571498e-17,
+    -2.72628363819737199e-17, -8.33378701974818799e-18, -3.71701996414268193e-19,
+    -2.08979602455604362e-17, 1.89848209077050566e-17, 1.09900077738484297e-17,
+    -1.63285022083527617e-17, -2.13619563850519079e-17, -1.99320121371933163e-17,
+    2.74293795639213250e-17, -3.80535838594497050e-19, 2.67121790582564162e-18,
+    -1.08206821191944862e-17, 2.23687927637115650e-17};
+
+#define LN_SQRT_HALF_BITS 0x3fe6a09e667f3bcdULL
+// ln2 and log10(2) split so that k * HI is exact for every exponent k
+#define LN_LN2_HI 6.93147180369123816490e-01
+#define LN_LN2_LO 1.90821492927058770002e-10
+#define LN_LOG2_HI 3.01029995663611771306e-01
+#define LN_LOG2_LO 3.69423907715893078616e-13
+// 1/ln2 and 1/ln10 as hi + lo
+#define LN_LGE_HI 1.44269504088896339e+00
+#define LN_LGE_LO 2.03552737409310331e-17
+#define LN_LOGE_HI 4.34294481903251817e-01
+#define LN_LOGE_LO 1.09831965021676507e-17
+// error of hi + lo: relative to the result, plus the rounding of the
+// polynomial, which can be 2^-6 of a result near 0 (x near 1 - 1/64)
+#define LN_EPS 0x1p-62
+#define LN_POLY_EPS 0x1p-48
+// 0, negative x, inf and NaN go to the long double code
+#define LOG_FAST(x) ((x) > 0 && (x) <= DBL_MAX)
+
+
+// ---- Sine, Cosine ----
+
+// sin and cos of a_j = j/64, j = 0..50, as hi + lo
+#define TRIG_TABLE_SIZE 51
+static const double sinHi[TRIG_TABLE_SIZE] = {
+    0.00000000000000000e+00, 1.56243642248833723e-02, 3.12449139853260803e-02,
+    4.68578357481342425e-02, 6.24593178423802006e-02, 7.80455513899673131e-02,
+    9.36127312355128915e-02, 1.09157056875322359e-01, 1.24674733385227693e-01,
+    1.40161972347063707e-01, 1.55614992773556032e-01, 1.71030022031395029e-01,
+    1.86403296762269882e-01, 2.01731063801638799e-01, 2.17009581095010146e-01,
+    2.32235118611511471e-01, 2.47403959254522937e-01, 2.62512399769153304e-01,
+    2.77556751646336308e-01, 2.92533342023327536e-01, 3.07438514580380851e-01,
+    3.22268630433386605e-01, 3.37020069022253066e-01, 3.51689228994814085e-01,
+    3.66272529086047571e-01, 3.80766408992390171e-01, 3.95167330240934256e-01,
+    4.09471777053295072e-01, 4.23676257203938034e-01, 4.37777302872755125e-01,
+    4.51771471491683785e-01, 4.65655346585160168e-01, 4.79425538604203005e-01,
+    4.93078685753923052e-01, 5.06611454814257400e-01, 5.20020541953727045e-01,
+    5.33302673536020122e-01, 5.46454606919203556e-01, 5.59473131247366862e-01,
+    5.72355068234507214e-01, 5.85097272940462210e-01, 5.97696634538701477e-01,
+    6.10150077075791386e-01, 6.22454560222343689e-01, 6.34607080015269331e-01,
+    6.46604669591152370e-01, 6.58444399910567579e-01, 6.70123380473162888e-01,
+    6.81638760023334123e-01, 6.92987727246317964e-01, 7.04167511454533712e-01};
+static const double sinLo[TRIG_TABLE_SIZE] = {
+    0.00000000000000000e+00, -1.26509375527598164e-19, -1.56278156222543300e-18,
+    -2.34193683656102535e-18, -2.04025950458571081e-18, -5.44944378200579280e-18,
+    1.46286320058787331e-18, 6.62846995027366656e-18, -2.92594749605785818e-18,
+    -9.94684711388347807e-18, 8.88605337234228782e-18, -9.95477472645292259e-18,
+    2.34937969012815731e-18, 5.58723281546011280e-18, 1.11700710733643761e-17,
+    -8.31808085268720599e-18, -7.53102495590705992e-18, -2.25345975279021249e-17,
+    1.76740702627918219e-17, 7.51694493032735190e-18, 1.10043664427652965e-19,
+    2.09377335812660597e-17, 1.03122798607872161e-17, -2.56162087360699421e-17,
+    -9.93881456210652418e-18, 2.13725286462113737e-17, -1.96134878714142281e-17,
+    -5.67940300009126604e-18, -2.33180070006887094e-17, 7.64345629962023030e-18,
+    -8.23407394209890257e-18, 1.45987039105142601e-17, -5.10396986055601290e-18,
+    5.60508397387175474e-18, -3.26941342361816774e-17, -3.98326674569845477e-17,
+    5.12931811503204399e-17, 8.39975484092950739e-18, 1.57556551448872803e-17,
+    2.65758723572153157e-17, -5.48839724611618050e-17, 5.45032359305438502e-17,
+    -1.47982699075898800e-17, -6.04903576570970714e-18, -3.45685823926249648e-17,
+    4.56764771439328899e-19, -3.77363867003067169e-17, 6.18353672557495936e-18,
+    4.41046731319790287e-17, -5.35432907989094549e-17, -3.94095700584824985e-17};
+static const double cosHi[TRIG_TABLE_SIZE] = {
+    1.00000000000000000e+00, 9.99877932171006623e-01, 9.99511758485136403e-01,
+    9.98901568338442902e-01, 9.98047510700099116e-01, 9.96949794076028684e-01,
+    9.95608686458001713e-01, 9.94024515258209118e-01, 9.92197667229329006e-01,
+    9.90128588370107088e-01, 9.87817783816471895e-01, 9.85265817718213865e-01,
+    9.82473313101255297e-01, 9.79440951715548347e-01, 9.76169473868635285e-01,
+    9.72659678244912729e-01, 9.68912421710644733e-01, 9.64928619104771013e-01,
+    9.60709243015561931e-01, 9.56255323543175328e-01, 9.51567948048172241e-01,
+    9.46648260886053361e-01, 9.41497463127881073e-01, 9.36116812267055343e-01,
+    9.30507621912314287e-01, 9.24671261467036043e-01, 9.18609155794918308e-01,
+    9.12322784872117820e-01, 9.05813683425936378e-01, 8.99083440560138447e-01,
+    8.92133699366994382e-01, 8.84966156526143299e-01, 8.77582561890372759e-01,
+    8.69984718058417372e-01, 8.62174479934880500e-01, 8.54153754277385380e-01,
+    8.45924499231067939e-01, 8.37488723850523642e-01, 8.28848487609325724e-01,
+    8.20005899897234047e-01, 8.10963119505217933e-01, 8.01722354098418410e-01,
+    7.92285859677178572e-01, 7.82655940026272812e-01, 7.72834946152471503e-01,
+    7.62825275710576234e-01, 7.52629372418066489e-01, 7.42249725458501319e-01,
+    7.31688868873820897e-01, 7.20949380945696383e-01, 7.10033883566079660e-01};
+static const double cosLo[TRIG_TABLE_SIZE] = {
+    0.00000000000000000e+00, 3.21612222997234111e-17, -3.41880648797294691e-17,
+    -2.14255578003997544e-17, 3.32322916741413455e-17, -1.24670757285536264e-17,
+    3.31292243093299115e-17, 1.32879850462600870e-17, 4.75487057518936408e-17,
+    -4.58990635355381125e-18, 4.91917302237681002e-17, -4.92572126294455489e-17,
+    -3.91992037542008779e-17, 1.31087695215267578e-17, -7.85069060928502747e-18,
+    2.39202645464901648e-17, 5.07143666240393583e-17, -3.03455426810186255e-18,
+    -2.80782706351672909e-17, -3.14845086884162891e-17, -3.86148346756741233e-17,
+    -3.91168333493415196e-17, -4.85238302367970955e-18, -5.23503020396832165e-17,
+    4.48876000332807380e-18, 5.54441253880345633e-17, -4.05641501045149965e-17,
+    2.63490402114133324e-17, 4.28646664908052143e-17, 9.07695177507561595e-18,
+    2.31606552113801660e-17, -7.69055777598735693e-18, -4.26231498642799968e-17,
+    1.65738511074092287e-17, 4.41324275781058045e-18, 5.42056510267528622e-18,
+    1.54950664735032887e-17, 4.33370260439483957e-17, 1.11639354066174440e-17,
+    -3.91243174820912803e-17, -3.09133348612217870e-17, 4.01345333110870139e-17,
+    -2.90497793128345759e-17, -1.47407164121148702e-17, 4.23101492189102327e-17,
+    1.66729950215466278e-17, -1.29709930131505256e-17, -1.23393036048695210e-17,
+    -1.04758243065127675e-17, 3.49498670147881605e-17, 1.50527221189129099e-17};
+
+#define TRIG_FAST_MAX 0x1p20
+#define TRIG_INV_PIO2 6.36619772367581382433e-01
+#define TRIG_PIO2_1 1.57079632673412561417e+00 // 33 bits
+#define TRIG_PIO2_2 6.07710050630396597660e-11 // 33 bits
+#define TRIG_PIO2_3 2.02226624871116645580e-21
+#define TRIG_PIO2_3T 8.47842766036889956997e-32
+// |x - q*pi/2 - (rh + rl)| for 0 < |q| <= 2^20: the roundings of q * PIO2_3
+// and of the tail it is subtracted from, both below 2^-100
+#define TRIG_REDUCE_ERR 0x1p-98
+#define TRIG_EPS 0x1p-62
+
+// x = q*(pi/2) + rh + rl for |x| <= 2^20 (Cody-Waite with pi/2 in four
+// pieces; the first two products are exact). Returns q.
+static long long reduceFast(double x, double *rh, double *rl)
+{
+    double qd = (x * TRIG_INV_PIO2 + SHIFT) - SHIFT;
+    double r1 = x - qd * TRIG_PIO2_1;
+    double e, r2 = twoSum(r1, -(qd * TRIG_PIO2_2), &e);
+    e -= qd * TRIG_PIO2_3 + qd * TRIG_PIO2_3T;
+    *rh = twoSum(r2, e, rl);
+    return (long long)qd;
+}
+
+// ---- kernel builds ----
+
+// The kernels are built twice: for the compile target, and on x86 with
+// FMA enabled. Without FMA every exact product is Dekker's split, a dozen
+// operations instead of one, and the fast path is barely faster than the
+// long double code; the FMA build is picked at run time when the CPU has it.
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+#define CF_AFMA_BASE 1 // the compile target has FMA already
+#else
+#define CF_AFMA_BASE 0
+#endif
+#define CF_AFMA CF_AFMA_BASE
+#define CF_ANAME(x) x##_base
+#include "cf_adaptive_kernel.h"
+#undef CF_ANAME
+#undef CF_AFMA
+
+#if !CF_AFMA_BASE && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CF_HAVE_FMA_BUILD 1
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("fma")
+#endif
+#define CF_AFMA 1
+#define CF_ANAME(x) x##_fma
+#include "cf_adaptive_kernel.h"
+#undef CF_ANAME
+#undef CF_AFMA
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+struct AdaptiveTable
+{
+    double (*exp)(double);
+    double (*ln)(double);
+    double (*log)(double);
+    double (*lg)(double);
+    double (*sine)(double);
+    double (*cosine)(double);
+};
+
+static const struct AdaptiveTable baseTable = {exp_base, ln_base, log_base, lg_base, sine_base, cosine_base};
+#ifdef CF_HAVE_FMA_BUILD
+static const struct AdaptiveTable fmaTable = {exp_fma, ln_fma, log_fma, lg_fma, sine_fma, cosine_fma};
+
+static int cpuHasFma()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("fma");
+}
+#endif
+
+static const struct AdaptiveTable *active = NULL;
+
+// resolved on first use, like the batch table: the pointer is the only
+// state, and a first call does not undo a setAdaptiveFma that got in first
+static const struct AdaptiveTable *adaptiveTable()
+{
+    const struct AdaptiveTable *t = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+    if (!t)
+    {
+        const struct AdaptiveTable *best = &baseTable;
+#ifdef CF_HAVE_FMA_BUILD
+        if (cpuHasFma())
+            best = &fmaTable;
+#endif
+        t = NULL;
+        if (__atomic_compare_exchange_n(&active, &t, best, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            t = best;
+    }
+    return t;
+}
+
+int adaptiveFma()
+{
+#ifdef CF_HAVE_FMA_BUILD
+    return adaptiveTable() == &fmaTable;
+#else
+    return CF_AFMA_BASE;
+#endif
+}
+
+int setAdaptiveFma(int on)
+{
+#ifdef CF_HAVE_FMA_BUILD
+    on = on && cpuHasFma();
+    __atomic_store_n(&active, on ? &fmaTable : &baseTable, __ATOMIC_RELEASE);
+    return on;
+#else
+    (void)on;
+    return CF_AFMA_BASE;
+#endif
+}
+
+double ExpA(double x) { return adaptiveTable()->exp(x); }
+double LnA(double x) { return adaptiveTable()->ln(x); }
+double LogA(double x) { return adaptiveTable()->log(x); }
+double LgA(double x) { return adaptiveTable()->lg(x); }
+double SineA(double x) { return adaptiveTable()->sine(x); }
+double CosineA(double x) { return adaptiveTable()->cosine(x); }
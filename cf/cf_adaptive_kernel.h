@@ -0,0 +1,239 @@
+/* The fast kernels of the adaptive mode and the functions built on them.
+ *
+ * Included from cf_adaptive.c once per build of the kernels, with
+ *   CF_ANAME(x)  x suffixed with the build name (x_base, x_fma)
+ *   CF_AFMA      1 if twoProd may use a fused multiply-add
+ * defined, and for the FMA build a target pragma in effect. The tables,
+ * constants and helpers it uses come from cf_adaptive.c. Every exact
+ * product goes through twoProd, which is all the builds differ in. No
+ * include guard on purpose. */
+
+#define AN(x) CF_ANAME(x)
+
+// p + *e == a * b exactly: one FMA in the FMA build, Dekker's product
+// otherwise (without FMA hardware the split cannot be fused)
+static inline double AN(twoProd)(double a, double b, double *e)
+{
+    double p = a * b;
+#if CF_AFMA
+    *e = __builtin_fma(a, b, -p);
+#else
+    double t = a * SPLITTER;
+    double ah = t - (t - a), al = a - ah;
+    t = b * SPLITTER;
+    double bh = t - (t - b), bl = b - bh;
+    *e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+    return p;
+}
+
+// ---- Exp ----
+
+// x = (32k + j) * ln2/32 + r, |r| <= ln2/64, e^x = 2^k * 2^(j/32) * e^r and
+// 2^(j/32) * (1 + rh) is formed exactly; e^r - 1 - r is a degree 7 Taylor
+// polynomial in Estrin's form, the first dropped term below 2^-67
+static double AN(expFast)(double x, double *lo)
+{
+    double nd = (x * EXP_INV_LN2_32 + SHIFT) - SHIFT;
+    long long n = (long long)nd;
+    double rh = x - nd * EXP_LN2_32_HI;
+    double rl = -nd * EXP_LN2_32_LO;
+    double r = rh + rl;
+    double z = r * r;
+    double p = z * ((0.5 + r * (1.0 / 6)) + z * ((1.0 / 24 + r * (1.0 / 120)) + z * (1.0 / 720 + r * (1.0 / 5040))));
+
+    int j = (int)(n & 31);
+    long long k = (n - j) / 32;
+    double th = expHi[j], tl = expLo[j];
+    double pe, ph = AN(twoProd)(th, rh, &pe);
+    double e1, s = twoSum(th, ph, &e1);
+    double l = (e1 + pe) + (th * (rl + p) + tl * (1 + r));
+    double y = s + l;
+    *lo = l - (y - s); // |s| > |l|
+    double scale = fromBits((uint64_t)(k + 1023) << 52);
+    *lo *= scale;
+    return y * scale;
+}
+
+static double AN(exp)(double x)
+{
+    count(&calls[ADAPTIVE_EXP]);
+    if (x >= EXP_FAST_MIN && x <= EXP_FAST_MAX)
+    {
+        double lo, y = AN(expFast)(x, &lo);
+        if (accept(y, lo, EXP_EPS * y))
+            return y;
+    }
+    count(&fallbacks[ADAPTIVE_EXP]);
+    return (double)Exp(x);
+}
+
+// ---- Ln, Log, Lg ----
+
+// log of a finite x > 0 in the base given by the tables: x = 2^k * c_i *
+// (1 + r) with r = rh + rl carried exactly enough, |r| <= 0.0112, and
+// log(x) = k * K + log(c_i) + F * ln(1 + r), K and F the base's log(2) and
+// 1/ln(base). The three leading terms are summed exactly; ln(1 + r) - r
+// is a degree 9 polynomial in Estrin's form (the first dropped term is
+// below 2^-54 of it, inside LN_POLY_EPS).
+static inline double AN(logFast)(double x, const double *tHi, const double *tLo, double kHi, double kLo,
+                             double fHi, double fLo, double *lo, double *bound)
+{
+    int k = 0; // subnormals are scaled up first
+    if (x < 0x1p-1022)
+    {
+        x *= 0x1p54;
+        k = -54;
+    }
+    uint64_t u = toBits(x) + (0x3ff0000000000000ULL - LN_SQRT_HALF_BITS);
+    k += (int)(u >> 52) - 1023;
+    double m = fromBits((u & 0x000fffffffffffffULL) + LN_SQRT_HALF_BITS);
+
+    double id = ((m - 1) * 64 + SHIFT) - SHIFT;
+    int j = (int)id - LN_TABLE_MIN;
+    double c = 1 + id * (1.0 / 64);
+    double d = m - c; // exact
+    double rh = d * invC[j];
+    double pe, ph = AN(twoProd)(rh, c, &pe);
+    double rl = ((d - ph) - pe) * invC[j];
+    double z = rh * rh, z2 = z * z;
+    double p = z * (((-1.0 / 2 + rh * (1.0 / 3)) + z * (-1.0 / 4 + rh * (1.0 / 5))) +
+                    z2 * ((-1.0 / 6 + rh * (1.0 / 7)) + z * ((-1.0 / 8 + rh * (1.0 / 9)))));
+
+    double fe = 0, fh = rh; // F = 1 for Ln, a constant once inlined
+    if (fHi != 1)
+        fh = AN(twoProd)(rh, fHi, &fe);
+    double e1, e2;
+    double s = twoSum(k * kHi, tHi[j], &e1);
+    s = twoSum(s, fh, &e2);
+    double l = (e1 + e2) + (fe + rh * fLo) + ((rl * (1 - rh) + p) * fHi + (k * kLo + tLo[j]));
+    *bound = LN_EPS * ABS(s) + LN_POLY_EPS * ABS(p);
+    return twoSum(s, l, lo);
+}
+
+static double AN(ln)(double x)
+{
+    count(&calls[ADAPTIVE_LN]);
+    if (LOG_FAST(x))
+    {
+        double lo, bound, y = AN(logFast)(x, lnHi, lnLo, LN_LN2_HI, LN_LN2_LO, 1, 0, &lo, &bound);
+        if (accept(y, lo, bound))
+            return y;
+    }
+    count(&fallbacks[ADAPTIVE_LN]);
+    return (double)Ln(x);
+}
+
+static double AN(log)(double x)
+{
+    count(&calls[ADAPTIVE_LOG]);
+    if (LOG_FAST(x))
+    {
+        double lo, bound, y = AN(logFast)(x, logHi, logLo, LN_LOG2_HI, LN_LOG2_LO, LN_LOGE_HI, LN_LOGE_LO, &lo, &bound);
+        if (accept(y, lo, bound))
+            return y;
+    }
+    count(&fallbacks[ADAPTIVE_LOG]);
+    return (double)Log(x);
+}
+
+static double AN(lg)(double x)
+{
+    count(&calls[ADAPTIVE_LG]);
+    if (LOG_FAST(x))
+    {
+        double lo, bound, y = AN(logFast)(x, lgHi, lgLo, 1, 0, LN_LGE_HI, LN_LGE_LO, &lo, &bound);
+        if (accept(y, lo, bound))
+            return y;
+    }
+    count(&fallbacks[ADAPTIVE_LG]);
+    return (double)Lg(x);
+}
+
+// ---- Sine, Cosine ----
+
+// sin (cosine = 0) or cos (cosine = 1) of r = rh + rl, |rh| <= pi/4 + 2^-40.
+// |r| = a_j + t with |t| <= 1/128, then sin(a + t) = S cos t + C sin t and
+// cos(a + t) = C cos t - S sin t with the C*t or S*t product exact;
+// sin t - t and cos t - 1 are Taylor polynomials to t^7 and t^6, and rl
+// enters through the derivative, to first order in t.
+static double AN(trigFast)(double rh, double rl, int cosine, double *lo)
+{
+    int neg = rh < 0;
+    if (neg)
+    {
+        rh = -rh;
+        rl = -rl;
+    }
+    int j = (int)(rh * 64 + 0.5);
+    double th = rh - j * (1.0 / 64); // exact
+    double z = th * th;
+    double ps = th * z * (-1.0 / 6 + z * (1.0 / 120 + z * (-1.0 / 5040)));
+    double pc = z * (-0.5 + z * (1.0 / 24 + z * (-1.0 / 720)));
+    double sh = sinHi[j], sl = sinLo[j], ch = cosHi[j], cl = cosLo[j];
+
+    double pe, ph, e1, s, l;
+    if (!cosine)
+    {
+        ph = AN(twoProd)(ch, th, &pe);
+        s = twoSum(sh, ph, &e1);
+        l = (e1 + pe) + (sl + cl * th) + (ch * (rl + ps) + sh * (pc - th * rl));
+    }
+    else
+    {
+        ph = AN(twoProd)(sh, th, &pe);
+        s = twoSum(ch, -ph, &e1);
+        l = (e1 - pe) + (cl - sl * th) + (ch * (pc - th * rl) - sh * (rl + ps));
+    }
+    double y = twoSum(s, l, lo);
+    if (neg && !cosine)
+    {
+        *lo = -*lo;
+        return -y;
+    }
+    return y;
+}
+
+// sin (cosine = 0) or cos (cosine = 1) of x in the quadrant q puts it
+static double AN(sinCosFast)(double x, int cosine, double *lo, double *bound)
+{
+    double rh, rl;
+    long long q = reduceFast(x, &rh, &rl);
+    q += cosine;
+    double y = AN(trigFast)(rh, rl, (int)(q & 1), lo);
+    if (q & 2)
+    {
+        y = -y;
+        *lo = -*lo;
+    }
+    *bound = TRIG_EPS * ABS(y) + (q - cosine ? TRIG_REDUCE_ERR : 0);
+    return y;
+}
+
+static double AN(sine)(double x)
+{
+    count(&calls[ADAPTIVE_SINE]);
+    if (ABS(x) <= TRIG_FAST_MAX)
+    {
+        double lo, bound, y = AN(sinCosFast)(x, 0, &lo, &bound);
+        if (accept(y, lo, bound))
+            return y;
+    }
+    count(&fallbacks[ADAPTIVE_SINE]);
+    return (double)Sine(x);
+}
+
+static double AN(cosine)(double x)
+{
+    count(&calls[ADAPTIVE_COSINE]);
+    if (ABS(x) <= TRIG_FAST_MAX)
+    {
+        double lo, bound, y = AN(sinCosFast)(x, 1, &lo, &bound);
+        if (accept(y, lo, bound))
+            return y;
+    }
+    count(&fallbacks[ADAPTIVE_COSINE]);
+    return (double)Cosine(x);
+}
+
+#undef AN
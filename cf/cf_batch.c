@@ -0,0 +1,506 @@
+#include "cf.h"
+#include "cf_tables.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef void (*BatchFn)(const double *in, double *out, size_t n);
+typedef void (*BatchPairFn)(const double *in, double *out1, double *out2, size_t n);
+typedef void (*BatchBinaryFn)(const double *in1, const double *in2, double *out, size_t n);
+typedef void (*BatchPowFn)(const double *in, long long p, double *out, size_t n);
+
+// one entry per function that has a vector kernel
+struct BatchTable
+{
+    BatchFn sqrt;
+    BatchFn rsqrt;
+    BatchFn sine;
+    BatchFn cosine;
+    BatchFn tangent;
+    BatchFn csc;
+    BatchFn sec;
+    BatchFn cot;
+    BatchFn exp;
+    BatchFn ln;
+    BatchFn log;
+    BatchFn lg;
+    BatchFn sinh;
+    BatchFn cosh;
+    BatchFn tanh;
+    BatchFn csch;
+    BatchFn sech;
+    BatchFn coth;
+    BatchPairFn sinhCosh;
+    BatchFn asinh;
+    BatchFn acosh;
+    BatchFn atanh;
+    BatchFn acsch;
+    BatchFn asech;
+    BatchFn acoth;
+    BatchFn atan;
+    BatchFn asin;
+    BatchFn acos;
+    BatchFn acsc;
+    BatchFn asec;
+    BatchFn acot;
+    BatchBinaryFn atan2;
+    BatchPowFn ipow;
+    BatchBinaryFn rpow;
+};
+
+// scalar tier: every batch entry point is a loop over the long double routine
+#define SCALAR_BATCH(name)                                        \
+    static void scalar##name##Batch(const double *in, double *out, size_t n) \
+    {                                                             \
+        for (size_t i = 0; i < n; i++)                            \
+            out[i] = (double)name(in[i]);                         \
+    }
+
+SCALAR_BATCH(Sqrt)
+SCALAR_BATCH(RSqrt)
+SCALAR_BATCH(Sine)
+SCALAR_BATCH(Cosine)
+SCALAR_BATCH(Tangent)
+SCALAR_BATCH(Cosecant)
+SCALAR_BATCH(Secant)
+SCALAR_BATCH(Cotangent)
+SCALAR_BATCH(Exp)
+SCALAR_BATCH(Ln)
+SCALAR_BATCH(Log)
+SCALAR_BATCH(Lg)
+SCALAR_BATCH(Sinh)
+SCALAR_BATCH(Cosh)
+SCALAR_BATCH(Tanh)
+SCALAR_BATCH(Csch)
+SCALAR_BATCH(Sech)
+SCALAR_BATCH(Coth)
+SCALAR_BATCH(arcSinh)
+SCALAR_BATCH(arcCosh)
+SCALAR_BATCH(arcTanh)
+SCALAR_BATCH(arcCsch)
+SCALAR_BATCH(arcSech)
+SCALAR_BATCH(arcCoth)
+SCALAR_BATCH(arcTangent)
+SCALAR_BATCH(arcSine)
+SCALAR_BATCH(arcCosine)
+SCALAR_BATCH(arcCosecant)
+SCALAR_BATCH(arcSecant)
+SCALAR_BATCH(arcCotangent)
+
+static void scalarSinhCoshBatch(const double *in, double *s, double *c, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        long double ls, lc;
+        SinhCosh(in[i], &ls, &lc);
+        s[i] = (double)ls;
+        c[i] = (double)lc;
+    }
+}
+
+static void scalararcTangent2Batch(const double *y, const double *x, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = (double)arcTangent2(y[i], x[i]);
+}
+
+static void scalariPowerBatch(const double *in, long long p, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = (double)iPower(in[i], p);
+}
+
+static void scalarrPowerBatch(const double *x, const double *y, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = (double)rPower(x[i], y[i]);
+}
+
+static const struct BatchTable scalarTable = {
+    scalarSqrtBatch,
+    scalarRSqrtBatch,
+    scalarSineBatch,
+    scalarCosineBatch,
+    scalarTangentBatch,
+    scalarCosecantBatch,
+    scalarSecantBatch,
+    scalarCotangentBatch,
+    scalarExpBatch,
+    scalarLnBatch,
+    scalarLogBatch,
+    scalarLgBatch,
+    scalarSinhBatch,
+    scalarCoshBatch,
+    scalarTanhBatch,
+    scalarCschBatch,
+    scalarSechBatch,
+    scalarCothBatch,
+    scalarSinhCoshBatch,
+    scalararcSinhBatch,
+    scalararcCoshBatch,
+    scalararcTanhBatch,
+    scalararcCschBatch,
+    scalararcSechBatch,
+    scalararcCothBatch,
+    scalararcTangentBatch,
+    scalararcSineBatch,
+    scalararcCosineBatch,
+    scalararcCosecantBatch,
+    scalararcSecantBatch,
+    scalararcCotangentBatch,
+    scalararcTangent2Batch,
+    scalariPowerBatch,
+    scalarrPowerBatch,
+};
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CF_HAVE_VEC 1
+#include <immintrin.h>
+
+#define VEC_SHIFT 0x1.8p52
+#define VEC_SHIFT_BITS 0x4338000000000000LL
+#define VEC_INF (1.0 / 0.0)
+#define VEC_NAN (0.0 / 0.0)
+#define VEC_DBL_MIN 0x1p-1022
+#define VEC_TWO54 0x1p54
+#define VEC_TWO27 0x1p27
+
+#define VEC_LGE 1.44269504088896338700e+00
+#define VEC_LN2_HI 6.93147180369123816490e-01
+#define VEC_LN2_LO 1.90821492927058770002e-10
+#define VEC_INV_LN2 1.44269504088896338700e+00
+#define VEC_INV_LN10 4.34294481903251816668e-01
+#define VEC_LOG10_2_HI 3.01029995663611771306e-01
+#define VEC_LOG10_2_LO 3.69423907715893078616e-13
+#define VEC_EXP_MAX 7.09782712893383973096e+02
+#define VEC_EXP_MIN -7.45133219101941108420e+02
+
+#define VEC_LG1 6.666666666666735130e-01
+#define VEC_LG2 3.999999999940941908e-01
+#define VEC_LG3 2.857142874366239149e-01
+#define VEC_LG4 2.222219843214978396e-01
+#define VEC_LG5 1.818357216161805012e-01
+#define VEC_LG6 1.531383769920937332e-01
+#define VEC_LG7 1.479819860511658591e-01
+
+#define VEC_LN2 6.93147180559945286227e-01
+#define VEC_HYP_BIG 0x1p28
+#define VEC_EXPM1_MAX 0.34657359027997265471 // ln2/2
+#define VEC_TANH_SAT 22.0
+
+// Veltkamp splitter 2^27 + 1, and the x^n range where double-double
+// products need no care for overflow or subnormal low parts
+#define VEC_SPLIT 134217729.0
+#define VEC_DD_MIN 0x1p-968
+#define VEC_DD_MAX 0x1p995
+
+// pow: integers are told apart below 2^51, and y ln x in this range gives
+// a normal result
+#define VEC_TWO51 0x1p51
+#define VEC_POW_MIN -708.0
+#define VEC_POW_MAX 709.0
+
+#define VEC_RSQRT_MAGIC 0x5fe6eb50c7b537a9LL
+#define VEC_SQRT_sse2 _mm_sqrt_pd
+#define VEC_SQRT_avx2 _mm256_sqrt_pd
+#define VEC_SQRT_avx512(x) _mm512_mask_sqrt_pd(x, (__mmask8)-1, x)
+
+#define VEC_TRIG_MAX 0x1p20
+#define VEC_TWO_OVER_PI 6.36619772367581382433e-01
+#define VEC_PIO2_1 1.57079632673412561417e+00
+#define VEC_PIO2_2 6.07710050630396597660e-11
+#define VEC_PIO2_3 2.02226624871116645580e-21
+#define VEC_PIO2_3T 8.47842766036889956997e-32
+
+#define VEC_S1 -1.66666666666666324348e-01
+#define VEC_S2 8.33333333332248946124e-03
+#define VEC_S3 -1.98412698298579493134e-04
+#define VEC_S4 2.75573137070700676789e-06
+#define VEC_S5 -2.50507602534068634195e-08
+#define VEC_S6 1.58969099521155010221e-10
+
+#define VEC_C1 4.16666666666666019037e-02
+#define VEC_C2 -1.38888888888741095749e-03
+#define VEC_C3 2.48015872894767294178e-05
+#define VEC_C4 -2.75573143513906633035e-07
+#define VEC_C5 2.08757232129817482790e-09
+#define VEC_C6 -1.13596475577881948265e-11
+
+#define VEC_AT0 3.33333333333329318027e-01
+#define VEC_AT1 -1.99999999998764832476e-01
+#define VEC_AT2 1.42857142725034663711e-01
+#define VEC_AT3 -1.11111104054623557880e-01
+#define VEC_AT4 9.09088713343650656196e-02
+#define VEC_AT5 -7.69187620504482999495e-02
+#define VEC_AT6 6.66107313738753120669e-02
+#define VEC_AT7 -5.83357013379057348645e-02
+#define VEC_AT8 4.97687799461593236017e-02
+#define VEC_AT9 -3.65315727442169155270e-02
+#define VEC_AT10 1.62858201153657823623e-02
+
+// atan(0.5), atan(1), atan(1.5), atan(inf) as hi + lo
+#define VEC_ATAN_HI0 4.63647609000806093515e-01
+#define VEC_ATAN_HI1 7.85398163397448278999e-01
+#define VEC_ATAN_HI2 9.82793723247329054082e-01
+#define VEC_ATAN_HI3 1.57079632679489655800e+00
+#define VEC_ATAN_LO0 2.26987774529616870924e-17
+#define VEC_ATAN_LO1 3.06161699786838301793e-17
+#define VEC_ATAN_LO2 1.39033110312309984516e-17
+#define VEC_ATAN_LO3 6.12323399573676603587e-17
+
+// whole vectors straight from the arrays, the tail through a padded buffer
+#define VEC_LOOP(kernel)                                       \
+    size_t i = 0;                                              \
+    VD v;                                                      \
+    for (; i + CF_VLEN <= n; i += CF_VLEN)                     \
+    {                                                          \
+        memcpy(&v, in + i, sizeof v);                          \
+        v = kernel(v);                                         \
+        memcpy(out + i, &v, sizeof v);                         \
+    }                                                          \
+    if (i < n)                                                 \
+    {                                                          \
+        double tail[CF_VLEN] = {0};                            \
+        memcpy(tail, in + i, (n - i) * sizeof(double));        \
+        memcpy(&v, tail, sizeof v);                            \
+        v = kernel(v);                                         \
+        memcpy(tail, &v, sizeof v);                            \
+        memcpy(out + i, tail, (n - i) * sizeof(double));       \
+    }
+
+// the same for kernels with two outputs
+#define VEC_LOOP2(kernel)                                      \
+    size_t i = 0;                                              \
+    VD v, a, b;                                                \
+    for (; i + CF_VLEN <= n; i += CF_VLEN)                     \
+    {                                                          \
+        memcpy(&v, in + i, sizeof v);                          \
+        kernel(v, &a, &b);                                     \
+        memcpy(out1 + i, &a, sizeof a);                        \
+        memcpy(out2 + i, &b, sizeof b);                        \
+    }                                                          \
+    if (i < n)                                                 \
+    {                                                          \
+        double tail[CF_VLEN] = {0};                            \
+        memcpy(tail, in + i, (n - i) * sizeof(double));        \
+        memcpy(&v, tail, sizeof v);                            \
+        kernel(v, &a, &b);                                     \
+        memcpy(tail, &a, sizeof a);                            \
+        memcpy(out1 + i, tail, (n - i) * sizeof(double));      \
+        memcpy(tail, &b, sizeof b);                            \
+        memcpy(out2 + i, tail, (n - i) * sizeof(double));      \
+    }
+
+// the same for kernels with an extra scalar argument
+#define VEC_LOOP_ARG(kernel, arg)                              \
+    size_t i = 0;                                              \
+    VD v;                                                      \
+    for (; i + CF_VLEN <= n; i += CF_VLEN)                     \
+    {                                                          \
+        memcpy(&v, in + i, sizeof v);                          \
+        v = kernel(v, arg);                                    \
+        memcpy(out + i, &v, sizeof v);                         \
+    }                                                          \
+    if (i < n)                                                 \
+    {                                                          \
+        double tail[CF_VLEN] = {0};                            \
+        memcpy(tail, in + i, (n - i) * sizeof(double));        \
+        memcpy(&v, tail, sizeof v);                            \
+        v = kernel(v, arg);                                    \
+        memcpy(tail, &v, sizeof v);                            \
+        memcpy(out + i, tail, (n - i) * sizeof(double));       \
+    }
+
+// the same for kernels with two inputs
+#define VEC_LOOP_BINARY(kernel)                                \
+    size_t i = 0;                                              \
+    VD a, b;                                                   \
+    for (; i + CF_VLEN <= n; i += CF_VLEN)                     \
+    {                                                          \
+        memcpy(&a, in1 + i, sizeof a);                         \
+        memcpy(&b, in2 + i, sizeof b);                         \
+        a = kernel(a, b);                                      \
+        memcpy(out + i, &a, sizeof a);                         \
+    }                                                          \
+    if (i < n)                                                 \
+    {                                                          \
+        double tail[CF_VLEN] = {0};                            \
+        memcpy(tail, in1 + i, (n - i) * sizeof(double));       \
+        memcpy(&a, tail, sizeof a);                            \
+        memcpy(tail, in2 + i, (n - i) * sizeof(double));       \
+        memcpy(&b, tail, sizeof b);                            \
+        a = kernel(a, b);                                      \
+        memcpy(tail, &a, sizeof a);                            \
+        memcpy(out + i, tail, (n - i) * sizeof(double));       \
+    }
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+#define CF_VLEN 2
+#define CF_VNAME(x) x##_sse2
+#include "cf_vec.h"
+#undef CF_VNAME
+#undef CF_VLEN
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+#define CF_VLEN 4
+#define CF_VNAME(x) x##_avx2
+#include "cf_vec.h"
+#undef CF_VNAME
+#undef CF_VLEN
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512dq"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq")
+#endif
+#define CF_VLEN 8
+#define CF_VNAME(x) x##_avx512
+#include "cf_vec.h"
+#undef CF_VNAME
+#undef CF_VLEN
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // vector tiers
+
+static BatchIsa bestIsa()
+{
+#ifdef CF_HAVE_VEC
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+        return BATCH_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return BATCH_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return BATCH_SSE2;
+#endif
+    return BATCH_SCALAR;
+}
+
+static const struct BatchTable *tableFor(BatchIsa isa)
+{
+    switch (isa)
+    {
+#ifdef CF_HAVE_VEC
+    case BATCH_AVX512:
+        return &table_avx512;
+    case BATCH_AVX2:
+        return &table_avx2;
+    case BATCH_SSE2:
+        return &table_sse2;
+#endif
+    default:
+        return &scalarTable;
+    }
+}
+
+static const struct BatchTable *active = NULL;
+
+// resolved on first use. The pointer is the only state, read and written
+// atomically: a first call only installs its table if none is there yet,
+// so it cannot undo a setBatchIsa that got in first.
+static const struct BatchTable *batchTable()
+{
+    const struct BatchTable *t = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+    if (!t)
+    {
+        const struct BatchTable *best = tableFor(bestIsa());
+        t = NULL;
+        if (__atomic_compare_exchange_n(&active, &t, best, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            t = best;
+    }
+    return t;
+}
+
+BatchIsa batchIsa()
+{
+    const struct BatchTable *t = batchTable();
+    for (int isa = BATCH_SCALAR; isa < BATCH_AVX512; isa++)
+        if (tableFor((BatchIsa)isa) == t)
+            return (BatchIsa)isa;
+    return BATCH_AVX512;
+}
+
+BatchIsa setBatchIsa(BatchIsa isa)
+{
+    BatchIsa best = bestIsa();
+    if (isa > best)
+        isa = best;
+    __atomic_store_n(&active, tableFor(isa), __ATOMIC_RELEASE);
+    return isa;
+}
+
+const char *batchIsaName(BatchIsa isa)
+{
+    switch (isa)
+    {
+    case BATCH_SCALAR:
+        return "scalar";
+    case BATCH_SSE2:
+        return "sse2";
+    case BATCH_AVX2:
+        return "avx2";
+    case BATCH_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+void SqrtBatch(const double *in, double *out, size_t n) { batchTable()->sqrt(in, out, n); }
+void RSqrtBatch(const double *in, double *out, size_t n) { batchTable()->rsqrt(in, out, n); }
+void SineBatch(const double *in, double *out, size_t n) { batchTable()->sine(in, out, n); }
+void CosineBatch(const double *in, double *out, size_t n) { batchTable()->cosine(in, out, n); }
+void TangentBatch(const double *in, double *out, size_t n) { batchTable()->tangent(in, out, n); }
+void CosecantBatch(const double *in, double *out, size_t n) { batchTable()->csc(in, out, n); }
+void SecantBatch(const double *in, double *out, size_t n) { batchTable()->sec(in, out, n); }
+void CotangentBatch(const double *in, double *out, size_t n) { batchTable()->cot(in, out, n); }
+void ExpBatch(const double *in, double *out, size_t n) { batchTable()->exp(in, out, n); }
+void LnBatch(const double *in, double *out, size_t n) { batchTable()->ln(in, out, n); }
+void LogBatch(const double *in, double *out, size_t n) { batchTable()->log(in, out, n); }
+void LgBatch(const double *in, double *out, size_t n) { batchTable()->lg(in, out, n); }
+void SinhBatch(const double *in, double *out, size_t n) { batchTable()->sinh(in, out, n); }
+void CoshBatch(const double *in, double *out, size_t n) { batchTable()->cosh(in, out, n); }
+void TanhBatch(const double *in, double *out, size_t n) { batchTable()->tanh(in, out, n); }
+void CschBatch(const double *in, double *out, size_t n) { batchTable()->csch(in, out, n); }
+void SechBatch(const double *in, double *out, size_t n) { batchTable()->sech(in, out, n); }
+void CothBatch(const double *in, double *out, size_t n) { batchTable()->coth(in, out, n); }
+void SinhCoshBatch(const double *in, double *s, double *c, size_t n) { batchTable()->sinhCosh(in, s, c, n); }
+void arcSinhBatch(const double *in, double *out, size_t n) { batchTable()->asinh(in, out, n); }
+void arcCoshBatch(const double *in, double *out, size_t n) { batchTable()->acosh(in, out, n); }
+void arcTanhBatch(const double *in, double *out, size_t n) { batchTable()->atanh(in, out, n); }
+void arcCschBatch(const double *in, double *out, size_t n) { batchTable()->acsch(in, out, n); }
+void arcSechBatch(const double *in, double *out, size_t n) { batchTable()->asech(in, out, n); }
+void arcCothBatch(const double *in, double *out, size_t n) { batchTable()->acoth(in, out, n); }
+void arcTangentBatch(const double *in, double *out, size_t n) { batchTable()->atan(in, out, n); }
+void arcSineBatch(const double *in, double *out, size_t n) { batchTable()->asin(in, out, n); }
+void arcCosineBatch(const double *in, double *out, size_t n) { batchTable()->acos(in, out, n); }
+void arcCosecantBatch(const double *in, double *out, size_t n) { batchTable()->acsc(in, out, n); }
+void arcSecantBatch(const double *in, double *out, size_t n) { batchTable()->asec(in, out, n); }
+void arcCotangentBatch(const double *in, double *out, size_t n) { batchTable()->acot(in, out, n); }
+void arcTangent2Batch(const double *y, const double *x, double *out, size_t n) { batchTable()->atan2(y, x, out, n); }
+void iPowerBatch(const double *in, long long p, double *out, size_t n) { batchTable()->ipow(in, p, out, n); }
+void rPowerBatch(const double *x, const double *y, double *out, size_t n) { batchTable()->rpow(x, y, out, n); }
@@ -0,0 +1,616 @@
+#ifndef CF_CONSTEXPR_H_INCLUDED
+#define CF_CONSTEXPR_H_INCLUDED
+
+// Compile-time versions of the core cf functions and a lookup-table
+// generator built on them (C++14). Everything here is header only:
+//
+//   constexpr double s = cfconst::Sine(0.5);
+//   constexpr auto sinTab = cfconst::makeTable<double, 256, cfconst::Sine<double>>(0.0, PI);
+//
+// The constexpr routines are within 1.5 ULP of the correctly rounded result
+// in float and double (Sine/Cosine for |x| < 2^20). They only use arithmetic and loops, so they are
+// slower than the cf.c versions at run time; use them to build constants and
+// tables, and the tables (or the cf.c functions) in hot code. pow<N> is the
+// exception: a multiplication chain unrolled at compile time, as fast at
+// run time as writing the multiplies out by hand.
+//
+// The "fast mode" at the bottom (LerpTable, fastSine, fastCosine, fastExp,
+// fastLn) reads linearly interpolated tables that are baked into the binary.
+// Each table carries the largest error it makes, measured when it is built.
+
+#include "cf.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace cfconst
+{
+
+// ---- helpers ----
+
+template <typename T>
+constexpr T abs(T x)
+{
+    return x < 0 ? -x : x;
+}
+
+// nearest integer (halfway away from zero), for |x| < 2^62
+template <typename T>
+constexpr long long roundToInt(T x)
+{
+    return (long long)(x < 0 ? x - T(0.5) : x + T(0.5));
+}
+
+// 2^k by binary powering, exact for every representable power
+template <typename T>
+constexpr T pow2(long long k)
+{
+    T base = k < 0 ? T(0.5) : T(2);
+    unsigned long long n = k < 0 ? -(unsigned long long)k : (unsigned long long)k;
+    T r = 1;
+    while (n)
+    {
+        if (n & 1)
+            r *= base;
+        base *= base;
+        n >>= 1;
+    }
+    return r;
+}
+
+// x = m * 2^e with m in [1, 2), for finite x > 0
+template <typename T>
+constexpr T splitExponent(T x, long long &e)
+{
+    e = 0;
+    while (x >= T(18446744073709551616.0L))
+    {
+        x *= T(5.42101086242752217004e-20L);
+        e += 64;
+    }
+    while (x < T(5.42101086242752217004e-20L))
+    {
+        x *= T(18446744073709551616.0L);
+        e -= 64;
+    }
+    while (x >= 2)
+    {
+        x *= T(0.5);
+        e++;
+    }
+    while (x < 1)
+    {
+        x *= 2;
+        e--;
+    }
+    return x;
+}
+
+// HRD_INFINITE and HRD_NOT_A_NUM divide by zero, which is not a constant expression
+template <typename T>
+constexpr T inf()
+{
+    return std::numeric_limits<T>::infinity();
+}
+
+template <typename T>
+constexpr T nan()
+{
+    return std::numeric_limits<T>::quiet_NaN();
+}
+
+template <typename T>
+constexpr bool isNan(T x)
+{
+    return !(x == x);
+}
+
+// ---- functions ----
+
+template <typename T>
+constexpr T Sqrt(T x)
+{
+    if (isNan(x) || x < 0)
+        return nan<T>();
+    if (x == 0 || x == inf<T>())
+        return x;
+    long long e = 0;
+    T m = splitExponent(x, e);
+    if (e & 1)
+    {
+        m *= 2;
+        e--;
+    }
+    // m in [1, 4): seed within 6%, Newton doubles the digits every step
+    T y = (m + 2) / 3;
+    for (int i = 0; i < 6; i++)
+        y = T(0.5) * (y + m / y);
+    return y * pow2<T>(e / 2);
+}
+
+// ln2 and pi/2 in pieces of 32 and 33 bits (plus a double tail), so that
+// k times a leading piece is exact in long double for any k the reductions
+// below produce. The literals are doubles on purpose.
+constexpr long double LN2_HI = 6.93147180369123816490e-01;
+constexpr long double LN2_LO = 1.90821492927058770002e-10;
+constexpr long double PIO2_1 = 1.57079632673412561417e+00;
+constexpr long double PIO2_2 = 6.07710050630396597660e-11;
+constexpr long double PIO2_3 = 2.02226624871116645580e-21;
+
+// e^x = 2^k * e^r, |r| <= ln2/2. r is formed in long double and e^r is the
+// Taylor series in Horner form, 1 + r (1 + r/2 (1 + r/3 (...))). 2^k is
+// applied in two halves so that e^x just below the overflow threshold
+// does not go through 2^k = inf.
+template <typename T>
+constexpr T Exp(T x)
+{
+    if (isNan(x))
+        return x;
+    if (x > T(11357.3))
+        return inf<T>();
+    if (x < T(-11400))
+        return 0;
+    long long k = roundToInt((long double)x * (1 / LN2));
+    T r = T(((long double)x - k * LN2_HI) - k * LN2_LO);
+    T p = 1;
+    for (int i = 27; i > 0; i--)
+        p = 1 + r * p / T(i);
+    return p * pow2<T>(k / 2) * pow2<T>(k - k / 2);
+}
+
+// ln x = k ln2 + ln m, m in [sqrt(1/2), sqrt(2)). With f = m - 1 (exact)
+// and s = f / (2 + f), ln m = f - (f^2/2 - s (f^2/2 + R)), R the sum of
+// 2 s^2i / (2i + 1) over i >= 1: f carries the leading bits unrounded.
+template <typename T>
+constexpr T Ln(T x)
+{
+    if (isNan(x) || x < 0)
+        return nan<T>();
+    if (x == 0)
+        return -inf<T>();
+    if (x == inf<T>())
+        return x;
+    long long k = 0;
+    T m = splitExponent(x, k);
+    if (m > T(SQRT2))
+    {
+        m *= T(0.5);
+        k++;
+    }
+    T f = m - 1;
+    T s = f / (2 + f);
+    T z = s * s;
+    T R = 0;
+    for (int i = 30; i > 0; i--)
+        R = z * (T(2) / T(2 * i + 1) + R);
+    T hfsq = T(0.5) * f * f;
+    T lnm = f - (hfsq - s * (hfsq + R));
+    return T(k * LN2_HI + (k * LN2_LO + lnm));
+}
+
+// x = q*(pi/2) + r, in long double with pi/2 in three pieces; accurate for
+// |x| < 2^20, which covers table ranges. Returns q mod 4.
+template <typename T>
+constexpr int reduceHalfPi(T x, T &r)
+{
+    long double lx = x;
+    long long q = roundToInt(lx * (2 * INV_PI));
+    r = T(((lx - q * PIO2_1) - q * PIO2_2) - q * PIO2_3);
+    return (int)(q & 3);
+}
+
+// r (1 - z/(2*3) (1 - z/(4*5) (...))), z = r^2, for |r| <= pi/4; the
+// leading r is added last, unrounded
+template <typename T>
+constexpr T sinSeries(T r)
+{
+    T z = r * r, p = 1;
+    for (int i = 12; i >= 2; i--)
+        p = 1 - z * p / T((2 * i) * (2 * i + 1));
+    return r - r * (z * p / 6);
+}
+
+// 1 - z/2 (1 - z/(3*4) (...)) for |r| <= pi/4, with the rounding error of
+// w = 1 - z/2 added back
+template <typename T>
+constexpr T cosSeries(T r)
+{
+    T z = r * r, p = 1;
+    for (int i = 12; i >= 3; i--)
+        p = 1 - z * p / T((2 * i - 1) * (2 * i));
+    T hz = T(0.5) * z;
+    T w = 1 - hz;
+    return w + (((1 - w) - hz) + hz * (z * p / 12));
+}
+
+template <typename T>
+constexpr T Sine(T x)
+{
+    if (isNan(x) || abs(x) == inf<T>())
+        return nan<T>();
+    if (x == 0)
+        return x;
+    T r = 0;
+    switch (reduceHalfPi(x, r))
+    {
+    case 0:
+        return sinSeries(r);
+    case 1:
+        return cosSeries(r);
+    case 2:
+        return -sinSeries(r);
+    default:
+        return -cosSeries(r);
+    }
+}
+
+template <typename T>
+constexpr T Cosine(T x)
+{
+    if (isNan(x) || abs(x) == inf<T>())
+        return nan<T>();
+    T r = 0;
+    switch (reduceHalfPi(x, r))
+    {
+    case 0:
+        return cosSeries(r);
+    case 1:
+        return -sinSeries(r);
+    case 2:
+        return -cosSeries(r);
+    default:
+        return sinSeries(r);
+    }
+}
+
+// atan x = atan c + atan t, t = (x - c) / (1 + x c), with c one of 0,
+// 1/2, 1, 3/2, inf picked so that |t| <= 7/16 (fdlibm's reduction).
+// atan c is a double pair, and atan t = t - t z (1/3 - z (1/5 - ...)).
+template <typename T>
+constexpr T arcTangent(T x)
+{
+    if (isNan(x) || x == 0)
+        return x;
+    const double atanHi[] = {4.63647609000806093515e-01, 7.85398163397448278999e-01,
+                             9.82793723247329054082e-01, 1.57079632679489655800e+00};
+    const double atanLo[] = {2.26987774529616870924e-17, 3.06161699786838301793e-17,
+                             1.39033110312309984516e-17, 6.12323399573676603587e-17};
+    T ax = abs(x), t = ax;
+    int id = -1;
+    if (ax >= T(2.4375))
+    {
+        id = 3;
+        t = -1 / ax;
+    }
+    else if (ax >= T(1.1875))
+    {
+        id = 2;
+        t = (ax - T(1.5)) / (1 + T(1.5) * ax);
+    }
+    else if (ax >= T(0.6875))
+    {
+        id = 1;
+        t = (ax - 1) / (ax + 1);
+    }
+    else if (ax >= T(0.4375))
+    {
+        id = 0;
+        t = (2 * ax - 1) / (2 + ax);
+    }
+    T z = t * t, p = 0;
+    for (int i = 40; i > 0; i--)
+        p = T(1) / T(2 * i + 1) - z * p;
+    T y = t - t * (z * p);
+    if (id >= 0)
+        y = T(atanHi[id]) - ((t * (z * p) - T(atanLo[id])) - t);
+    return x < 0 ? -y : y;
+}
+
+// ---- compile-time powers ----
+//
+// pow<N>(x) is x^N as a multiplication chain fixed at compile time: the
+// shorter of the binary chain (square for even N, one more multiply for
+// odd N) and the factor chain (x^N = (x^p)^(N/p), p the smallest prime
+// factor of N). pow<15> takes 5 multiplies instead of 6, pow<-N> is
+// 1 / pow<N>. Every multiply rounds, so the error grows with the chain;
+// iPower in cf.c stays within 1 ulp for any n.
+
+constexpr unsigned long long smallestFactor(unsigned long long n)
+{
+    for (unsigned long long p = 2; p * p <= n; p++)
+        if (n % p == 0)
+            return p;
+    return n;
+}
+
+// the factor chain is only tried below this, to bound compile time
+constexpr unsigned long long POW_FACTOR_MAX = 1ULL << 16;
+
+constexpr int powChainLength(unsigned long long n);
+
+constexpr int powBinaryLength(unsigned long long n)
+{
+    return n % 2 ? powChainLength(n - 1) + 1 : powChainLength(n / 2) + 1;
+}
+
+constexpr int powFactorLength(unsigned long long n)
+{
+    return powChainLength(smallestFactor(n)) + powChainLength(n / smallestFactor(n));
+}
+
+enum PowStep
+{
+    POW_ONE,
+    POW_SQUARE,
+    POW_MULTIPLY,
+    POW_FACTOR
+};
+
+constexpr PowStep powStep(unsigned long long n)
+{
+    if (n <= 1)
+        return POW_ONE;
+    if (n % 2 == 0)
+        return POW_SQUARE; // squaring is never beaten for even n
+    if (n < POW_FACTOR_MAX && smallestFactor(n) != n && powFactorLength(n) < powBinaryLength(n))
+        return POW_FACTOR;
+    return POW_MULTIPLY;
+}
+
+constexpr int powChainLength(unsigned long long n)
+{
+    return n <= 1 ? 0 : powStep(n) == POW_FACTOR ? powFactorLength(n) : powBinaryLength(n);
+}
+
+template <unsigned long long N, PowStep S = powStep(N)>
+struct PowChain;
+
+template <unsigned long long N>
+struct PowChain<N, POW_ONE>
+{
+    template <typename T>
+    static constexpr T apply(T x) { return N ? x : T(1); }
+};
+
+template <unsigned long long N>
+struct PowChain<N, POW_SQUARE>
+{
+    template <typename T>
+    static constexpr T apply(T x)
+    {
+        T h = PowChain<N / 2>::apply(x);
+        return h * h;
+    }
+};
+
+template <unsigned long long N>
+struct PowChain<N, POW_MULTIPLY>
+{
+    template <typename T>
+    static constexpr T apply(T x) { return PowChain<N - 1>::apply(x) * x; }
+};
+
+template <unsigned long long N>
+struct PowChain<N, POW_FACTOR>
+{
+    template <typename T>
+    static constexpr T apply(T x)
+    {
+        return PowChain<N / smallestFactor(N)>::apply(PowChain<smallestFactor(N)>::apply(x));
+    }
+};
+
+constexpr unsigned long long powMagnitude(long long n)
+{
+    return n < 0 ? -(unsigned long long)n : (unsigned long long)n;
+}
+
+template <long long N, typename T>
+constexpr T pow(T x)
+{
+    T y = PowChain<powMagnitude(N)>::apply(x);
+    return N < 0 ? T(1) / y : y;
+}
+
+// out[i] = in[i]^N; the loop body is straight-line code, so the compiler
+// vectorizes it
+template <long long N, typename T>
+inline void powBatch(const T *in, T *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+        out[i] = pow<N>(in[i]);
+}
+
+// ---- compile-time tables ----
+
+template <typename T, std::size_t N>
+struct Table
+{
+    T value[N];
+
+    constexpr const T &operator[](std::size_t i) const { return value[i]; }
+    static constexpr std::size_t size() { return N; }
+};
+
+// N samples of F at lo, lo + h, ..., hi (h = (hi - lo) / (N - 1))
+template <typename T, std::size_t N, T (*F)(T)>
+constexpr Table<T, N> makeTable(T lo, T hi)
+{
+    static_assert(N >= 2, "a table needs at least two samples");
+    Table<T, N> t{};
+    for (std::size_t i = 0; i < N; i++)
+        t.value[i] = F(lo + (hi - lo) * T(i) / T(N - 1));
+    return t;
+}
+
+// ---- interpolated-table fast mode ----
+
+// N - 1 equal intervals over [lo, hi], linear interpolation in between.
+// maxError is the largest |F - interpolant| seen at the interval midpoints,
+// where linear interpolation of a smooth function errs the most.
+template <typename T, std::size_t N>
+struct LerpTable
+{
+    T lo;
+    T hi;
+    T scale; // (N - 1) / (hi - lo)
+    T maxError;
+    T value[N];
+
+    // x is clamped into [lo, hi]
+    T operator()(T x) const
+    {
+        T t = (x - lo) * scale;
+        if (!(t > 0))
+            return value[0];
+        if (t >= T(N - 1))
+            return value[N - 1];
+        std::size_t i = (std::size_t)t;
+        T f = t - T(i);
+        return value[i] + f * (value[i + 1] - value[i]);
+    }
+};
+
+template <typename T, std::size_t N, T (*F)(T)>
+constexpr LerpTable<T, N> makeLerpTable(T lo, T hi)
+{
+    static_assert(N >= 2, "a table needs at least two samples");
+    LerpTable<T, N> t{};
+    t.lo = lo;
+    t.hi = hi;
+    t.scale = T(N - 1) / (hi - lo);
+    T h = (hi - lo) / T(N - 1);
+    for (std::size_t i = 0; i < N; i++)
+        t.value[i] = F(lo + h * T(i));
+    t.maxError = 0;
+    for (std::size_t i = 0; i + 1 < N; i++)
+    {
+        T mid = lo + h * (T(i) + T(0.5));
+        T err = abs(F(mid) - T(0.5) * (t.value[i] + t.value[i + 1]));
+        if (err > t.maxError)
+            t.maxError = err;
+    }
+    return t;
+}
+
+template <typename T>
+constexpr T exp2Frac(T f)
+{
+    return Exp(f * T(LN2));
+}
+
+template <typename T>
+constexpr T lnMantissa(T m)
+{
+    return Ln(m);
+}
+
+// 1025 points each: sin over one period (abs error 4.7e-6), 2^f on [0, 1]
+// (rel error 1.2e-7), ln m on [1, 2] (abs error 1.2e-7)
+constexpr std::size_t FAST_TABLE_SIZE = 1025;
+
+// a class template so that the out-of-class definitions below may live in
+// a header (C++14 still needs them when the tables are odr-used)
+template <typename D = void>
+struct FastTablesT
+{
+    static constexpr LerpTable<double, FAST_TABLE_SIZE> sine =
+        makeLerpTable<double, FAST_TABLE_SIZE, Sine<double>>(0.0, 2 * double(PI));
+    static constexpr LerpTable<double, FAST_TABLE_SIZE> exp2 =
+        makeLerpTable<double, FAST_TABLE_SIZE, exp2Frac<double>>(0.0, 1.0);
+    static constexpr LerpTable<double, FAST_TABLE_SIZE> ln =
+        makeLerpTable<double, FAST_TABLE_SIZE, lnMantissa<double>>(1.0, 2.0);
+};
+
+template <typename D>
+constexpr LerpTable<double, FAST_TABLE_SIZE> FastTablesT<D>::sine;
+template <typename D>
+constexpr LerpTable<double, FAST_TABLE_SIZE> FastTablesT<D>::exp2;
+template <typename D>
+constexpr LerpTable<double, FAST_TABLE_SIZE> FastTablesT<D>::ln;
+
+typedef FastTablesT<> FastTables;
+
+inline std::uint64_t toBits(double x)
+{
+    std::uint64_t u = 0;
+    std::memcpy(&u, &x, sizeof u);
+    return u;
+}
+
+inline double fromBits(std::uint64_t u)
+{
+    double x = 0;
+    std::memcpy(&x, &u, sizeof x);
+    return x;
+}
+
+// floor(y) for |y| < 2^51: adding 1.5 * 2^52 rounds to the nearest integer,
+// one is taken off if that rounded up. Larger y are integers already.
+inline double floorSmall(double y)
+{
+    const double shift = 6755399441055744.0; // 1.5 * 2^52
+    if (!(abs(y) < 2251799813685248.0))
+        return y;
+    double k = (y + shift) - shift;
+    return k > y ? k - 1 : k;
+}
+
+inline double fastSine(double x)
+{
+    const double period = 2 * double(PI);
+    double t = x - period * floorSmall(x * (1 / period));
+    return FastTables::sine(t);
+}
+
+inline double fastCosine(double x)
+{
+    return fastSine(x + double(MY_PI_BY_2));
+}
+
+// 2^k * 2^f with k = floor(x / ln2); overflows to inf, underflows to 0
+inline double fastExp(double x)
+{
+    if (!(x == x))
+        return x;
+    if (x > 709.78)
+        return inf<double>();
+    if (x < -745.13)
+        return 0;
+    double y = x * double(1 / LN2);
+    double k = floorSmall(y);
+    int n = (int)k;
+    double f = FastTables::exp2(y - k);
+    if (n < -1022)
+    {
+        // 2^n is subnormal: scale in two steps, the second one rounds
+        f *= fromBits((std::uint64_t)(n + 54 + 1023) << 52);
+        return f * 5.5511151231257827e-17; // 2^-54
+    }
+    return f * fromBits((std::uint64_t)(n + 1023) << 52);
+}
+
+inline double fastLn(double x)
+{
+    if (x == 0)
+        return -inf<double>();
+    if (!(x > 0))
+        return nan<double>();
+    if (x == inf<double>())
+        return x;
+    int e = -1023;
+    if (x < std::numeric_limits<double>::min())
+    {
+        x *= 18014398509481984.0; // 2^54, x was subnormal
+        e -= 54;
+    }
+    std::uint64_t u = toBits(x);
+    e += (int)(u >> 52);
+    double m = fromBits((u & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL); // [1, 2)
+    return FastTables::ln(m) + double(e) * double(LN2);
+}
+
+} // namespace cfconst
+
+#endif
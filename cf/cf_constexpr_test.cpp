@@ -0,0 +1,136 @@
+// Tests of cf_constexpr.h: tables built at compile time are checked with
+// static_assert, the constexpr functions against the long double cf
+// functions in ULP, and the fast mode against its stated table errors.
+// The exit status is the number of failures.
+//
+// Build (C++14 is the oldest standard the header supports; gnu++14 because
+// cf.c, compiled along as C++, uses hexadecimal float literals):
+//   g++ -std=gnu++14 -O2 cf/cf_constexpr_test.cpp cf/cf.c -o cf_constexpr_test
+
+#include "cf_constexpr.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+
+static int failures = 0;
+static const double DENORM_MIN = std::numeric_limits<double>::denorm_min();
+
+#define CHECK(cond)                                                                                             \
+    do                                                                                                          \
+    {                                                                                                           \
+        if (!(cond))                                                                                            \
+        {                                                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                            \
+            ++failures;                                                                                         \
+        }                                                                                                       \
+    } while (0)
+
+// ---- compile time ----
+
+constexpr auto sinTab = cfconst::makeTable<double, 9, cfconst::Sine<double>>(0.0, double(PI));
+static_assert(sinTab.size() == 9, "table size");
+static_assert(sinTab[0] == 0, "sin 0");
+static_assert(sinTab[4] == 1, "sin pi/2 rounds to 1");
+static_assert(cfconst::abs(sinTab[2] - 0.70710678118654752) < 2e-16, "sin pi/4");
+static_assert(cfconst::abs(sinTab[8]) < 2e-16, "sin pi");
+
+constexpr auto expTab = cfconst::makeTable<double, 3, cfconst::Exp<double>>(-1.0, 1.0);
+static_assert(expTab[1] == 1, "e^0");
+static_assert(cfconst::abs(expTab[2] - 2.7182818284590452) < 5e-16, "e^1");
+
+static_assert(cfconst::Ln(1.0) == 0, "ln 1");
+static_assert(cfconst::Sqrt(2.25) == 1.5, "sqrt");
+static_assert(cfconst::abs(4 * cfconst::arcTangent(1.0) - 3.14159265358979323) < 5e-16, "4 atan 1");
+static_assert(cfconst::pow<10>(2.0) == 1024 && cfconst::pow<-2>(4.0) == 0.0625, "pow chain");
+static_assert(cfconst::FastTables::sine.maxError < 5e-6 && cfconst::FastTables::ln.maxError < 2e-7,
+              "fast table errors");
+
+// ---- run time ----
+
+// |got - ref| in units of the last place of ref in T
+template <typename T>
+static long double ulpError(T got, long double ref)
+{
+    int e = ilogbl(ref);
+    int minExp = std::numeric_limits<T>::min_exponent - 1;
+    if (ref == 0 || e < minExp)
+        e = minExp;
+    return fabsl((long double)got - ref) / ldexpl(1, e - (std::numeric_limits<T>::digits - 1));
+}
+
+// largest error of f against ref over n points evenly spread on [lo, hi]
+template <typename T>
+static long double maxUlp(T (*f)(T), long double (*ref)(long double), long double lo, long double hi)
+{
+    const int n = 20000;
+    long double worst = 0;
+    for (int i = 0; i <= n; i++)
+    {
+        T x = (T)(lo + (hi - lo) * i / n);
+        long double e = ulpError<T>(f(x), ref(x));
+        if (e > worst)
+            worst = e;
+    }
+    return worst;
+}
+
+// the stated 1.5 ULP of the header, in float and in double
+template <typename T>
+static void testAccuracy()
+{
+    const long double bound = 1.5;
+    CHECK(maxUlp<T>(cfconst::Exp<T>, Exp, -80, 80) <= bound);
+    CHECK(maxUlp<T>(cfconst::Exp<T>, Exp, -1, 1) <= bound);
+    CHECK(maxUlp<T>(cfconst::Ln<T>, Ln, 1e-30L, 1e30L) <= bound);
+    CHECK(maxUlp<T>(cfconst::Ln<T>, Ln, 0.5, 2) <= bound);
+    CHECK(maxUlp<T>(cfconst::Sqrt<T>, Sqrt, 0, 1e6L) <= bound);
+    CHECK(maxUlp<T>(cfconst::Sine<T>, Sine, -1e5L, 1e5L) <= bound);
+    CHECK(maxUlp<T>(cfconst::Sine<T>, Sine, -4, 4) <= bound);
+    CHECK(maxUlp<T>(cfconst::Cosine<T>, Cosine, -1e5L, 1e5L) <= bound);
+    CHECK(maxUlp<T>(cfconst::Cosine<T>, Cosine, -4, 4) <= bound);
+    CHECK(maxUlp<T>(cfconst::arcTangent<T>, arcTangent, -5, 5) <= bound);
+    CHECK(maxUlp<T>(cfconst::arcTangent<T>, arcTangent, -1e6L, 1e6L) <= bound);
+}
+
+static void testEdges()
+{
+    CHECK(cfconst::Exp(709.78) < DBL_MAX && cfconst::Exp(709.79) == cfconst::inf<double>());
+    CHECK(ulpError(cfconst::Exp(-740.0), Exp(-740)) <= 1);
+    CHECK(cfconst::Ln(DENORM_MIN) == (double)Ln(DENORM_MIN));
+    CHECK(std::signbit(cfconst::Sine(-0.0)) && std::signbit(cfconst::arcTangent(-0.0)));
+    CHECK(cfconst::isNan(cfconst::Ln(-1.0)) && cfconst::isNan(cfconst::Sine(cfconst::inf<double>())));
+}
+
+// the fast mode stays within the error each table records, plus the
+// rounding of the scaling
+static void testFastMode()
+{
+    typedef cfconst::FastTables t;
+    for (int i = -2000; i <= 2000; i++)
+    {
+        double x = i * 0.0137;
+        CHECK(fabsl(cfconst::fastSine(x) - Sine(x)) <= t::sine.maxError * 1.01L);
+        CHECK(fabsl(cfconst::fastCosine(x) - Cosine(x)) <= t::sine.maxError * 1.01L);
+        CHECK(fabsl(cfconst::fastExp(x) / Exp(x) - 1) <= t::exp2.maxError * 1.01L);
+    }
+    for (double x : {1e-300, 0.3, 1.0, 7.5, 1e300, DBL_MIN, DENORM_MIN, 3 * DENORM_MIN})
+        CHECK(fabsl(cfconst::fastLn(x) - Ln(x)) <= t::ln.maxError * 1.01L + 1e-13L);
+    // 2^k subnormal: a single rounding of the interpolant
+    CHECK(fabsl(cfconst::fastExp(-720.0) / Exp(-720) - 1) <= t::exp2.maxError * 1.01L + 1e-10L);
+    CHECK(cfconst::fastExp(-746.0) == 0 && cfconst::fastExp(710.0) == cfconst::inf<double>());
+    CHECK(cfconst::fastLn(0.0) == -cfconst::inf<double>() && cfconst::isNan(cfconst::fastLn(-1.0)));
+}
+
+int main()
+{
+    testAccuracy<double>();
+    testAccuracy<float>();
+    testEdges();
+    testFastMode();
+    if (failures)
+        fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        printf("all constexpr tests passed\n");
+    return failures;
+}
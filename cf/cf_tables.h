@@ -0,0 +1,95 @@
+#ifndef CF_TABLES_H_INCLUDED
+#define CF_TABLES_H_INCLUDED
+
+// Double-double tables of the table-driven e^x and ln x, shared by the
+// adaptive functions (cf_adaptive.c) and the vector pow (cf_vec.h).
+
+// e^x: x = (32k + j) * ln2/32 + r, |r| <= ln2/64
+#define EXP_INV_LN2_32 4.61662413084468284e+01
+#define EXP_LN2_32_HI 2.16608493924468348e-02 // 37 bits, n * HI is exact
+#define EXP_LN2_32_LO 5.14560924465533822e-14
+
+// 2^(j/32) = expHi[j] + expLo[j], j = 0..31
+static const double expHi[32] = {
+    1.00000000000000000e+00, 1.02189714865411663e+00, 1.04427378242741375e+00,
+    1.06714040067682370e+00, 1.09050773266525769e+00, 1.11438674259589243e+00,
+    1.13878863475669156e+00, 1.16372485877757748e+00, 1.18920711500272103e+00,
+    1.21524735998046896e+00, 1.24185781207348400e+00, 1.26905095719173322e+00,
+    1.29683955465100964e+00, 1.32523664315974132e+00, 1.35425554693689265e+00,
+    1.38390988196383202e+00, 1.41421356237309515e+00, 1.44518080697704665e+00,
+    1.47682614593949935e+00, 1.50916442759342284e+00, 1.54221082540794074e+00,
+    1.57598084510788650e+00, 1.61049033194925428e+00, 1.64575547815396495e+00,
+    1.68179283050742900e+00, 1.71861929812247793e+00, 1.75625216037329945e+00,
+    1.79470907500310717e+00, 1.83400808640934243e+00, 1.87416763411029996e+00,
+    1.91520656139714740e+00, 1.95714412417540018e+00};
+static const double expLo[32] = {
+    0.00000000000000000e+00, 5.10922502897344389e-17, 8.55188970553796489e-17,
+    -7.89985396684158212e-17, -3.04678207981247115e-17, 1.04102784568455710e-16,
+    8.91281267602540778e-17, 3.82920483692409350e-17, 3.98201523146564611e-17,
+    -7.71263069268148813e-17, 4.65802759183693679e-17, 2.66793213134218610e-18,
+    2.53825027948883150e-17, -2.85873121003886137e-17, 7.70094837980298946e-17,
+    -6.77051165879478629e-17, -9.66729331345291345e-17, -3.02375813499398732e-17,
+    -3.48399455689279580e-17, -1.01645532775429504e-16, 7.94983480969762086e-17,
+    -1.01369164712783040e-17, 2.47071925697978879e-17, -1.01256799136747726e-16,
+    8.19901002058149652e-17, -1.85138041826311099e-17, 2.96014069544887331e-17,
+    1.82274584279120868e-17, 3.28310722424562720e-17, -6.12276341300414256e-17,
+    -1.06199460561959626e-16, 8.96076779103666777e-17};
+
+// c_i = 1 + i/64 for i = -19..27, the grid that m in [sqrt(1/2), sqrt(2))
+// is reduced to, with 1/c_i and ln c_i as hi + lo (cf_adaptive.c adds the
+// log10 and log2 rows)
+#define LN_TABLE_MIN -19
+#define LN_TABLE_SIZE 47
+static const double invC[LN_TABLE_SIZE] = {
+    1.42222222222222228e+00, 1.39130434782608692e+00, 1.36170212765957444e+00,
+    1.33333333333333326e+00, 1.30612244897959173e+00, 1.28000000000000003e+00,
+    1.25490196078431371e+00, 1.23076923076923084e+00, 1.20754716981132071e+00,
+    1.18518518518518512e+00, 1.16363636363636358e+00, 1.14285714285714279e+00,
+    1.12280701754385959e+00, 1.10344827586206895e+00, 1.08474576271186440e+00,
+    1.06666666666666665e+00, 1.04918032786885251e+00, 1.03225806451612900e+00,
+    1.01587301587301582e+00, 1.00000000000000000e+00, 9.84615384615384670e-01,
+    9.69696969696969724e-01, 9.55223880597014907e-01, 9.41176470588235281e-01,
+    9.27536231884057982e-01, 9.14285714285714257e-01, 9.01408450704225372e-01,
+    8.88888888888888840e-01, 8.76712328767123239e-01, 8.64864864864864913e-01,
+    8.53333333333333388e-01, 8.42105263157894690e-01, 8.31168831168831224e-01,
+    8.20512820512820484e-01, 8.10126582278481000e-01, 8.00000000000000044e-01,
+    7.90123456790123413e-01, 7.80487804878048808e-01, 7.71084337349397630e-01,
+    7.61904761904761862e-01, 7.52941176470588225e-01, 7.44186046511627897e-01,
+    7.35632183908045967e-01, 7.27272727272727293e-01, 7.19101123595505598e-01,
+    7.11111111111111138e-01, 7.03296703296703352e-01};
+static const double lnHi[LN_TABLE_SIZE] = {
+    -3.52220593589352093e-01, -3.30241686870576867e-01, -3.08735481649613286e-01,
+    -2.87682072451780901e-01, -2.67062785249045254e-01, -2.46860077931525784e-01,
+    -2.27057450635346075e-01, -2.07639364778244490e-01, -1.88591169807550030e-01,
+    -1.69899036795397473e-01, -1.51549898127200933e-01, -1.33531392624522627e-01,
+    -1.15831815525121701e-01, -9.84400728132525243e-02, -8.13456394539524008e-02,
+    -6.45385211375711781e-02, -4.80092191863606063e-02, -3.17486983145802981e-02,
+    -1.57483569681391676e-02, 0.00000000000000000e+00, 1.55041865359652545e-02,
+    3.07716586667536873e-02, 4.58095360312942013e-02, 6.06246218164348399e-02,
+    7.52234212375875316e-02, 8.96121586896871380e-02, 1.03796793681643559e-01,
+    1.17783035656383456e-01, 1.31576357788719261e-01, 1.45182009844497889e-01,
+    1.58605030176638573e-01, 1.71850256926659228e-01, 1.84922338494011990e-01,
+    1.97825743329919868e-01, 2.10564769107349642e-01, 2.23143551314209765e-01,
+    2.35566071312766911e-01, 2.47836163904581269e-01, 2.59957524436926046e-01,
+    2.71933715483641758e-01, 2.83768173130644619e-01, 2.95464212893835898e-01,
+    3.07025035294911874e-01, 3.18453731118534589e-01, 3.29753286372467980e-01,
+    3.40926586970593193e-01, 3.51976423157178198e-01};
+static const double lnLo[LN_TABLE_SIZE] = {
+    -5.72333169491824847e-18, 1.08283216374838579e-17, 1.61991860851481022e-17,
+    -2.60716061644256398e-17, 7.32891532732016949e-18, -1.36174337174836802e-17,
+    -9.55141576273848843e-18, -1.20532432166861289e-17, 7.43216421919692505e-18,
+    4.86800876443907079e-19, -5.16695936846155944e-18, 3.66445766366008474e-18,
+    -4.33848436980809596e-18, 4.43900963367513588e-18, -5.07707635593116993e-18,
+    6.47048666169293300e-18, -1.43909033472922047e-18, -3.03822630846808579e-18,
+    -1.00215786305289737e-18, 0.00000000000000000e+00, -3.27832102289242913e-19,
+    1.04317320290059678e-18, 1.90295986647425706e-18, 2.64240259387269342e-18,
+    -5.93060419629324072e-18, -5.42681293366471353e-18, 5.47772415726659013e-18,
+    -1.19716857475936773e-18, 1.11230008797295880e-17, 8.24241878302247539e-18,
+    1.12570038721825922e-17, -6.02245382101137048e-18, 3.02366141535740643e-18,
+    1.28211943729801419e-17, -4.24940531472989533e-18, -9.09127059732479905e-18,
+    -2.39433714951873546e-18, -1.24322095787025232e-17, 2.06980693897893503e-17,
+    7.83319637697442012e-19, -2.03266558112665612e-17, -2.16461086040598997e-17,
+    -1.23199162001019643e-17, 2.71147793673262360e-17, 2.12202061619694602e-18,
+    1.74671364435447471e-17, -1.29538930301919629e-17};
+
+#endif
@@ -0,0 +1,665 @@
+/* One precision tier of the cf functions.
+ *
+ * Included from cf_tiers.c once per tier with these defined:
+ *   CF_T            floating type of the tier (float, double)
+ *   CF_TNAME(x)     x with the tier suffix (xF, xD)
+ *   CF_UINT         unsigned integer type as wide as CF_T
+ *   CF_MANT_BITS    stored mantissa bits (23, 52)
+ *   CF_EXP_BIAS     exponent bias (127, 1023)
+ *   CF_EPS          machine epsilon of CF_T
+ * plus the tier constants (CF_LN2_HI, CF_LOG10_2_HI, CF_EXP_MAX, ...) and
+ * the coefficient tables CF_TNAME(expPoly), CF_TNAME(lnPoly), CF_TNAME(sinPoly),
+ * CF_TNAME(cosPoly), CF_TNAME(atanPoly), CF_TNAME(atanHi), CF_TNAME(atanLo).
+ * Polynomial degrees come from the tables, so each tier only pays for the
+ * accuracy its format can hold. No include guard on purpose. */
+
+#define T CF_T
+#define TN(x) CF_TNAME(x)
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+#define CF_ONE_BITS ((CF_UINT)CF_EXP_BIAS << CF_MANT_BITS)
+#define CF_MANT_MASK (((CF_UINT)1 << CF_MANT_BITS) - 1)
+#define CF_INF ((T)(1.0 / 0.0))
+#define CF_NAN ((T)(0.0 / 0.0))
+
+static inline CF_UINT TN(toBits)(T x)
+{
+    CF_UINT u;
+    memcpy(&u, &x, sizeof u);
+    return u;
+}
+
+static inline T TN(fromBits)(CF_UINT u)
+{
+    T x;
+    memcpy(&x, &u, sizeof x);
+    return x;
+}
+
+static inline T TN(horner)(const T *c, int n, T z)
+{
+    T p = c[n - 1];
+    for (int i = n - 2; i >= 0; i--)
+        p = p * z + c[i];
+    return p;
+}
+
+// y * 2^k, split in two factors so subnormal results and k = max exponent + 1 work
+static inline T TN(scale2)(T y, int k)
+{
+    int k1 = k / 2;
+    int k2 = k - k1;
+    return y * TN(fromBits)((CF_UINT)(k1 + CF_EXP_BIAS) << CF_MANT_BITS) *
+           TN(fromBits)((CF_UINT)(k2 + CF_EXP_BIAS) << CF_MANT_BITS);
+}
+
+// a = hi + lo exactly, with hi = a rounded to half the mantissa (Dekker)
+static inline T TN(splitHigh)(T a)
+{
+    T t = a * CF_SPLIT;
+    return t - (t - a);
+}
+
+// (ah + al) * (bh + bl) as hi + *lo, the product ah * bh exactly
+static T TN(ddMul)(T ah, T al, T bh, T bl, T *lo)
+{
+    T p = ah * bh;
+    T ahh = TN(splitHigh)(ah), bhh = TN(splitHigh)(bh);
+    T ahl = ah - ahh, bhl = bh - bhh;
+    T e = ((ahh * bhh - p) + ahh * bhl + ahl * bhh) + ahl * bhl;
+    e += ah * bl + al * bh;
+    T s = p + e;
+    *lo = e - (s - p);
+    return s;
+}
+
+// x^m as hi + *lo by binary powering in double T, so the rounding does not
+// grow with m the way a plain square-and-multiply chain does
+static T TN(powSquaring)(T x, unsigned long long m, T *lo)
+{
+    T yh = 1, yl = 0, xl = 0;
+    for (;;)
+    {
+        if (m & 1)
+            yh = TN(ddMul)(yh, yl, x, xl, &yl);
+        m >>= 1;
+        if (!m)
+        {
+            *lo = yl;
+            return yh;
+        }
+        x = TN(ddMul)(x, xl, x, xl, &xl);
+    }
+}
+
+// as the long double iPower: x^-2 to x^3 by plain multiplies, up to x^+-64
+// in double T while the splits cannot overflow and the low parts stay
+// normal, anything else rounded from the wider format's iPower
+T TN(iPower)(T x, long long n)
+{
+    if (n == 0)
+        return 1;
+    if (!(x == x))
+        return x;
+    unsigned long long m = n < 0 ? -(unsigned long long)n : (unsigned long long)n;
+    if ((n >= -2 && n <= 3) || x == 0 || ABS(x) == CF_INF)
+    {
+        T y = m == 1 ? x : m == 2 ? x * x : m == 3 ? x * x * x : (m & 1) ? x : x * x;
+        return n > 0 ? y : 1 / y;
+    }
+    if (m <= 64)
+    {
+        T lo;
+        T hi = TN(powSquaring)(x, m, &lo);
+        if (ABS(hi) >= CF_POW_LO && ABS(hi) <= CF_POW_HI)
+        {
+            if (n > 0)
+                return hi + lo;
+            // q = 1/x^m, corrected by the residual 1 - x^m * q
+            T q = 1 / hi;
+            T e, p = TN(ddMul)(hi, 0, q, 0, &e);
+            return q + q * (((1 - p) - e) - lo * q);
+        }
+    }
+    return (T)CF_WIDE_IPOWER(x, n);
+}
+
+T TN(Sqrt)(T x)
+{
+    if (!(x == x) || x == CF_INF || x == 0)
+        return x;
+    if (x < 0)
+        return CF_NAN;
+
+    int k = 0;
+    if (x < CF_MIN_NORMAL)
+    {
+        x *= CF_TWO_MANT * CF_TWO_MANT;
+        k = -(CF_MANT_BITS + 1);
+    }
+    // halving the biased exponent gives a seed within 6%
+    T term = TN(fromBits)((TN(toBits)(x) >> 1) + (CF_ONE_BITS >> 1));
+    term = (term + x / term) * (T)0.5;
+    for (int i = 0; i < 8; i++)
+    {
+        T next = (term + x / term) * (T)0.5;
+        if (next >= term)
+            break;
+        term = next;
+    }
+    return k ? TN(scale2)(term, k) : term;
+}
+
+T TN(RSqrt)(T x)
+{
+    if (!(x == x))
+        return x;
+    if (x < 0)
+        return CF_NAN;
+    if (x == 0)
+        return CF_INF;
+    if (x == CF_INF)
+        return 0;
+
+    int k = 0;
+    if (x < CF_MIN_NORMAL)
+    {
+        x *= CF_TWO_MANT * CF_TWO_MANT;
+        k = CF_MANT_BITS + 1;
+    }
+    T y = TN(fromBits)(CF_RSQRT_MAGIC - (TN(toBits)(x) >> 1));
+    for (int i = 0; i < 8; i++)
+    {
+        T c = (T)0.5 - (T)0.5 * x * y * y;
+        y += y * c;
+        if (ABS(c) <= CF_EPS)
+            break;
+    }
+    return k ? TN(scale2)(y, k) : y;
+}
+
+// x = k*ln2 + r, |r| <= ln2/2, e^r from the tier polynomial
+T TN(Exp)(T x)
+{
+    if (!(x == x))
+        return x;
+    if (x > CF_EXP_MAX)
+        return CF_INF;
+    if (x < CF_EXP_MIN)
+        return 0;
+
+    int k = (int)(x * (T)LGE + (x < 0 ? (T)-0.5 : (T)0.5));
+    T r = (x - k * CF_LN2_HI) - k * CF_LN2_LO;
+    return TN(scale2)(TN(horner)(TN(expPoly), COUNT(TN(expPoly)), r), k);
+}
+
+// x = 2^k * m with m in [sqrt(1/2), sqrt(2)), s = (m-1)/(m+1), polynomial
+// in s^2. Returns ln m, with k in *k; x must be finite and > 0.
+static T TN(lnKernel)(T x, int *k)
+{
+    *k = 0;
+    if (x < CF_MIN_NORMAL)
+    {
+        x *= CF_TWO_MANT;
+        *k = -(CF_MANT_BITS + 1);
+    }
+    CF_UINT u = TN(toBits)(x) + (CF_ONE_BITS - CF_SQRT_HALF_BITS);
+    *k += (int)(u >> CF_MANT_BITS) - CF_EXP_BIAS;
+    T m = TN(fromBits)((u & CF_MANT_MASK) + CF_SQRT_HALF_BITS);
+
+    T f = m - 1;
+    T s = f / (2 + f);
+    T z = s * s;
+    T R = z * TN(horner)(TN(lnPoly), COUNT(TN(lnPoly)), z);
+    T hfsq = (T)0.5 * f * f;
+    return f - (hfsq - s * (hfsq + R));
+}
+
+// NaN, +inf and x <= 0; returns 1 if *y is the answer
+static int TN(lnSpecial)(T x, T *y)
+{
+    if (!(x == x) || x == CF_INF)
+        *y = x;
+    else if (x == 0)
+        *y = -CF_INF;
+    else if (x < 0)
+        *y = CF_NAN;
+    else
+        return 0;
+    return 1;
+}
+
+T TN(Ln)(T x)
+{
+    T y;
+    if (TN(lnSpecial)(x, &y))
+        return y;
+    int k;
+    T lm = TN(lnKernel)(x, &k);
+    return k * CF_LN2_HI + (k * CF_LN2_LO + lm);
+}
+
+// e^x - 1 without the cancellation near 0: the exp polynomial minus its constant term
+static T TN(expm1)(T x)
+{
+    if (ABS(x) < (T)0.5 * (T)LN2)
+        return x * TN(horner)(TN(expPoly) + 1, COUNT(TN(expPoly)) - 1, x);
+    return TN(Exp)(x) - 1;
+}
+
+// ln(1 + x); the factor x / (u - 1) cancels the rounding of u = 1 + x
+static T TN(ln1p)(T x)
+{
+    T u = 1 + x;
+    if (u == 1)
+        return x;
+    return TN(Ln)(u) * (x / (u - 1));
+}
+
+// k*log10(2) + ln(m)*log10(e), log10(2) split so that k * HI is exact
+T TN(Log)(T x)
+{
+    T y;
+    if (TN(lnSpecial)(x, &y))
+        return y;
+    int k;
+    T lm = TN(lnKernel)(x, &k);
+    return k * CF_LOG10_2_HI + (k * CF_LOG10_2_LO + lm * (T)LOGE);
+}
+
+// k + ln(m)*log2(e): exact for powers of two
+T TN(Lg)(T x)
+{
+    T y;
+    if (TN(lnSpecial)(x, &y))
+        return y;
+    int k;
+    T lm = TN(lnKernel)(x, &k);
+    return k + lm * (T)LGE;
+}
+
+static inline T TN(sinKernel)(T r)
+{
+    T z = r * r;
+    return r + r * z * TN(horner)(TN(sinPoly), COUNT(TN(sinPoly)), z);
+}
+
+// 1 - z/2 rounded once, with the tail added to its rounding error (fdlibm)
+static inline T TN(cosKernel)(T r)
+{
+    T z = r * r;
+    T hz = (T)0.5 * z;
+    T w = 1 - hz;
+    return w + (((1 - w) - hz) + z * z * TN(horner)(TN(cosPoly), COUNT(TN(cosPoly)), z));
+}
+
+void TN(SinCos)(T x, T *s, T *c)
+{
+    if (!(ABS(x) <= CF_TRIG_MAX))
+    {
+        // huge, infinite or NaN: the long double engine reduces those exactly
+        long double sl, cl;
+        SinCos(x, &sl, &cl);
+        *s = (T)sl;
+        *c = (T)cl;
+        return;
+    }
+    double rd;
+    int q = reduceTier(x, &rd);
+    T r = (T)rd;
+    T sr = TN(sinKernel)(r), cr = TN(cosKernel)(r);
+    switch (q)
+    {
+    case 0:
+        *s = sr;
+        *c = cr;
+        break;
+    case 1:
+        *s = cr;
+        *c = -sr;
+        break;
+    case 2:
+        *s = -sr;
+        *c = -cr;
+        break;
+    default:
+        *s = -cr;
+        *c = sr;
+        break;
+    }
+}
+
+T TN(Sine)(T x)
+{
+    if (x == 0)
+        return x;
+    T s, c;
+    TN(SinCos)(x, &s, &c);
+    return s;
+}
+
+T TN(Cosine)(T x)
+{
+    T s, c;
+    TN(SinCos)(x, &s, &c);
+    return c;
+}
+
+T TN(Tangent)(T x)
+{
+    if (x == 0)
+        return x;
+    T s, c;
+    TN(SinCos)(x, &s, &c);
+    return s / c;
+}
+
+T TN(Cosecant)(T x)
+{
+    T s = TN(Sine)(x);
+    if (s == 0)
+        return CF_INF;
+    return 1 / s;
+}
+
+T TN(Secant)(T x)
+{
+    T c = TN(Cosine)(x);
+    if (c == 0)
+        return CF_INF;
+    return 1 / c;
+}
+
+T TN(Cotangent)(T x)
+{
+    T s, c;
+    TN(SinCos)(x, &s, &c);
+    if (s == 0)
+        return CF_INF;
+    return c / s;
+}
+
+// fdlibm-style: reduce |x| to one of five intervals around breakpoints
+// with atan known exactly (atanHi + atanLo), then an odd polynomial
+T TN(arcTangent)(T x)
+{
+    if (!(x == x))
+        return x;
+    T ax = ABS(x);
+    if (ax > CF_ATAN_HUGE)
+        return x > 0 ? TN(atanHi)[3] + TN(atanLo)[3] : -TN(atanHi)[3] - TN(atanLo)[3];
+    if (ax < CF_ATAN_TINY)
+        return x;
+
+    int id;
+    if (ax < (T)0.4375)
+        id = -1;
+    else if (ax < (T)0.6875)
+    {
+        id = 0;
+        ax = (2 * ax - 1) / (2 + ax);
+    }
+    else if (ax < (T)1.1875)
+    {
+        id = 1;
+        ax = (ax - 1) / (ax + 1);
+    }
+    else if (ax < (T)2.4375)
+    {
+        id = 2;
+        ax = (ax - (T)1.5) / (1 + (T)1.5 * ax);
+    }
+    else
+    {
+        id = 3;
+        ax = -1 / ax;
+    }
+    T z = ax * ax;
+    T s = z * TN(horner)(TN(atanPoly), COUNT(TN(atanPoly)), z);
+    if (id < 0)
+        return x - x * s;
+    T y = TN(atanHi)[id] - ((ax * s - TN(atanLo)[id]) - ax);
+    return x < 0 ? -y : y;
+}
+
+static int TN(isNegative)(T x)
+{
+    return x < 0 || (x == 0 && 1 / x < 0);
+}
+
+// pi/2 - atan(a) for 0 <= a <= 1, with pi/2 in two pieces
+static T TN(atanComplement)(T a)
+{
+    return TN(atanHi)[3] - (TN(arcTangent)(a) - TN(atanLo)[3]);
+}
+
+// see arcTangent2 in cf.c
+T TN(arcTangent2)(T y, T x)
+{
+    if (!(x == x) || !(y == y))
+        return x + y;
+    T ax = ABS(x), ay = ABS(y), a;
+    if (ay == 0)
+        return TN(isNegative)(x) ? (TN(isNegative)(y) ? -(T)PI : (T)PI) : y;
+    if (ax == CF_INF || ay == CF_INF)
+    {
+        if (ax != CF_INF)
+            a = (T)MY_PI_BY_2;
+        else if (ay != CF_INF)
+            a = TN(isNegative)(x) ? (T)PI : 0;
+        else
+            a = TN(isNegative)(x) ? (T)(3 * MY_PI_BY_4) : (T)MY_PI_BY_4;
+        return y < 0 ? -a : a;
+    }
+    T hi = TN(atanHi)[3], lo = TN(atanLo)[3];
+    if (ay <= ax)
+    {
+        a = TN(arcTangent)(ay / ax);
+        if (TN(isNegative)(x))
+            a = 2 * hi - (a - 2 * lo);
+    }
+    else
+    {
+        a = TN(arcTangent)(ax / ay);
+        a = TN(isNegative)(x) ? hi + (a + lo) : hi - (a - lo);
+    }
+    return y < 0 ? -a : a;
+}
+
+T TN(arcSine)(T x)
+{
+    if (!(ABS(x) <= 1))
+        return CF_NAN;
+    return TN(arcTangent2)(x, TN(Sqrt)((1 - x) * (1 + x)));
+}
+
+T TN(arcCosine)(T x)
+{
+    if (!(ABS(x) <= 1))
+        return CF_NAN;
+    return TN(arcTangent2)(TN(Sqrt)((1 - x) * (1 + x)), x);
+}
+
+// sqrt(x^2 - 1) for |x| >= 1; past 1/sqrt(eps) it rounds to |x|
+static T TN(secantLeg)(T ax)
+{
+    return ax > 1 / CF_EPS ? ax : TN(Sqrt)((ax - 1) * (ax + 1));
+}
+
+T TN(arcCosecant)(T x)
+{
+    if (!(ABS(x) >= 1))
+        return CF_NAN;
+    return TN(arcTangent2)(x < 0 ? -1 : 1, TN(secantLeg)(ABS(x)));
+}
+
+T TN(arcSecant)(T x)
+{
+    if (!(ABS(x) >= 1))
+        return CF_NAN;
+    return TN(arcTangent2)(TN(secantLeg)(ABS(x)), x < 0 ? -1 : 1);
+}
+
+T TN(arcCotangent)(T x)
+{
+    if (!(x == x))
+        return x;
+    T ax = ABS(x);
+    T y = ax >= 1 ? TN(arcTangent)(1 / ax) : TN(atanComplement)(ax);
+    return TN(isNegative)(x) ? -y : y;
+}
+
+// sinh and cosh of ax >= 0 from one exponential (see sinhCoshKernel in cf.c)
+static void TN(sinhCoshKernel)(T ax, T *s, T *c)
+{
+    if (ax < 1)
+    {
+        T em = TN(expm1)(ax);
+        T d = em / (em + 1);
+        *s = (T)0.5 * (em + d);
+        *c = 1 + (T)0.5 * em * d;
+    }
+    else if (ax <= CF_EXP_MAX)
+    {
+        T e = TN(Exp)(ax);
+        T inv = 1 / e;
+        *s = (T)0.5 * (e - inv);
+        *c = (T)0.5 * (e + inv);
+    }
+    else
+    {
+        T h = TN(Exp)((T)0.5 * ax);
+        *s = *c = ((T)0.5 * h) * h;
+    }
+}
+
+void TN(SinhCosh)(T x, T *s, T *c)
+{
+    if (!(x == x))
+    {
+        *s = *c = x;
+        return;
+    }
+    TN(sinhCoshKernel)(ABS(x), s, c);
+    if (x < 0)
+        *s = -*s;
+}
+
+T TN(Sinh)(T x)
+{
+    T s, c;
+    TN(SinhCosh)(x, &s, &c);
+    return s;
+}
+
+T TN(Cosh)(T x)
+{
+    T s, c;
+    TN(SinhCosh)(x, &s, &c);
+    return c;
+}
+
+T TN(Tanh)(T x)
+{
+    if (!(x == x))
+        return x;
+    T ax = ABS(x);
+    if (ax > CF_TANH_SAT)
+        return x > 0 ? 1 : -1;
+    T t = TN(expm1)(2 * ax);
+    T y = t / (t + 2);
+    return x < 0 ? -y : y;
+}
+
+T TN(Csch)(T x)
+{
+    if (x == 0)
+        return CF_NAN;
+    return 1 / TN(Sinh)(x);
+}
+
+T TN(Sech)(T x)
+{
+    return 1 / TN(Cosh)(x);
+}
+
+T TN(Coth)(T x)
+{
+    if (x == 0)
+        return CF_NAN;
+    return 1 / TN(Tanh)(x);
+}
+
+T TN(arcSinh)(T x)
+{
+    if (!(x == x) || x == CF_INF || x == -CF_INF)
+        return x;
+    T ax = ABS(x), y;
+    if (ax > CF_HYP_BIG)
+        y = TN(Ln)(ax) + (T)LN2;
+    else if (ax > 2)
+        y = TN(Ln)(ax + TN(Sqrt)(ax * ax + 1));
+    else
+        y = TN(ln1p)(ax + ax * ax / (1 + TN(Sqrt)(ax * ax + 1)));
+    return x < 0 ? -y : y;
+}
+
+T TN(arcCosh)(T x)
+{
+    if (!(x >= 1))
+        return CF_NAN;
+    if (x > CF_HYP_BIG)
+        return TN(Ln)(x) + (T)LN2;
+    if (x > 2)
+        return TN(Ln)(x + TN(Sqrt)(x * x - 1));
+    T t = x - 1;
+    return TN(ln1p)(t + TN(Sqrt)(2 * t + t * t));
+}
+
+T TN(arcTanh)(T x)
+{
+    if (!(x < 1 && x > -1))
+        return CF_NAN;
+    T ax = ABS(x);
+    T y = (T)0.5 * TN(ln1p)(2 * ax / (1 - ax));
+    return x < 0 ? -y : y;
+}
+
+T TN(arcCsch)(T x)
+{
+    if (x == 0)
+        return CF_NAN;
+    return TN(arcSinh)(1 / x);
+}
+
+// ln((1 + sqrt(1 - x^2)) / x) as ln1p of (1 - x)/x + sqrt((1 - x)(1 + x))/x:
+// 1 - x is exact for x >= 1/2, where 1/x would round the answer away
+T TN(arcSech)(T x)
+{
+    if (x == 0)
+        return CF_INF;
+    if (!(x > 0 && x <= 1))
+        return CF_NAN;
+    if (x < 1 / CF_HYP_BIG)
+        return (T)LN2 - TN(Ln)(x);
+    T d = 1 - x;
+    return TN(ln1p)(d / x + TN(Sqrt)(d * (1 + x)) / x);
+}
+
+// ln((x + 1) / (x - 1)) / 2 as ln1p(2 / (|x| - 1)) / 2, |x| - 1 exact near 1
+T TN(arcCoth)(T x)
+{
+    T ax = ABS(x);
+    if (!(ax >= 1))
+        return CF_NAN;
+    T y = ax == 1 ? CF_INF : (T)0.5 * TN(ln1p)(2 / (ax - 1));
+    return x < 0 ? -y : y;
+}
+
+#undef T
+#undef TN
+#undef COUNT
+#undef CF_ONE_BITS
+#undef CF_MANT_MASK
+#undef CF_INF
+#undef CF_NAN
@@ -0,0 +1,177 @@
+#include "cf.h"
+#include <stdint.h>
+#include <string.h>
+
+// float and double tiers of the cf functions, generated from cf_tier.h
+
+#define TIER_PIO2_1 1.57079632673412561417e+00
+#define TIER_PIO2_2 6.07710050630396597660e-11
+#define TIER_PIO2_3 2.02226624871116645580e-21
+#define TIER_PIO2_3T 8.47842766036889956997e-32
+
+// x = q*pi/2 + r for |x| <= 2^20 in double (Cody-Waite); returns q mod 4.
+// The first three parts of pi/2 have 33 bits, so their products with q are
+// exact and each subtraction is exact once r is small; the fourth carries
+// pi/2 on to 2^-150 so that r keeps its bits near a multiple of pi/2. Both
+// tiers reduce here, so the float tier keeps full accuracy in r.
+static int reduceTier(double x, double *r)
+{
+    if (ABS(x) <= MY_PI_BY_4)
+    {
+        *r = x;
+        return 0;
+    }
+    double q = (double)(long long)(x * (2 * INV_PI) + (x < 0 ? -0.5 : 0.5));
+    *r = (((x - q * TIER_PIO2_1) - q * TIER_PIO2_2) - q * TIER_PIO2_3) - q * TIER_PIO2_3T;
+    return (int)((long long)q & 3);
+}
+
+// ---- double tier: 53-bit mantissa, fdlibm-grade polynomials ----
+
+static const double expPolyD[14] = {
+    1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040,
+    1.0 / 40320, 1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600,
+    1.0 / 6227020800.0};
+static const double lnPolyD[7] = {
+    6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01,
+    2.222219843214978396e-01, 1.818357216161805012e-01, 1.531383769920937332e-01,
+    1.479819860511658591e-01};
+static const double sinPolyD[6] = {
+    -1.66666666666666324348e-01, 8.33333333332248946124e-03, -1.98412698298579493134e-04,
+    2.75573137070700676789e-06, -2.50507602534068634195e-08, 1.58969099521155010221e-10};
+static const double cosPolyD[6] = {
+    4.16666666666666019037e-02, -1.38888888888741095749e-03, 2.48015872894767294178e-05,
+    -2.75573143513906633035e-07, 2.08757232129817482790e-09, -1.13596475577881948265e-11};
+static const double atanPolyD[11] = {
+    3.33333333333329318027e-01, -1.99999999998764832476e-01, 1.42857142725034663711e-01,
+    -1.11111104054623557880e-01, 9.09088713343650656196e-02, -7.69187620504482999495e-02,
+    6.66107313738753120669e-02, -5.83357013379057348645e-02, 4.97687799461593236017e-02,
+    -3.65315727442169155270e-02, 1.62858201153657823623e-02};
+static const double atanHiD[4] = {
+    4.63647609000806093515e-01, 7.85398163397448278999e-01,
+    9.82793723247329054082e-01, 1.57079632679489655800e+00};
+static const double atanLoD[4] = {
+    2.26987774529616870924e-17, 3.06161699786838301793e-17,
+    1.39033110312309984516e-17, 6.12323399573676603587e-17};
+
+#define CF_T double
+#define CF_TNAME(x) x##D
+#define CF_UINT uint64_t
+#define CF_MANT_BITS 52
+#define CF_EXP_BIAS 1023
+#define CF_EPS 2.2204460492503131e-16
+#define CF_MIN_NORMAL 0x1p-1022
+#define CF_TWO_MANT 0x1p53
+#define CF_SQRT_HALF_BITS 0x3fe6a09e667f3bcdULL
+#define CF_RSQRT_MAGIC 0x5fe6eb50c7b537a9ULL
+#define CF_LN2_HI 6.93147180369123816490e-01
+#define CF_LN2_LO 1.90821492927058770002e-10
+#define CF_LOG10_2_HI 3.01029995663611771306e-01
+#define CF_LOG10_2_LO 3.69423907715893078616e-13
+#define CF_EXP_MAX 7.09782712893383973096e+02
+#define CF_EXP_MIN -7.45133219101941108420e+02
+#define CF_TRIG_MAX 0x1p20
+#define CF_ATAN_TINY 0x1p-27
+#define CF_ATAN_HUGE 0x1p66
+#define CF_TANH_SAT 22.0
+#define CF_HYP_BIG 0x1p28
+#define CF_SPLIT 134217729.0
+#define CF_POW_LO 0x1p-900
+#define CF_POW_HI 0x1p900
+#define CF_WIDE_IPOWER iPower
+#include "cf_tier.h"
+#undef CF_T
+#undef CF_TNAME
+#undef CF_UINT
+#undef CF_MANT_BITS
+#undef CF_EXP_BIAS
+#undef CF_EPS
+#undef CF_MIN_NORMAL
+#undef CF_TWO_MANT
+#undef CF_SQRT_HALF_BITS
+#undef CF_RSQRT_MAGIC
+#undef CF_LN2_HI
+#undef CF_LN2_LO
+#undef CF_LOG10_2_HI
+#undef CF_LOG10_2_LO
+#undef CF_EXP_MAX
+#undef CF_EXP_MIN
+#undef CF_TRIG_MAX
+#undef CF_ATAN_TINY
+#undef CF_ATAN_HUGE
+#undef CF_TANH_SAT
+#undef CF_HYP_BIG
+#undef CF_SPLIT
+#undef CF_POW_LO
+#undef CF_POW_HI
+#undef CF_WIDE_IPOWER
+
+// ---- float tier: 24-bit mantissa, shortest polynomials that reach it ----
+
+static const float expPolyF[8] = {
+    1.0f, 1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720, 1.0f / 5040};
+static const float lnPolyF[4] = {
+    6.6666662693e-01f, 4.0000972152e-01f, 2.8498786688e-01f, 2.4279078841e-01f};
+static const float sinPolyF[4] = {
+    -1.0f / 6, 1.0f / 120, -1.0f / 5040, 1.0f / 362880};
+static const float cosPolyF[3] = {
+    1.0f / 24, -1.0f / 720, 1.0f / 40320};
+static const float atanPolyF[5] = {
+    3.3333328366e-01f, -1.9999158382e-01f, 1.4253635705e-01f, -1.0648017377e-01f,
+    6.1687607318e-02f};
+static const float atanHiF[4] = {
+    4.6364760399e-01f, 7.8539812565e-01f, 9.8279368877e-01f, 1.5707962513e+00f};
+static const float atanLoF[4] = {
+    5.0121582440e-09f, 3.7748947079e-08f, 3.4473217170e-08f, 7.5497894159e-08f};
+
+#define CF_T float
+#define CF_TNAME(x) x##F
+#define CF_UINT uint32_t
+#define CF_MANT_BITS 23
+#define CF_EXP_BIAS 127
+#define CF_EPS 1.1920928955e-07f
+#define CF_MIN_NORMAL 0x1p-126f
+#define CF_TWO_MANT 0x1p24f
+#define CF_SQRT_HALF_BITS 0x3f3504f3U
+#define CF_RSQRT_MAGIC 0x5f3759dfU
+#define CF_LN2_HI 6.9313812256e-01f
+#define CF_LN2_LO 9.0580006145e-06f
+#define CF_LOG10_2_HI 3.0102920532e-01f
+#define CF_LOG10_2_LO 7.9034151668e-07f
+#define CF_EXP_MAX 88.72283935546875f
+#define CF_EXP_MIN -103.97207708f
+#define CF_TRIG_MAX 0x1p20f
+#define CF_ATAN_TINY 0x1p-12f
+#define CF_ATAN_HUGE 0x1p26f
+#define CF_TANH_SAT 9.0f
+#define CF_HYP_BIG 0x1p12f
+#define CF_SPLIT 4097.0f
+#define CF_POW_LO 0x1p-90f
+#define CF_POW_HI 0x1p90f
+#define CF_WIDE_IPOWER iPowerD
+#include "cf_tier.h"
+#undef CF_T
+#undef CF_TNAME
+#undef CF_UINT
+#undef CF_MANT_BITS
+#undef CF_EXP_BIAS
+#undef CF_EPS
+#undef CF_MIN_NORMAL
+#undef CF_TWO_MANT
+#undef CF_SQRT_HALF_BITS
+#undef CF_RSQRT_MAGIC
+#undef CF_LN2_HI
+#undef CF_LN2_LO
+#undef CF_LOG10_2_HI
+#undef CF_LOG10_2_LO
+#undef CF_EXP_MAX
+#undef CF_EXP_MIN
+#undef CF_TRIG_MAX
+#undef CF_ATAN_TINY
+#undef CF_ATAN_HUGE
+#undef CF_TANH_SAT
+#undef CF_HYP_BIG
+#undef CF_SPLIT
+#undef CF_POW_LO
+#undef CF_POW_HI
+#undef CF_WIDE_IPOWER
@@ -0,0 +1,830 @@
+/* Vector kernels behind the cf batch API.
+ *
+ * This file is included once per ISA tier from cf_batch.c, with
+ *   CF_VLEN      number of double lanes in a vector (2, 4 or 8)
+ *   CF_VNAME(x)  x suffixed with the tier name (x_sse2, x_avx2, ...)
+ * defined, and a matching target pragma in effect. It has no include guard
+ * on purpose. The kernels only use GCC/Clang vector extensions, so the
+ * same source compiles to SSE2, AVX2+FMA or AVX-512 code. */
+
+#define VD CF_VNAME(vdouble)
+#define VL CF_VNAME(vlong)
+
+typedef double VD __attribute__((vector_size(CF_VLEN * 8)));
+typedef long long VL __attribute__((vector_size(CF_VLEN * 8)));
+
+static inline VD CF_VNAME(vsplat)(double c)
+{
+    VD v = {0};
+    return v + c;
+}
+
+static inline VD CF_VNAME(vsel)(VL mask, VD a, VD b)
+{
+    return (VD)((mask & (VL)a) | (~mask & (VL)b));
+}
+
+static inline VD CF_VNAME(vabs)(VD x)
+{
+    return (VD)((VL)x & 0x7fffffffffffffffLL);
+}
+
+/* the hardware square root is correctly rounded */
+static inline VD CF_VNAME(vsqrt)(VD x)
+{
+    return CF_VNAME(VEC_SQRT)(x);
+}
+
+/* 1/sqrt(x): seed from the exponent bits (within 3.5%), then four
+ * division-free Newton steps y <- y + y*(1/2 - x*y^2/2). */
+static inline VD CF_VNAME(vrsqrt)(VD x)
+{
+    VL tiny = (VL)(x < VEC_DBL_MIN);
+    VD xs = CF_VNAME(vsel)(tiny, x * VEC_TWO54, x);
+    VD y = (VD)(VEC_RSQRT_MAGIC - ((VL)xs >> 1));
+    VD hx = 0.5 * xs;
+    y = y + y * (0.5 - hx * y * y);
+    y = y + y * (0.5 - hx * y * y);
+    y = y + y * (0.5 - hx * y * y);
+    y = y + y * (0.5 - hx * y * y);
+    y = CF_VNAME(vsel)(tiny, y * VEC_TWO27, y);
+
+    y = CF_VNAME(vsel)((VL)(x == VEC_INF), CF_VNAME(vsplat)(0.0), y);
+    y = CF_VNAME(vsel)((VL)(x == 0.0), CF_VNAME(vsplat)(VEC_INF), y);
+    y = CF_VNAME(vsel)((VL)(x < 0.0), CF_VNAME(vsplat)(VEC_NAN), y);
+    return CF_VNAME(vsel)((VL)(x != x), x, y);
+}
+
+/* e^x: x = k*ln2 + r, |r| <= ln2/2, e^r by a degree 13 Taylor polynomial.
+ * 2^k is applied as two factors so that subnormal results come out right. */
+static inline VD CF_VNAME(vexp)(VD x)
+{
+    VD t = x * VEC_LGE + VEC_SHIFT;
+    VD kd = t - VEC_SHIFT;
+    VL k = (VL)t - VEC_SHIFT_BITS;
+    VD r = x - kd * VEC_LN2_HI;
+    r = r - kd * VEC_LN2_LO;
+
+    VD p = CF_VNAME(vsplat)(1.0 / 6227020800.0);
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    VL k1 = k >> 1;
+    VL k2 = k - k1;
+    VD s1 = (VD)((k1 + 1023) << 52);
+    VD s2 = (VD)((k2 + 1023) << 52);
+    VD y = (p * s1) * s2;
+
+    y = CF_VNAME(vsel)((VL)(x > VEC_EXP_MAX), CF_VNAME(vsplat)(VEC_INF), y);
+    y = CF_VNAME(vsel)((VL)(x < VEC_EXP_MIN), CF_VNAME(vsplat)(0.0), y);
+    return CF_VNAME(vsel)((VL)(x != x), x, y);
+}
+
+/* e^x - 1 for 0 <= x <= VEC_EXP_MAX: x = k*ln2 + r as in vexp, then
+ * e^x - 1 = 2^k * (p + 1 - 2^-k) with p = e^r - 1 from a polynomial that
+ * has no constant term, so small x loses nothing to cancellation. */
+static inline VD CF_VNAME(vexpm1pos)(VD x)
+{
+    VD t = x * VEC_LGE + VEC_SHIFT;
+    VD kd = t - VEC_SHIFT;
+    VL k = (VL)t - VEC_SHIFT_BITS;
+    VD r = x - kd * VEC_LN2_HI;
+    r = r - kd * VEC_LN2_LO;
+
+    VD p = CF_VNAME(vsplat)(1.0 / 6227020800.0);
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = r + r * r * p;
+
+    // 1 - 2^-k is exact up to k = 53 and rounds to 1 beyond
+    VL over = k > 60;
+    VL kc = (over & 60) | (~over & k);
+    VD c = 1.0 - (VD)((1023 - kc) << 52);
+    VL k1 = k >> 1;
+    VL k2 = k - k1;
+    VD s1 = (VD)((k1 + 1023) << 52);
+    VD s2 = (VD)((k2 + 1023) << 52);
+    return ((p + c) * s1) * s2;
+}
+
+/* x = 2^k * m with m in [sqrt(1/2), sqrt(2)), then the fdlibm reduction
+ * s = (m-1)/(m+1) and a degree 14 polynomial in s. Returns ln m and k as
+ * a double in *kd; Ln, Log and Lg each combine the two their own way. */
+static inline VD CF_VNAME(vlnkernel)(VD x, VD *kd)
+{
+    VL tiny = (VL)(x < VEC_DBL_MIN);
+    VD xs = CF_VNAME(vsel)(tiny, x * VEC_TWO54, x);
+    VL u = (VL)xs + (0x3ff0000000000000LL - 0x3fe6a09e667f3bcdLL);
+    VL k = ((u >> 52) & 0x7ff) - 1023;
+    k = k - (tiny & 54);
+    VD m = (VD)((u & 0x000fffffffffffffLL) + 0x3fe6a09e667f3bcdLL);
+    *kd = (VD)(k + VEC_SHIFT_BITS) - VEC_SHIFT;
+
+    VD f = m - 1.0;
+    VD s = f / (f + 2.0);
+    VD z = s * s;
+    VD w = z * z;
+    VD t1 = w * (VEC_LG2 + w * (VEC_LG4 + w * VEC_LG6));
+    VD t2 = z * (VEC_LG1 + w * (VEC_LG3 + w * (VEC_LG5 + w * VEC_LG7)));
+    VD R = t2 + t1;
+    VD hfsq = 0.5 * f * f;
+    return f - (hfsq - s * (hfsq + R));
+}
+
+/* log of 0, negative, inf and NaN lanes */
+static inline VD CF_VNAME(vlnspecial)(VD x, VD y)
+{
+    y = CF_VNAME(vsel)((VL)(x == VEC_INF), x, y);
+    y = CF_VNAME(vsel)((VL)(x == 0.0), CF_VNAME(vsplat)(-VEC_INF), y);
+    y = CF_VNAME(vsel)((VL)(x < 0.0), CF_VNAME(vsplat)(VEC_NAN), y);
+    return CF_VNAME(vsel)((VL)(x != x), x, y);
+}
+
+static inline VD CF_VNAME(vln)(VD x)
+{
+    VD kd;
+    VD lm = CF_VNAME(vlnkernel)(x, &kd);
+    return CF_VNAME(vlnspecial)(x, kd * VEC_LN2_HI + (kd * VEC_LN2_LO + lm));
+}
+
+/* log10 = k*log10(2) + ln(m)*log10(e), log10(2) split so k*HI is exact */
+static inline VD CF_VNAME(vlog)(VD x)
+{
+    VD kd;
+    VD lm = CF_VNAME(vlnkernel)(x, &kd);
+    return CF_VNAME(vlnspecial)(x, kd * VEC_LOG10_2_HI + (kd * VEC_LOG10_2_LO + lm * VEC_INV_LN10));
+}
+
+/* log2 = k + ln(m)*log2(e): exact for powers of two */
+static inline VD CF_VNAME(vlg)(VD x)
+{
+    VD kd;
+    VD lm = CF_VNAME(vlnkernel)(x, &kd);
+    return CF_VNAME(vlnspecial)(x, kd + lm * VEC_INV_LN2);
+}
+
+/* ln(1 + x): the factor x / (u - 1) cancels the rounding of u = 1 + x */
+static inline VD CF_VNAME(vln1p)(VD x)
+{
+    VD u = 1.0 + x;
+    VD y = CF_VNAME(vln)(u) * (x / (u - 1.0));
+    y = CF_VNAME(vsel)((VL)(u == 1.0), x, y);
+    return CF_VNAME(vsel)((VL)(u == VEC_INF), u, y);
+}
+
+/* Cody-Waite reduction x = q*(pi/2) + r, |r| <= pi/4, for |x| <=
+ * VEC_TRIG_MAX: three exact 33-bit parts of pi/2 and the tail after them,
+ * so r keeps its bits near a multiple of pi/2. Larger lanes are redone by
+ * the scalar code. */
+static inline VD CF_VNAME(vreduce)(VD x, VL *q)
+{
+    VD t = x * VEC_TWO_OVER_PI + VEC_SHIFT;
+    VD kd = t - VEC_SHIFT;
+    *q = (VL)t - VEC_SHIFT_BITS;
+    VD r = x - kd * VEC_PIO2_1;
+    r = r - kd * VEC_PIO2_2;
+    r = r - kd * VEC_PIO2_3;
+    r = r - kd * VEC_PIO2_3T;
+    return r;
+}
+
+static inline VD CF_VNAME(vsinpoly)(VD r)
+{
+    VD z = r * r;
+    VD p = VEC_S2 + z * (VEC_S3 + z * (VEC_S4 + z * (VEC_S5 + z * VEC_S6)));
+    return r + (z * r) * (VEC_S1 + z * p);
+}
+
+static inline VD CF_VNAME(vcospoly)(VD r)
+{
+    VD z = r * r;
+    VD p = z * z * (VEC_C1 + z * (VEC_C2 + z * (VEC_C3 + z * (VEC_C4 + z * (VEC_C5 + z * VEC_C6)))));
+    VD hz = 0.5 * z;
+    VD w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + p);
+}
+
+/* lanes that vreduce cannot handle; NaN and infinities included */
+static inline VL CF_VNAME(vbig)(VD x)
+{
+    return ~(VL)(CF_VNAME(vabs)(x) <= VEC_TRIG_MAX);
+}
+
+static inline VD CF_VNAME(vsin)(VD x)
+{
+    VL q;
+    VD r = CF_VNAME(vreduce)(x, &q);
+    VD s = CF_VNAME(vsinpoly)(r);
+    VD c = CF_VNAME(vcospoly)(r);
+    VD y = CF_VNAME(vsel)((VL)((q & 1) != 0), c, s);
+    y = (VD)((VL)y ^ ((q & 2) << 62));
+
+    VL big = CF_VNAME(vbig)(x);
+    for (int j = 0; j < CF_VLEN; j++)
+        if (big[j])
+            y[j] = (double)Sine(x[j]);
+    return y;
+}
+
+static inline VD CF_VNAME(vcos)(VD x)
+{
+    VL q;
+    VD r = CF_VNAME(vreduce)(x, &q);
+    VD s = CF_VNAME(vsinpoly)(r);
+    VD c = CF_VNAME(vcospoly)(r);
+    VD y = CF_VNAME(vsel)((VL)((q & 1) != 0), s, c);
+    y = (VD)((VL)y ^ (((q + 1) & 2) << 62));
+
+    VL big = CF_VNAME(vbig)(x);
+    for (int j = 0; j < CF_VLEN; j++)
+        if (big[j])
+            y[j] = (double)Cosine(x[j]);
+    return y;
+}
+
+static inline VD CF_VNAME(vtan)(VD x)
+{
+    VL q;
+    VD r = CF_VNAME(vreduce)(x, &q);
+    VD s = CF_VNAME(vsinpoly)(r);
+    VD c = CF_VNAME(vcospoly)(r);
+    VL odd = (VL)((q & 1) != 0);
+    VD y = CF_VNAME(vsel)(odd, -c, s) / CF_VNAME(vsel)(odd, s, c);
+
+    VL big = CF_VNAME(vbig)(x);
+    for (int j = 0; j < CF_VLEN; j++)
+        if (big[j])
+            y[j] = (double)Tangent(x[j]);
+    return y;
+}
+
+/* the reciprocals keep the scalar convention of +inf where the divisor is 0
+ * and NaN for infinite x (which the big lanes bring from the scalar code) */
+static inline VD CF_VNAME(vcsc)(VD x)
+{
+    VD s = CF_VNAME(vsin)(x);
+    return CF_VNAME(vsel)((VL)(s == 0.0), CF_VNAME(vsplat)(VEC_INF), 1.0 / s);
+}
+
+static inline VD CF_VNAME(vsec)(VD x)
+{
+    VD c = CF_VNAME(vcos)(x);
+    return CF_VNAME(vsel)((VL)(c == 0.0), CF_VNAME(vsplat)(VEC_INF), 1.0 / c);
+}
+
+/* cos/sin of the reduced argument, -sin/cos for odd quadrants: one
+ * division, as vtan */
+static inline VD CF_VNAME(vcot)(VD x)
+{
+    VL q;
+    VD r = CF_VNAME(vreduce)(x, &q);
+    VD s = CF_VNAME(vsinpoly)(r);
+    VD c = CF_VNAME(vcospoly)(r);
+    VL odd = (VL)((q & 1) != 0);
+    VD d = CF_VNAME(vsel)(odd, c, s);
+    VD y = CF_VNAME(vsel)(odd, -s, c) / d;
+    y = CF_VNAME(vsel)((VL)(d == 0.0), CF_VNAME(vsplat)(VEC_INF), y);
+
+    VL big = CF_VNAME(vbig)(x);
+    for (int j = 0; j < CF_VLEN; j++)
+        if (big[j])
+            y[j] = (double)Cotangent(x[j]);
+    return y;
+}
+
+/* lanes where e^|x| overflows (sinh and cosh may not yet), inf and NaN */
+static inline VL CF_VNAME(vhypbig)(VD ax)
+{
+    return ~(VL)(ax <= VEC_EXP_MAX);
+}
+
+/* sinh and cosh from one e^|x| - 1: with em = e^x - 1 and d = em/(em + 1)
+ * = 1 - e^-x, sinh = (em + d)/2 and cosh = 1 + em*d/2 */
+static inline void CF_VNAME(vsinhcosh)(VD x, VD *s, VD *c)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VD em = CF_VNAME(vexpm1pos)(ax);
+    VD d = em / (em + 1.0);
+    VD sh = 0.5 * (em + d);
+    VD ch = 1.0 + 0.5 * em * d;
+    sh = (VD)((VL)sh | ((VL)x & ~0x7fffffffffffffffLL));
+
+    VL big = CF_VNAME(vhypbig)(ax);
+    for (int j = 0; j < CF_VLEN; j++)
+        if (big[j])
+        {
+            long double ls, lc;
+            SinhCosh(x[j], &ls, &lc);
+            sh[j] = (double)ls;
+            ch[j] = (double)lc;
+        }
+    *s = sh;
+    *c = ch;
+}
+
+static inline VD CF_VNAME(vsinh)(VD x)
+{
+    VD s, c;
+    CF_VNAME(vsinhcosh)(x, &s, &c);
+    return s;
+}
+
+static inline VD CF_VNAME(vcosh)(VD x)
+{
+    VD s, c;
+    CF_VNAME(vsinhcosh)(x, &s, &c);
+    return c;
+}
+
+/* tanh = em / (em + 2) with em = e^2|x| - 1, +-1 past VEC_TANH_SAT */
+static inline VD CF_VNAME(vtanh)(VD x)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VL sat = (VL)(ax > VEC_TANH_SAT);
+    VD em = CF_VNAME(vexpm1pos)(CF_VNAME(vsel)(sat, CF_VNAME(vsplat)(0.0), 2.0 * ax));
+    VD y = CF_VNAME(vsel)(sat, CF_VNAME(vsplat)(1.0), em / (em + 2.0));
+    return (VD)((VL)y | ((VL)x & ~0x7fffffffffffffffLL));
+}
+
+/* the reciprocals keep the scalar convention of NaN at x = 0 */
+static inline VD CF_VNAME(vcsch)(VD x)
+{
+    return CF_VNAME(vsel)((VL)(x == 0.0), CF_VNAME(vsplat)(VEC_NAN), 1.0 / CF_VNAME(vsinh)(x));
+}
+
+/* sech = 2e / (1 + e^2) with e = e^-|x|: an error in e reaches the result
+ * scaled by tanh|x| < 1, and the tail past |x| = 709 stays subnormal rather
+ * than 1/cosh's 0 */
+static inline VD CF_VNAME(vsech)(VD x)
+{
+    VD e = CF_VNAME(vexp)(-CF_VNAME(vabs)(x));
+    VD e2 = e * e;
+    return 2.0 * e - 2.0 * e * (e2 / (1.0 + e2));
+}
+
+static inline VD CF_VNAME(vcoth)(VD x)
+{
+    return CF_VNAME(vsel)((VL)(x == 0.0), CF_VNAME(vsplat)(VEC_NAN), 1.0 / CF_VNAME(vtanh)(x));
+}
+
+/* The inverse hyperbolics take the forms of the double tier: ln1p of an
+ * argument with no cancellation near 0 (or near 1 for arcCosh), ln(2x)
+ * once x^2 would overflow. */
+static inline VD CF_VNAME(vasinh)(VD x)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VL big = (VL)(ax > VEC_HYP_BIG);
+    VD s = CF_VNAME(vsqrt)(ax * ax + 1.0);
+    VD large = CF_VNAME(vln)(CF_VNAME(vsel)(big, ax, ax + s)) +
+               CF_VNAME(vsel)(big, CF_VNAME(vsplat)(VEC_LN2), CF_VNAME(vsplat)(0.0));
+    VD small = CF_VNAME(vln1p)(ax + ax * ax / (1.0 + s));
+    VD y = CF_VNAME(vsel)((VL)(ax > 2.0), large, small);
+    return (VD)((VL)y | ((VL)x & ~0x7fffffffffffffffLL));
+}
+
+static inline VD CF_VNAME(vacosh)(VD x)
+{
+    VL big = (VL)(x > VEC_HYP_BIG);
+    VD large = CF_VNAME(vln)(CF_VNAME(vsel)(big, x, x + CF_VNAME(vsqrt)(x * x - 1.0))) +
+               CF_VNAME(vsel)(big, CF_VNAME(vsplat)(VEC_LN2), CF_VNAME(vsplat)(0.0));
+    VD t = x - 1.0;
+    VD small = CF_VNAME(vln1p)(t + CF_VNAME(vsqrt)(2.0 * t + t * t));
+    VD y = CF_VNAME(vsel)((VL)(x > 2.0), large, small);
+    return CF_VNAME(vsel)(~(VL)(x >= 1.0), CF_VNAME(vsplat)(VEC_NAN), y);
+}
+
+static inline VD CF_VNAME(vatanh)(VD x)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VD y = 0.5 * CF_VNAME(vln1p)(2.0 * ax / (1.0 - ax));
+    y = CF_VNAME(vsel)(~(VL)(ax < 1.0), CF_VNAME(vsplat)(VEC_NAN), y);
+    return (VD)((VL)y | ((VL)x & ~0x7fffffffffffffffLL));
+}
+
+static inline VD CF_VNAME(vacsch)(VD x)
+{
+    return CF_VNAME(vsel)((VL)(x == 0.0), CF_VNAME(vsplat)(VEC_NAN), CF_VNAME(vasinh)(1.0 / x));
+}
+
+/* ln1p((1 - x + sqrt((1 - x)(1 + x))) / x), 1 - x exact for x >= 1/2 */
+static inline VD CF_VNAME(vasech)(VD x)
+{
+    VD d = 1.0 - x;
+    VD y = CF_VNAME(vln1p)((d + CF_VNAME(vsqrt)(d * (1.0 + x))) / x);
+    y = CF_VNAME(vsel)((VL)(x < 1.0 / VEC_HYP_BIG), VEC_LN2 - CF_VNAME(vln)(x), y);
+    y = CF_VNAME(vsel)(~((VL)(x > 0.0) & (VL)(x <= 1.0)), CF_VNAME(vsplat)(VEC_NAN), y);
+    return CF_VNAME(vsel)((VL)(x == 0.0), CF_VNAME(vsplat)(VEC_INF), y);
+}
+
+/* ln1p(2 / (|x| - 1)) / 2: |x| = 1 gives ln1p(inf), inf */
+static inline VD CF_VNAME(vacoth)(VD x)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VD y = 0.5 * CF_VNAME(vln1p)(2.0 / (ax - 1.0));
+    y = CF_VNAME(vsel)(~(VL)(ax >= 1.0), CF_VNAME(vsplat)(VEC_NAN), y);
+    return (VD)((VL)y | ((VL)x & ~0x7fffffffffffffffLL));
+}
+
+/* atan(a) for a >= 0 (inf included): a is moved next to one of the
+ * breakpoints 0, 0.5, 1, 1.5, inf by a single division, as in the scalar
+ * tiers, then an odd degree 23 polynomial */
+static inline VD CF_VNAME(vatanpos)(VD a)
+{
+    VL m0 = (VL)(a >= 0.4375), m1 = (VL)(a >= 0.6875);
+    VL m2 = (VL)(a >= 1.1875), m3 = (VL)(a >= 2.4375);
+    VD num = CF_VNAME(vsel)(m0, 2.0 * a - 1.0, a);
+    VD den = CF_VNAME(vsel)(m0, 2.0 + a, CF_VNAME(vsplat)(1.0));
+    VD hi = CF_VNAME(vsel)(m0, CF_VNAME(vsplat)(VEC_ATAN_HI0), CF_VNAME(vsplat)(0.0));
+    VD lo = CF_VNAME(vsel)(m0, CF_VNAME(vsplat)(VEC_ATAN_LO0), CF_VNAME(vsplat)(0.0));
+    num = CF_VNAME(vsel)(m1, a - 1.0, num);
+    den = CF_VNAME(vsel)(m1, a + 1.0, den);
+    hi = CF_VNAME(vsel)(m1, CF_VNAME(vsplat)(VEC_ATAN_HI1), hi);
+    lo = CF_VNAME(vsel)(m1, CF_VNAME(vsplat)(VEC_ATAN_LO1), lo);
+    num = CF_VNAME(vsel)(m2, a - 1.5, num);
+    den = CF_VNAME(vsel)(m2, 1.0 + 1.5 * a, den);
+    hi = CF_VNAME(vsel)(m2, CF_VNAME(vsplat)(VEC_ATAN_HI2), hi);
+    lo = CF_VNAME(vsel)(m2, CF_VNAME(vsplat)(VEC_ATAN_LO2), lo);
+    num = CF_VNAME(vsel)(m3, CF_VNAME(vsplat)(-1.0), num);
+    den = CF_VNAME(vsel)(m3, a, den);
+    hi = CF_VNAME(vsel)(m3, CF_VNAME(vsplat)(VEC_ATAN_HI3), hi);
+    lo = CF_VNAME(vsel)(m3, CF_VNAME(vsplat)(VEC_ATAN_LO3), lo);
+
+    VD t = num / den;
+    VD z = t * t;
+    VD w = z * z;
+    VD s1 = z * (VEC_AT0 + w * (VEC_AT2 + w * (VEC_AT4 + w * (VEC_AT6 + w * (VEC_AT8 + w * VEC_AT10)))));
+    VD s2 = w * (VEC_AT1 + w * (VEC_AT3 + w * (VEC_AT5 + w * (VEC_AT7 + w * VEC_AT9))));
+    return hi - ((t * (s1 + s2) - lo) - t);
+}
+
+static inline VD CF_VNAME(vatan)(VD x)
+{
+    VD y = CF_VNAME(vatanpos)(CF_VNAME(vabs)(x));
+    return (VD)((VL)y | ((VL)x & ~0x7fffffffffffffffLL));
+}
+
+/* atan2: the smaller of |y|/|x| and |x|/|y| goes through vatanpos, then
+ * the quadrant follows the signs. Lanes with an infinity or with both
+ * zero are handed to the scalar code. */
+static inline VD CF_VNAME(vatan2)(VD y, VD x)
+{
+    VD ax = CF_VNAME(vabs)(x), ay = CF_VNAME(vabs)(y);
+    VL swap = (VL)(ay > ax);
+    VL xneg = (VL)x >> 63;
+    VD a = CF_VNAME(vatanpos)(CF_VNAME(vsel)(swap, ax, ay) / CF_VNAME(vsel)(swap, ay, ax));
+    // a, pi - a, pi/2 - a or pi/2 + a as base + (+-a + lo)
+    VD pi = CF_VNAME(vsel)(xneg, CF_VNAME(vsplat)(2 * VEC_ATAN_HI3), CF_VNAME(vsplat)(0.0));
+    VD pilo = CF_VNAME(vsel)(xneg, CF_VNAME(vsplat)(2 * VEC_ATAN_LO3), CF_VNAME(vsplat)(0.0));
+    VD base = CF_VNAME(vsel)(swap, CF_VNAME(vsplat)(VEC_ATAN_HI3), pi);
+    VD lo = CF_VNAME(vsel)(swap, CF_VNAME(vsplat)(VEC_ATAN_LO3), pilo);
+    a = (VD)((VL)a ^ ((swap ^ xneg) & ~0x7fffffffffffffffLL));
+    a = base + (a + lo);
+    a = (VD)((VL)a | ((VL)y & ~0x7fffffffffffffffLL));
+
+    VL odd = (VL)(ax == VEC_INF) | (VL)(ay == VEC_INF) | ((VL)(ax == 0.0) & (VL)(ay == 0.0));
+    for (int j = 0; j < CF_VLEN; j++)
+        if (odd[j])
+            a[j] = (double)arcTangent2(y[j], x[j]);
+    return a;
+}
+
+/* asin and acos as angles of (sqrt(1 - x^2), x); |x| > 1 makes the
+ * square root, and so the result, NaN */
+static inline VD CF_VNAME(vasin)(VD x)
+{
+    return CF_VNAME(vatan2)(x, CF_VNAME(vsqrt)((1.0 - x) * (1.0 + x)));
+}
+
+static inline VD CF_VNAME(vacos)(VD x)
+{
+    return CF_VNAME(vatan2)(CF_VNAME(vsqrt)((1.0 - x) * (1.0 + x)), x);
+}
+
+/* sqrt(x^2 - 1), which rounds to |x| past 2^27 */
+static inline VD CF_VNAME(vsecleg)(VD ax)
+{
+    return CF_VNAME(vsel)((VL)(ax > VEC_TWO27), ax, CF_VNAME(vsqrt)((ax - 1.0) * (ax + 1.0)));
+}
+
+static inline VD CF_VNAME(vacsc)(VD x)
+{
+    VD one = (VD)((VL)CF_VNAME(vsplat)(1.0) | ((VL)x & ~0x7fffffffffffffffLL));
+    return CF_VNAME(vatan2)(one, CF_VNAME(vsecleg)(CF_VNAME(vabs)(x)));
+}
+
+static inline VD CF_VNAME(vasec)(VD x)
+{
+    VD one = (VD)((VL)CF_VNAME(vsplat)(1.0) | ((VL)x & ~0x7fffffffffffffffLL));
+    return CF_VNAME(vatan2)(CF_VNAME(vsecleg)(CF_VNAME(vabs)(x)), one);
+}
+
+/* atan(1/x) = +-(pi/2 - atan|x|) for |x| < 1, so 1/x is never rounded */
+static inline VD CF_VNAME(vacot)(VD x)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VL small = (VL)(ax < 1.0);
+    VD a = CF_VNAME(vatanpos)(CF_VNAME(vsel)(small, ax, CF_VNAME(vsplat)(1.0)) /
+                              CF_VNAME(vsel)(small, CF_VNAME(vsplat)(1.0), ax));
+    a = CF_VNAME(vsel)(small, VEC_ATAN_HI3 - (a - VEC_ATAN_LO3), a);
+    return (VD)((VL)a | ((VL)x & ~0x7fffffffffffffffLL));
+}
+
+/* a = hi + *lo with both halves 26 bits wide (Veltkamp). The empty asm
+ * hides a * VEC_SPLIT from the optimizer: fused into an FMA the split is
+ * no longer exact. */
+static inline VD CF_VNAME(vsplit)(VD a, VD *lo)
+{
+    VD t = a * VEC_SPLIT;
+    __asm__("" : "+x"(t));
+    VD hi = t - (t - a);
+    *lo = a - hi;
+    return hi;
+}
+
+/* a * b = p + *e exactly (Dekker), for |a|, |b| below VEC_DD_MAX */
+static inline VD CF_VNAME(vtwoprod)(VD a, VD b, VD *e)
+{
+    VD al, bl;
+    VD ah = CF_VNAME(vsplit)(a, &al);
+    VD bh = CF_VNAME(vsplit)(b, &bl);
+    VD p = a * b;
+    *e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+    return p;
+}
+
+/* (ah + al) * (bh + bl) as a normalized double-double */
+static inline VD CF_VNAME(vddmul)(VD ah, VD al, VD bh, VD bl, VD *lo)
+{
+    VD e;
+    VD p = CF_VNAME(vtwoprod)(ah, bh, &e);
+    e = e + (ah * bl + al * bh);
+    VD s = p + e;
+    *lo = e - (s - p);
+    return s;
+}
+
+/* x^n by binary powering in double-double, so the roundings of the
+ * squarings stay around 2^-100 and only the final one counts. Lanes whose
+ * x^|n| leaves [VEC_DD_MIN, VEC_DD_MAX] (the split would overflow or the
+ * low parts go subnormal), and NaN, 0 and inf, are redone by iPower. */
+static inline VD CF_VNAME(vipow)(VD x, long long n)
+{
+    if (n == 0)
+        return CF_VNAME(vsplat)(1.0);
+    if (n == 1)
+        return x;
+    if (n == 2)
+        return x * x;
+    if (n == -1)
+        return 1.0 / x;
+
+    unsigned long long m = n < 0 ? -(unsigned long long)n : (unsigned long long)n;
+    VD bh = x, bl = CF_VNAME(vsplat)(0.0);
+    VD yh = CF_VNAME(vsplat)(1.0), yl = CF_VNAME(vsplat)(0.0);
+    for (;;)
+    {
+        if (m & 1)
+            yh = CF_VNAME(vddmul)(yh, yl, bh, bl, &yl);
+        m >>= 1;
+        if (!m)
+            break;
+        bh = CF_VNAME(vddmul)(bh, bl, bh, bl, &bl);
+    }
+
+    VD y = yh + yl;
+    if (n < 0)
+    {
+        // q = 1/y, corrected by the exact residual 1 - y*q
+        VD q = 1.0 / yh, e;
+        VD p = CF_VNAME(vtwoprod)(yh, q, &e);
+        y = q + q * (((1.0 - p) - e) - yl * q);
+    }
+
+    VD ay = CF_VNAME(vabs)(yh);
+    VL odd = ~(VL)((ay >= VEC_DD_MIN) & (ay <= VEC_DD_MAX));
+    for (int j = 0; j < CF_VLEN; j++)
+        if (odd[j])
+            y[j] = (double)iPower(x[j], n);
+    return y;
+}
+
+/* a + b = s + *e exactly (Knuth) */
+static inline VD CF_VNAME(vtwosum)(VD a, VD b, VD *e)
+{
+    VD s = a + b;
+    VD bb = s - a;
+    *e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+/* ln x = hi + *lo for finite x > 0, to about 2^-66 of the result: x = 2^k
+ * * c_i * (1 + r) on the grid of cf_tables.h, r = rh + rl with |r| <=
+ * 0.0112, and ln(1 + r) = rh - rh^2/2 + q. k*ln2, ln c_i, rh and -rh^2/2
+ * (an exact product) are summed exactly; q, below 2^-19 of the result, is
+ * a polynomial up to r^11. */
+static inline VD CF_VNAME(vlndd)(VD x, VD *lo)
+{
+    VL tiny = (VL)(x < VEC_DBL_MIN);
+    VD xs = CF_VNAME(vsel)(tiny, x * VEC_TWO54, x);
+    VL u = (VL)xs + (0x3ff0000000000000LL - 0x3fe6a09e667f3bcdLL);
+    VL k = ((u >> 52) & 0x7ff) - 1023;
+    k = k - (tiny & 54);
+    VD m = (VD)((u & 0x000fffffffffffffLL) + 0x3fe6a09e667f3bcdLL);
+    VD kd = (VD)(k + VEC_SHIFT_BITS) - VEC_SHIFT;
+
+    VD t = (m - 1.0) * 64.0 + VEC_SHIFT;
+    VD id = t - VEC_SHIFT;
+    VL i = (VL)t - VEC_SHIFT_BITS - LN_TABLE_MIN;
+    VD ic = CF_VNAME(vsplat)(0.0), th = ic, tl = ic;
+    for (int j = 0; j < CF_VLEN; j++)
+    {
+        ic[j] = invC[i[j]];
+        th[j] = lnHi[i[j]];
+        tl[j] = lnLo[i[j]];
+    }
+    VD c = 1.0 + id * (1.0 / 64);
+    VD d = m - c; // exact
+    VD rh = d * ic;
+    VD pe, ph = CF_VNAME(vtwoprod)(rh, c, &pe);
+    VD rl = ((d - ph) - pe) * ic;
+    VD he, hh = CF_VNAME(vtwoprod)(rh, rh, &he);
+    hh = -0.5 * hh;
+    he = -0.5 * he;
+    VD z = rh * rh;
+    VD q = z * rh *
+           ((1.0 / 3 - rh * (1.0 / 4)) +
+            z * ((1.0 / 5 - rh * (1.0 / 6)) +
+                 z * ((1.0 / 7 - rh * (1.0 / 8)) + z * ((1.0 / 9 - rh * (1.0 / 10)) + z * (1.0 / 11)))));
+
+    VD e1, e2, e3;
+    VD s = CF_VNAME(vtwosum)(kd * VEC_LN2_HI, th, &e1);
+    s = CF_VNAME(vtwosum)(s, rh, &e2);
+    s = CF_VNAME(vtwosum)(s, hh, &e3);
+    VD l = ((e1 + e2) + e3) + ((he + (q + rl * (1.0 - rh))) + (kd * VEC_LN2_LO + tl));
+    VD hi = s + l;
+    *lo = l - (hi - s);
+    return hi;
+}
+
+/* e^(h + l) for |h| <= 709, |l| <= 2^-40 |h|, to about 2^-62 before the
+ * final rounding, as ExpA: h + l = (32k + j) * ln2/32 + r, |r| <= ln2/64,
+ * 2^(j/32) * (1 + rh) formed exactly and e^r - 1 - r a degree 7 Taylor
+ * polynomial */
+static inline VD CF_VNAME(vexpdd)(VD h, VD l)
+{
+    VD t = h * EXP_INV_LN2_32 + VEC_SHIFT;
+    VD nd = t - VEC_SHIFT;
+    VL n = (VL)t - VEC_SHIFT_BITS;
+    VD rh = h - nd * EXP_LN2_32_HI;
+    VD rl = l - nd * EXP_LN2_32_LO;
+    VD r = rh + rl;
+    VD z = r * r;
+    VD p = z * ((0.5 + r * (1.0 / 6)) + z * ((1.0 / 24 + r * (1.0 / 120)) + z * (1.0 / 720 + r * (1.0 / 5040))));
+
+    VL j = n & 31;
+    VL k = (n - j) >> 5;
+    VD th = CF_VNAME(vsplat)(0.0), tl = th;
+    for (int i = 0; i < CF_VLEN; i++)
+    {
+        th[i] = expHi[j[i]];
+        tl[i] = expLo[j[i]];
+    }
+    VD pe, ph = CF_VNAME(vtwoprod)(th, rh, &pe);
+    VD e1, s = CF_VNAME(vtwosum)(th, ph, &e1);
+    VD y = s + ((e1 + pe) + (th * (rl + p) + tl * (1.0 + r)));
+    return y * (VD)((k + 1023) << 52);
+}
+
+/* x^y = e^(y ln x) with y ln x carried as ph + pl to about 2^-66 of its
+ * size, so that little but the final rounding counts. A negative x takes
+ * an integer y, the sign from its parity. Lanes with x or y 0, inf or NaN,
+ * another negative x, |y| past VEC_DD_MAX, or a result outside the normal
+ * range are redone by rPower. */
+static inline VD CF_VNAME(vpow)(VD x, VD y)
+{
+    VD ax = CF_VNAME(vabs)(x);
+    VD ay = CF_VNAME(vabs)(y);
+    VD t = ay + VEC_SHIFT;
+    VL whole = (VL)(ay < VEC_TWO51) & (VL)(t - VEC_SHIFT == ay);
+    VL odd = whole & -((VL)t & 1);
+
+    VD ll, lh = CF_VNAME(vlndd)(ax, &ll);
+    VD pl, ph = CF_VNAME(vtwoprod)(y, lh, &pl);
+    pl = pl + y * ll;
+    VD r = CF_VNAME(vexpdd)(ph, pl);
+    r = (VD)((VL)r | (odd & (VL)x & ~0x7fffffffffffffffLL));
+
+    VL fast = (VL)(ax > 0.0) & (VL)(ax < VEC_INF) & (VL)(ay <= VEC_DD_MAX) & ((VL)(x > 0.0) | whole) &
+              (VL)(ph >= VEC_POW_MIN) & (VL)(ph <= VEC_POW_MAX);
+    for (int j = 0; j < CF_VLEN; j++)
+        if (!fast[j])
+            r[j] = (double)rPower(x[j], y[j]);
+    return r;
+}
+
+static void CF_VNAME(SqrtBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vsqrt)); }
+static void CF_VNAME(RSqrtBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vrsqrt)); }
+static void CF_VNAME(SineBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vsin)); }
+static void CF_VNAME(CosineBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vcos)); }
+static void CF_VNAME(TangentBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vtan)); }
+static void CF_VNAME(CosecantBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vcsc)); }
+static void CF_VNAME(SecantBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vsec)); }
+static void CF_VNAME(CotangentBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vcot)); }
+static void CF_VNAME(ExpBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vexp)); }
+static void CF_VNAME(LnBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vln)); }
+static void CF_VNAME(LogBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vlog)); }
+static void CF_VNAME(LgBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vlg)); }
+static void CF_VNAME(SinhBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vsinh)); }
+static void CF_VNAME(CoshBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vcosh)); }
+static void CF_VNAME(TanhBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vtanh)); }
+static void CF_VNAME(CschBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vcsch)); }
+static void CF_VNAME(SechBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vsech)); }
+static void CF_VNAME(CothBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vcoth)); }
+static void CF_VNAME(arcSinhBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vasinh)); }
+static void CF_VNAME(arcCoshBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vacosh)); }
+static void CF_VNAME(arcTanhBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vatanh)); }
+static void CF_VNAME(arcCschBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vacsch)); }
+static void CF_VNAME(arcSechBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vasech)); }
+static void CF_VNAME(arcCothBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vacoth)); }
+static void CF_VNAME(SinhCoshBatch)(const double *in, double *out1, double *out2, size_t n)
+{
+    VEC_LOOP2(CF_VNAME(vsinhcosh));
+}
+static void CF_VNAME(iPowerBatch)(const double *in, long long p, double *out, size_t n)
+{
+    VEC_LOOP_ARG(CF_VNAME(vipow), p);
+}
+static void CF_VNAME(arcTangentBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vatan)); }
+static void CF_VNAME(arcSineBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vasin)); }
+static void CF_VNAME(arcCosineBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vacos)); }
+static void CF_VNAME(arcCosecantBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vacsc)); }
+static void CF_VNAME(arcSecantBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vasec)); }
+static void CF_VNAME(arcCotangentBatch)(const double *in, double *out, size_t n) { VEC_LOOP(CF_VNAME(vacot)); }
+static void CF_VNAME(arcTangent2Batch)(const double *in1, const double *in2, double *out, size_t n)
+{
+    VEC_LOOP_BINARY(CF_VNAME(vatan2));
+}
+static void CF_VNAME(rPowerBatch)(const double *in1, const double *in2, double *out, size_t n)
+{
+    VEC_LOOP_BINARY(CF_VNAME(vpow));
+}
+
+static const struct BatchTable CF_VNAME(table) = {
+    CF_VNAME(SqrtBatch),
+    CF_VNAME(RSqrtBatch),
+    CF_VNAME(SineBatch),
+    CF_VNAME(CosineBatch),
+    CF_VNAME(TangentBatch),
+    CF_VNAME(CosecantBatch),
+    CF_VNAME(SecantBatch),
+    CF_VNAME(CotangentBatch),
+    CF_VNAME(ExpBatch),
+    CF_VNAME(LnBatch),
+    CF_VNAME(LogBatch),
+    CF_VNAME(LgBatch),
+    CF_VNAME(SinhBatch),
+    CF_VNAME(CoshBatch),
+    CF_VNAME(TanhBatch),
+    CF_VNAME(CschBatch),
+    CF_VNAME(SechBatch),
+    CF_VNAME(CothBatch),
+    CF_VNAME(SinhCoshBatch),
+    CF_VNAME(arcSinhBatch),
+    CF_VNAME(arcCoshBatch),
+    CF_VNAME(arcTanhBatch),
+    CF_VNAME(arcCschBatch),
+    CF_VNAME(arcSechBatch),
+    CF_VNAME(arcCothBatch),
+    CF_VNAME(arcTangentBatch),
+    CF_VNAME(arcSineBatch),
+    CF_VNAME(arcCosineBatch),
+    CF_VNAME(arcCosecantBatch),
+    CF_VNAME(arcSecantBatch),
+    CF_VNAME(arcCotangentBatch),
+    CF_VNAME(arcTangent2Batch),
+    CF_VNAME(iPowerBatch),
+    CF_VNAME(rPowerBatch),
+};
+
+#undef VD
+#undef VL
@@ -3,53 +3,656 @@
 #include <iomanip>
 #include <cmath>
 #include <cstring>
+#include <cfloat>
+#include <cstdint>
 #include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <charconv>
+#include <new>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
 
-void Matrix::allocate(size_t r, size_t c)
+#if defined(__unix__) || defined(__APPLE__)
+#define MAT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define MAT_BIG_ENDIAN 1
+#endif
+
+// ---- blocked GEMM ----
+
+// blocking of C += A * B: a GEMM_KC x GEMM_NR sliver of B stays in L1, a
+// GEMM_MC x GEMM_KC block of A in L2, a GEMM_KC x GEMM_NC panel of B in L3
+#define GEMM_MC 128
+#define GEMM_KC 256
+#define GEMM_NC 4096
+// the largest register tile of the tiers below
+#define GEMM_MR_MAX 8
+#define GEMM_NR_MAX 16
+
+typedef void (*GemmFunction)(size_t m, size_t n, size_t k, const double *a, size_t rsa, size_t csa,
+                             const double *b, size_t rsb, size_t csb, double *c, size_t ldc, double alpha,
+                             double *work);
+
+// doubles of packing space a gemm call needs: an A block and a B panel,
+// each rounded up to whole slivers
+static size_t gemmWorkSize(size_t m, size_t n, size_t k)
+{
+    size_t kc = std::min(k, (size_t)GEMM_KC);
+    return std::min(m + GEMM_MR_MAX, (size_t)GEMM_MC) * kc + kc * std::min(n + GEMM_NR_MAX, (size_t)GEMM_NC);
+}
+
+// i-k-j loop for targets without vector tiers; each element of C still
+// sums its products in k order
+static void gemmScalar(size_t m, size_t n, size_t k, const double *a, size_t rsa, size_t csa, const double *b,
+                       size_t rsb, size_t csb, double *c, size_t ldc, double alpha, double *)
+{
+    for (size_t i = 0; i < m; ++i)
+        for (size_t p = 0; p < k; ++p)
+        {
+            double aip = alpha * a[i * rsa + p * csa];
+            for (size_t j = 0; j < n; ++j)
+                c[i * ldc + j] += aip * b[p * rsb + j * csb];
+        }
+}
+
+typedef void (*TransposeFunction)(size_t rows, size_t cols, const double *src, size_t lds, double *dst,
+                                  size_t ldd);
+
+// dst (cols x rows) = src^T (rows x cols), one element at a time
+static void transposeScalar(size_t rows, size_t cols, const double *src, size_t lds, double *dst, size_t ldd)
+{
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            dst[j * ldd + i] = src[i * lds + j];
+}
+
+typedef void (*SparseFunction)(size_t begin, size_t end, const size_t *offsets, const uint32_t *indices,
+                               const double *values, const double *x, size_t ldx, size_t k, double *y,
+                               size_t ldy);
+
+// rows [begin, end) of Y = A X for CSR A, each sum in entry order
+static void sparseScalar(size_t begin, size_t end, const size_t *offsets, const uint32_t *indices,
+                         const double *values, const double *x, size_t ldx, size_t k, double *y, size_t ldy)
+{
+    for (size_t i = begin; i < end; ++i)
+        for (size_t j = 0; j < k; ++j)
+        {
+            double t = 0.0;
+            for (size_t p = offsets[i]; p < offsets[i + 1]; ++p)
+                t += values[p] * x[indices[p] * ldx + j];
+            y[i * ldy + j] = t;
+        }
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MAT_HAVE_VEC 1
+#include <immintrin.h>
+
+// sparse products: one rounding per product and sum on the FMA tiers, two
+// on SSE2 (the dense kernel always rounds twice, see mmuladd)
+#define MAT_FMA_sse2(a, b, c) ((a) * (b) + (c))
+#define MAT_FMA_avx2 _mm256_fmadd_pd
+#define MAT_FMA_avx512 _mm512_fmadd_pd
+// the MAT_VLEN elements of x at four-byte indices i[0..MAT_VLEN), read as
+// signed on the gather tiers (callers keep them <= INT32_MAX)
+#define MAT_GATHER_sse2(x, i) _mm_set_pd((x)[(i)[1]], (x)[(i)[0]])
+// (the masked forms, as the plain ones trip -Wmaybe-uninitialized in GCC's headers)
+#define MAT_GATHER_avx2(x, i)                                                                                   \
+    _mm256_mask_i32gather_pd(_mm256_setzero_pd(), (x), _mm_loadu_si128((const __m128i *)(i)),                 \
+                             _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8)
+#define MAT_GATHER_avx512(x, i)                                                                                 \
+    _mm512_mask_i32gather_pd(_mm512_setzero_pd(), (__mmask8)0xff, _mm256_loadu_si256((const __m256i *)(i)),    \
+                             (x), 8)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+#define MAT_VLEN 2
+#define MAT_MR 4
+#define MAT_VNAME(x) x##_sse2
+#include "matrices_vec.h"
+#undef MAT_VNAME
+#undef MAT_MR
+#undef MAT_VLEN
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+#define MAT_VLEN 4
+#define MAT_MR 4
+#define MAT_VNAME(x) x##_avx2
+#include "matrices_vec.h"
+#undef MAT_VNAME
+#undef MAT_MR
+#undef MAT_VLEN
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+#define MAT_VLEN 8
+#define MAT_MR 8
+#define MAT_VNAME(x) x##_avx512
+#include "matrices_vec.h"
+#undef MAT_VNAME
+#undef MAT_MR
+#undef MAT_VLEN
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // vector tiers
+
+static GemmFunction bestGemm()
+{
+#ifdef MAT_HAVE_VEC
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return gemm_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return gemm_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return gemm_sse2;
+#endif
+    return gemmScalar;
+}
+
+static TransposeFunction bestTranspose()
+{
+#ifdef MAT_HAVE_VEC
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return transposeTile_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return transposeTile_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return transposeTile_sse2;
+#endif
+    return transposeScalar;
+}
+
+static SparseFunction bestSparse()
+{
+#ifdef MAT_HAVE_VEC
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return sparseRows_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return sparseRows_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return sparseRows_sse2;
+#endif
+    return sparseScalar;
+}
+
+// packing space of the calling thread, grown as needed and kept, so that
+// repeated products (and the tiles of a parallel one) do not allocate
+struct GemmWorkspace
+{
+    double *data = nullptr;
+    size_t size = 0;
+    ~GemmWorkspace() { delete[] data; }
+};
+
+// C (m x n) += alpha * A (m x k) * B (k x n) with the best kernel for this
+// CPU, A and B read through row and column strides; false if the packing
+// space cannot be allocated
+static bool gemmStrided(size_t m, size_t n, size_t k, const double *a, size_t rsa, size_t csa, const double *b,
+                        size_t rsb, size_t csb, double *c, size_t ldc, double alpha)
+{
+    static const GemmFunction best = bestGemm();
+    static thread_local GemmWorkspace work;
+    size_t need = gemmWorkSize(m, n, k);
+    if (work.size < need)
+    {
+        delete[] work.data;
+        work.data = new (std::nothrow) double[need];
+        work.size = work.data ? need : 0;
+        if (!work.data)
+            return false;
+    }
+    best(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc, alpha, work.data);
+    return true;
+}
+
+// the same for row-major A and B with leading dimensions lda and ldb
+static bool gemm(size_t m, size_t n, size_t k, const double *a, size_t lda, const double *b, size_t ldb,
+                 double *c, size_t ldc, double alpha = 1.0)
+{
+    return gemmStrided(m, n, k, a, lda, 1, b, ldb, 1, c, ldc, alpha);
+}
+
+// ---- worker pool ----
+
+// below these sizes a call stays on the calling thread
+#define PARALLEL_MIN_PRODUCT (1 << 21) // m * n * k of a multiply
+#define PARALLEL_MIN_ELEMENTS (1 << 16) // element-wise operations
+// output tiles of a parallel multiply. Every element of C is computed by
+// the same sequence of operations whichever tile holds it, so the result
+// does not depend on the tiling or on the number of threads.
+#define PARALLEL_TILE_ROWS 256
+#define PARALLEL_TILE_COLS 512
+// tiles are halved down to this until each thread has about two; smaller
+// ones repack too much of B per row of A
+#define PARALLEL_TILE_MIN_ROWS 64
+#define PARALLEL_TILE_MIN_COLS 128
+
+static std::atomic<unsigned> defaultThreads(0);
+
+static unsigned resolveThreads(unsigned threads)
+{
+    if (!threads)
+        threads = defaultThreads;
+    if (!threads)
+        threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+// Persistent workers, started on first use and kept for later calls. One
+// job runs at a time; a call that finds the pool busy (another thread's
+// job, or a job started from inside a task) runs its tasks itself.
+class WorkerPool
+{
+public:
+    ~WorkerPool();
+    // body(0) .. body(count - 1) on up to `threads` threads, the caller
+    // being one of them; returns when all tasks are done
+    void run(size_t count, unsigned threads, const std::function<void(size_t)> &body);
+
+private:
+    void work(unsigned id);
+    void drain();
+
+    std::vector<std::thread> workers;
+    std::mutex busy;
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    const std::function<void(size_t)> *job = nullptr;
+    size_t tasks = 0;
+    std::atomic<size_t> next{0};
+    unsigned helpers = 0; // workers taking part in the current job
+    unsigned running = 0; // of those, not yet out of tasks
+    unsigned long long generation = 0;
+    bool stopping = false;
+};
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+}
+
+void WorkerPool::drain()
+{
+    for (size_t t; (t = next.fetch_add(1)) < tasks;)
+        (*job)(t);
+}
+
+void WorkerPool::work(unsigned id)
+{
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;)
+    {
+        wake.wait(guard, [&] { return stopping || (generation != seen && id < helpers); });
+        if (stopping)
+            return;
+        seen = generation;
+        guard.unlock();
+        drain();
+        guard.lock();
+        if (--running == 0)
+            finished.notify_one();
+    }
+}
+
+void WorkerPool::run(size_t count, unsigned threads, const std::function<void(size_t)> &body)
+{
+    size_t want = std::min((size_t)threads, count);
+    std::unique_lock<std::mutex> owner(busy, std::try_to_lock);
+    if (want <= 1 || !owner.owns_lock())
+    {
+        for (size_t t = 0; t < count; ++t)
+            body(t);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        try
+        {
+            while (workers.size() < want - 1)
+                workers.emplace_back(&WorkerPool::work, this, (unsigned)workers.size());
+        }
+        catch (const std::system_error &)
+        {
+            // fewer threads than asked for; the tasks are shared all the same
+        }
+        job = &body;
+        tasks = count;
+        next = 0;
+        helpers = running = (unsigned)std::min(workers.size(), want - 1);
+        ++generation;
+    }
+    wake.notify_all();
+    drain();
+
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [&] { return running == 0; });
+    helpers = 0;
+}
+
+static WorkerPool &workerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+// f(begin, end) over [0, n) in contiguous chunks spread across the threads
+template <typename F>
+static void parallelRange(size_t n, unsigned threads, F f)
+{
+    threads = resolveThreads(threads);
+    if (threads == 1 || n < PARALLEL_MIN_ELEMENTS)
+    {
+        f((size_t)0, n);
+        return;
+    }
+    size_t chunk = std::max((size_t)PARALLEL_MIN_ELEMENTS / 4, (n + 4 * threads - 1) / (4 * threads));
+    workerPool().run((n + chunk - 1) / chunk, threads,
+                     [&](size_t t) { f(t * chunk, std::min(n, t * chunk + chunk)); });
+}
+
+// gemmStrided with the tiles of C shared across the threads
+static bool parallelGemmStrided(size_t m, size_t n, size_t k, const double *a, size_t rsa, size_t csa,
+                                const double *b, size_t rsb, size_t csb, double *c, size_t ldc, unsigned threads,
+                                double alpha)
+{
+    threads = resolveThreads(threads);
+    if (threads == 1 || (double)m * n * k < PARALLEL_MIN_PRODUCT)
+        return gemmStrided(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc, alpha);
+    size_t tileRows = PARALLEL_TILE_ROWS, tileCols = PARALLEL_TILE_COLS;
+    size_t rowTiles = (m + tileRows - 1) / tileRows, colTiles = (n + tileCols - 1) / tileCols;
+    while (rowTiles * colTiles < 2 * (size_t)threads &&
+           (tileRows > PARALLEL_TILE_MIN_ROWS || tileCols > PARALLEL_TILE_MIN_COLS))
+    {
+        if (tileCols > PARALLEL_TILE_MIN_COLS && (tileCols >= 2 * tileRows || tileRows <= PARALLEL_TILE_MIN_ROWS))
+            tileCols /= 2;
+        else
+            tileRows /= 2;
+        rowTiles = (m + tileRows - 1) / tileRows;
+        colTiles = (n + tileCols - 1) / tileCols;
+    }
+
+    std::atomic<bool> ok(true);
+    workerPool().run(rowTiles * colTiles, threads, [&](size_t t) {
+        size_t i = t / colTiles * tileRows, j = t % colTiles * tileCols;
+        if (!gemmStrided(std::min(m - i, tileRows), std::min(n - j, tileCols), k, a + i * rsa, rsa, csa,
+                         b + j * csb, rsb, csb, c + i * ldc + j, ldc, alpha))
+            ok = false;
+    });
+    return ok;
+}
+
+static bool parallelGemm(size_t m, size_t n, size_t k, const double *a, size_t lda, const double *b, size_t ldb,
+                         double *c, size_t ldc, unsigned threads, double alpha = 1.0)
+{
+    return parallelGemmStrided(m, n, k, a, lda, 1, b, ldb, 1, c, ldc, threads, alpha);
+}
+
+// ---- Storage ----
+
+static double *alignedAllocate(size_t count)
+{
+    if (count > SIZE_MAX / sizeof(double))
+        return nullptr;
+    return static_cast<double *>(
+        ::operator new(count * sizeof(double), std::align_val_t(MATRIX_ALIGNMENT), std::nothrow));
+}
+
+static void alignedRelease(double *p)
+{
+    ::operator delete(p, std::align_val_t(MATRIX_ALIGNMENT));
+}
+
+double *MatrixHeapAllocator::allocate(size_t count)
+{
+    return alignedAllocate(count);
+}
+
+void MatrixHeapAllocator::release(double *p, size_t)
+{
+    alignedRelease(p);
+}
+
+// free list of the smallest power of two holding count doubles
+static unsigned poolClass(size_t count)
+{
+    return count <= 1 ? 0 : 64 - __builtin_clzll((unsigned long long)(count - 1));
+}
+
+MatrixBufferPool::MatrixBufferPool(size_t maxCachedBytes) : cached(0), limit(maxCachedBytes), hitCount(0) {}
+
+MatrixBufferPool::~MatrixBufferPool()
+{
+    trim();
+}
+
+double *MatrixBufferPool::allocate(size_t count)
+{
+    unsigned c = poolClass(count);
+    if (c >= 60)
+        return nullptr;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!freeLists[c].empty())
+        {
+            double *p = freeLists[c].back();
+            freeLists[c].pop_back();
+            cached -= sizeof(double) << c;
+            ++hitCount;
+            return p;
+        }
+    }
+    return alignedAllocate((size_t)1 << c);
+}
+
+void MatrixBufferPool::release(double *p, size_t count)
+{
+    unsigned c = poolClass(count);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (cached + (sizeof(double) << c) <= limit)
+        {
+            freeLists[c].push_back(p);
+            cached += sizeof(double) << c;
+            return;
+        }
+    }
+    alignedRelease(p);
+}
+
+void MatrixBufferPool::trim()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (std::vector<double *> &list : freeLists)
+    {
+        for (double *p : list)
+            alignedRelease(p);
+        list.clear();
+    }
+    cached = 0;
+}
+
+size_t MatrixBufferPool::cachedBytes()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return cached;
+}
+
+size_t MatrixBufferPool::hits()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return hitCount;
+}
+
+static MatrixAllocator &heapAllocator()
+{
+    static MatrixHeapAllocator heap;
+    return heap;
+}
+
+static std::atomic<MatrixAllocator *> currentAllocator(nullptr);
+static std::atomic<size_t> statAllocations(0), statReleases(0), statBytesAllocated(0), statBytesInUse(0),
+    statPeakBytes(0);
+
+void Matrix::setAllocator(MatrixAllocator *a)
+{
+    currentAllocator = a;
+}
+
+MatrixAllocator *Matrix::getAllocator()
+{
+    MatrixAllocator *a = currentAllocator;
+    return a ? a : &heapAllocator();
+}
+
+MatrixAllocStats Matrix::getAllocStats()
+{
+    MatrixAllocStats stats;
+    stats.allocations = statAllocations;
+    stats.releases = statReleases;
+    stats.bytesAllocated = statBytesAllocated;
+    stats.bytesInUse = statBytesInUse;
+    stats.peakBytesInUse = statPeakBytes;
+    return stats;
+}
+
+void Matrix::resetAllocStats()
+{
+    statAllocations = 0;
+    statReleases = 0;
+    statBytesAllocated = 0;
+    statPeakBytes = statBytesInUse.load();
+}
+
+// storage for r x c from the current allocator, none for an empty matrix;
+// false (and MATRIX_ERR_ALLOC, with the matrix left empty) on failure
+bool Matrix::allocate(size_t r, size_t c, MatrixInit init)
 {
+    allocator = getAllocator();
+    data = nullptr;
+    rows = cols = 0;
+    if (c && r > SIZE_MAX / c)
+    {
+        error = MATRIX_ERR_ALLOC;
+        return false;
+    }
+    size_t count = r * c;
+    if (count == 0)
+    {
+        rows = r;
+        cols = c;
+        return true;
+    }
+    if (!(data = allocator->allocate(count)))
+    {
+        error = MATRIX_ERR_ALLOC;
+        return false;
+    }
     rows = r;
     cols = c;
-    data = new (std::nothrow) double[rows * cols]();
-    if (!data)
-        error = MATRIX_ERR_ALLOC;
+    if (init == MATRIX_ZERO)
+        std::memset(data, 0, sizeof(double) * count);
+
+    size_t bytes = sizeof(double) * count;
+    ++statAllocations;
+    statBytesAllocated += bytes;
+    size_t inUse = statBytesInUse += bytes;
+    size_t peak = statPeakBytes;
+    while (inUse > peak && !statPeakBytes.compare_exchange_weak(peak, inUse))
+        ;
+    return true;
 }
 
 void Matrix::deallocate()
 {
-    delete[] data;
+    if (data)
+    {
+        allocator->release(data, rows * cols);
+        ++statReleases;
+        statBytesInUse -= sizeof(double) * rows * cols;
+    }
     data = nullptr;
     rows = cols = 0;
 }
 
 void Matrix::copyFrom(const Matrix &other)
 {
-    allocate(other.rows, other.cols);
-    if (data)
+    if (allocate(other.rows, other.cols, MATRIX_UNINITIALIZED))
     {
-        std::memcpy(data, other.data, sizeof(double) * rows * cols);
+        if (data)
+            std::memcpy(data, other.data, sizeof(double) * rows * cols);
         error = other.error;
     }
 }
 
-Matrix::Matrix(size_t r, size_t c) : rows(r), cols(c), error(MATRIX_SUCCESS)
+Matrix::Matrix(size_t r, size_t c, MatrixInit init) : error(MATRIX_SUCCESS)
 {
-    data = new double[rows * cols]();
+    allocate(r, c, init);
 }
 
 Matrix::~Matrix()
 {
-    delete[] data;
+    deallocate();
 }
 
-Matrix::Matrix(const Matrix &other) : rows(other.rows), cols(other.cols), error(other.error)
+Matrix::Matrix(const Matrix &other) : error(MATRIX_SUCCESS)
 {
-    data = new double[rows * cols];
-    std::memcpy(data, other.data, sizeof(double) * rows * cols);
+    copyFrom(other);
 }
 
-Matrix::Matrix() : rows(0), cols(0), data(nullptr), error(MATRIX_SUCCESS) {}
+Matrix::Matrix() : rows(0), cols(0), data(nullptr), error(MATRIX_SUCCESS), allocator(nullptr) {}
 
-Matrix::Matrix(Matrix &&other) noexcept : rows(0), cols(0), data(nullptr), error(MATRIX_SUCCESS)
+Matrix::Matrix(Matrix &&other) noexcept
+    : rows(0), cols(0), data(nullptr), error(MATRIX_SUCCESS), allocator(nullptr)
 {
     moveFrom(other);
 }
@@ -58,12 +661,18 @@ Matrix &Matrix::operator=(const Matrix &other)
 {
     if (this != &other)
     {
-        delete[] data;
-        rows = other.rows;
-        cols = other.cols;
-        error = other.error;
-        data = new double[rows * cols];
-        std::memcpy(data, other.data, sizeof(double) * rows * cols);
+        // same element count: copy over the existing storage
+        if (data && rows * cols == other.rows * other.cols)
+        {
+            rows = other.rows;
+            cols = other.cols;
+            std::memcpy(data, other.data, sizeof(double) * rows * cols);
+            error = other.error;
+            return *this;
+        }
+        deallocate();
+        error = MATRIX_SUCCESS;
+        copyFrom(other);
     }
     return *this;
 }
@@ -72,7 +681,7 @@ Matrix &Matrix::operator=(Matrix &&other) noexcept
 {
     if (this != &other)
     {
-        delete[] data;
+        deallocate();
         moveFrom(other);
     }
     return *this;
@@ -84,6 +693,7 @@ void Matrix::moveFrom(Matrix &other)
     cols = other.cols;
     data = other.data;
     error = other.error;
+    allocator = other.allocator;
     other.data = nullptr;
     other.rows = other.cols = 0;
 }
@@ -112,6 +722,8 @@ const char *Matrix::getErrorMessage() const
         return "Input/Output error";
     case MATRIX_ERR_INVALID:
         return "Invalid operation";
+    case MATRIX_ERR_PARSE:
+        return "Malformed input";
     default:
         return "Unknown error";
     }
@@ -129,310 +741,2587 @@ bool Matrix::operator==(const Matrix &other) const
     return true;
 }
 
-Matrix Matrix::operator+(const Matrix &other) const
+Matrix Matrix::operator*(const Matrix &other) const
 {
-    return add(other);
+    return multiply(other);
 }
 
-Matrix Matrix::operator-(const Matrix &other) const
+void Matrix::setThreads(unsigned threads)
 {
-    return subtract(other);
+    defaultThreads = threads;
 }
 
-Matrix Matrix::operator*(const Matrix &other) const
+unsigned Matrix::getThreads()
 {
-    return multiply(other);
+    return resolveThreads(0);
 }
 
-Matrix Matrix::add(const Matrix &other) const
+bool Matrix::prepare(size_t r, size_t c)
 {
-    if (rows != other.rows || cols != other.cols)
+    error = MATRIX_SUCCESS;
+    if (data && rows * cols == r * c)
     {
-        Matrix result;
-        result.error = MATRIX_ERR_DIM_MISMATCH;
-        return result;
+        rows = r;
+        cols = c;
+        return true;
     }
-    Matrix result(rows, cols);
-    for (size_t i = 0; i < rows * cols; ++i)
-        result.data[i] = data[i] + other.data[i];
+    deallocate();
+    return allocate(r, c, MATRIX_UNINITIALIZED);
+}
+
+void Matrix::parallelFor(size_t n, unsigned threads, void (*kernel)(const void *, size_t, size_t),
+                         const void *context)
+{
+    parallelRange(n, threads, [=](size_t begin, size_t end) { kernel(context, begin, end); });
+}
+
+Matrix Matrix::add(const Matrix &other, unsigned threads) const
+{
+    Matrix result;
+    result.assign(*this + other, threads);
     return result;
 }
 
-Matrix Matrix::subtract(const Matrix &other) const
+Matrix Matrix::subtract(const Matrix &other, unsigned threads) const
 {
-    if (rows != other.rows || cols != other.cols)
-    {
-        Matrix result;
-        result.error = MATRIX_ERR_DIM_MISMATCH;
-        return result;
-    }
-    Matrix result(rows, cols);
-    for (size_t i = 0; i < rows * cols; ++i)
-        result.data[i] = data[i] - other.data[i];
+    Matrix result;
+    result.assign(*this - other, threads);
     return result;
 }
 
-Matrix Matrix::multiply(const Matrix &other) const
+Matrix Matrix::multiply(const Matrix &other, unsigned threads) const
 {
-    if (cols != other.rows)
+    return ::multiply(*this, other, threads);
+}
+
+Matrix multiply(ConstMatrixView a, ConstMatrixView b, unsigned threads)
+{
+    if (a.numCols() != b.numRows())
     {
         Matrix result;
         result.error = MATRIX_ERR_DIM_MISMATCH;
         return result;
     }
-    Matrix result(rows, other.cols);
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < other.cols; ++j)
-            for (size_t k = 0; k < cols; ++k)
-                result.at(i, j) += at(i, k) * other.at(k, j);
+    Matrix result(a.numRows(), b.numCols());
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+    if (!parallelGemmStrided(a.numRows(), b.numCols(), a.numCols(), a.data(), a.rowStride(), a.colStride(),
+                             b.data(), b.rowStride(), b.colStride(), result.data, result.cols, threads, 1.0))
+        result.error = MATRIX_ERR_ALLOC;
     return result;
 }
 
-Matrix Matrix::transpose() const
+// ---- Strassen ----
+
+// products whose smallest dimension is at most this go to the blocked kernel
+static std::atomic<size_t> strassenCutover(1024);
+
+void Matrix::setStrassenCutover(size_t n)
 {
-    Matrix result(cols, rows);
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
-            result.at(j, i) = at(i, j);
-    return result;
+    strassenCutover = n ? n : 1;
 }
 
-bool Matrix::saveToText(const char *filename) const
+size_t Matrix::getStrassenCutover()
 {
-    FILE *f = fopen(filename, "w");
-    if (!f)
-        return false;
-    fprintf(f, "%zu %zu\n", rows, cols);
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
-            fprintf(f, "%.10lf ", at(i, j));
-    fclose(f);
-    return true;
+    return strassenCutover;
 }
 
-bool Matrix::saveToBinary(const char *filename) const
+// z = x + sign * y on r x c blocks
+static void combineBlocks(size_t r, size_t c, const double *x, size_t ldx, const double *y, size_t ldy, double sign,
+                          double *z, size_t ldz)
 {
-    FILE *f = fopen(filename, "wb");
-    if (!f)
-        return false;
-    fwrite(&rows, sizeof(size_t), 1, f);
-    fwrite(&cols, sizeof(size_t), 1, f);
-    fwrite(data, sizeof(double), rows * cols, f);
-    fclose(f);
-    return true;
+    for (size_t i = 0; i < r; ++i)
+        for (size_t j = 0; j < c; ++j)
+            z[i * ldz + j] = x[i * ldx + j] + sign * y[i * ldy + j];
 }
 
-Matrix Matrix::loadFromText(const char *filename)
+// z += sign * x on r x c blocks
+static void accumulateBlock(size_t r, size_t c, const double *x, size_t ldx, double sign, double *z, size_t ldz)
 {
-    FILE *f = fopen(filename, "r");
-    if (!f)
-        return Matrix();
-    size_t r, c;
-    fscanf(f, "%zu %zu", &r, &c);
-    Matrix result(r, c);
     for (size_t i = 0; i < r; ++i)
         for (size_t j = 0; j < c; ++j)
-            fscanf(f, "%lf", &result.at(i, j));
-    fclose(f);
-    return result;
+            z[i * ldz + j] += sign * x[i * ldx + j];
 }
 
-Matrix Matrix::loadFromBinary(const char *filename)
+static void zeroBlock(size_t r, size_t c, double *z, size_t ldz)
 {
-    FILE *f = fopen(filename, "rb");
-    if (!f)
-        return Matrix();
-    size_t r, c;
-    fread(&r, sizeof(size_t), 1, f);
-    fread(&c, sizeof(size_t), 1, f);
-    Matrix result(r, c);
-    fread(result.data, sizeof(double), r * c, f);
-    fclose(f);
-    return result;
+    for (size_t i = 0; i < r; ++i)
+        std::fill(z + i * ldz, z + i * ldz + c, 0.0);
+}
+
+// doubles of scratch the recursion below needs: each level holds one
+// operand of each half-size product and its result, and the levels below
+// reuse the rest in turn
+static size_t strassenWorkSize(size_t m, size_t n, size_t k, size_t cutover)
+{
+    size_t total = 0;
+    while (std::min(m, std::min(n, k)) > cutover)
+    {
+        m /= 2;
+        n /= 2;
+        k /= 2;
+        total += m * k + k * n + m * n;
+    }
+    return total;
+}
+
+// C (m x n) = A (m x k) * B (k x n) by Strassen's seven products on the
+// even-sized leading blocks, recursing down to the cutover. An odd last
+// row of A, column of B or inner index is peeled off and added with the
+// blocked kernel, so any shape works without padding.
+static bool strassen(size_t m, size_t n, size_t k, const double *a, size_t lda, const double *b, size_t ldb,
+                     double *c, size_t ldc, double *work, size_t cutover, unsigned threads)
+{
+    if (std::min(m, std::min(n, k)) <= cutover)
+    {
+        zeroBlock(m, n, c, ldc);
+        return parallelGemm(m, n, k, a, lda, b, ldb, c, ldc, threads);
+    }
+
+    size_t mh = m / 2, nh = n / 2, kh = k / 2;
+    const double *a11 = a, *a12 = a + kh, *a21 = a + mh * lda, *a22 = a21 + kh;
+    const double *b11 = b, *b12 = b + nh, *b21 = b + kh * ldb, *b22 = b21 + nh;
+    double *c11 = c, *c12 = c + nh, *c21 = c + mh * ldc, *c22 = c21 + nh;
+    double *ta = work, *tb = ta + mh * kh, *t = tb + kh * nh, *rest = t + mh * nh;
+    bool ok = true;
+
+    // M1 = (A11 + A22)(B11 + B22) goes to C11 and C22
+    combineBlocks(mh, kh, a11, lda, a22, lda, 1, ta, kh);
+    combineBlocks(kh, nh, b11, ldb, b22, ldb, 1, tb, nh);
+    ok &= strassen(mh, nh, kh, ta, kh, tb, nh, c11, ldc, rest, cutover, threads);
+    for (size_t i = 0; i < mh; ++i)
+        std::copy(c11 + i * ldc, c11 + i * ldc + nh, c22 + i * ldc);
+    // M2 = (A21 + A22) B11 to C21, from C22
+    combineBlocks(mh, kh, a21, lda, a22, lda, 1, ta, kh);
+    ok &= strassen(mh, nh, kh, ta, kh, b11, ldb, c21, ldc, rest, cutover, threads);
+    accumulateBlock(mh, nh, c21, ldc, -1, c22, ldc);
+    // M3 = A11 (B12 - B22) to C12 and C22
+    combineBlocks(kh, nh, b12, ldb, b22, ldb, -1, tb, nh);
+    ok &= strassen(mh, nh, kh, a11, lda, tb, nh, c12, ldc, rest, cutover, threads);
+    accumulateBlock(mh, nh, c12, ldc, 1, c22, ldc);
+    // M4 = A22 (B21 - B11) to C11 and C21
+    combineBlocks(kh, nh, b21, ldb, b11, ldb, -1, tb, nh);
+    ok &= strassen(mh, nh, kh, a22, lda, tb, nh, t, nh, rest, cutover, threads);
+    accumulateBlock(mh, nh, t, nh, 1, c11, ldc);
+    accumulateBlock(mh, nh, t, nh, 1, c21, ldc);
+    // M5 = (A11 + A12) B22 to C12, from C11
+    combineBlocks(mh, kh, a11, lda, a12, lda, 1, ta, kh);
+    ok &= strassen(mh, nh, kh, ta, kh, b22, ldb, t, nh, rest, cutover, threads);
+    accumulateBlock(mh, nh, t, nh, -1, c11, ldc);
+    accumulateBlock(mh, nh, t, nh, 1, c12, ldc);
+    // M6 = (A21 - A11)(B11 + B12) to C22
+    combineBlocks(mh, kh, a21, lda, a11, lda, -1, ta, kh);
+    combineBlocks(kh, nh, b11, ldb, b12, ldb, 1, tb, nh);
+    ok &= strassen(mh, nh, kh, ta, kh, tb, nh, t, nh, rest, cutover, threads);
+    accumulateBlock(mh, nh, t, nh, 1, c22, ldc);
+    // M7 = (A12 - A22)(B21 + B22) to C11
+    combineBlocks(mh, kh, a12, lda, a22, lda, -1, ta, kh);
+    combineBlocks(kh, nh, b21, ldb, b22, ldb, 1, tb, nh);
+    ok &= strassen(mh, nh, kh, ta, kh, tb, nh, t, nh, rest, cutover, threads);
+    accumulateBlock(mh, nh, t, nh, 1, c11, ldc);
+
+    // the peeled edges
+    size_t me = 2 * mh, ne = 2 * nh, ke = 2 * kh;
+    if (k > ke)
+        ok &= gemm(me, ne, 1, a + ke, lda, b + ke * ldb, ldb, c, ldc);
+    if (n > ne)
+    {
+        zeroBlock(me, 1, c + ne, ldc);
+        ok &= gemm(me, 1, k, a, lda, b + ne, ldb, c + ne, ldc);
+    }
+    if (m > me)
+    {
+        zeroBlock(1, n, c + me * ldc, ldc);
+        ok &= gemm(1, n, k, a + me * lda, lda, b, ldb, c + me * ldc, ldc);
+    }
+    return ok;
+}
+
+Matrix Matrix::multiplyStrassenRecursive(const Matrix &other) const
+{
+    if (cols != other.rows)
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_DIM_MISMATCH;
+        return result;
+    }
+    Matrix result(rows, other.cols);
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+    size_t cutover = strassenCutover;
+    double *work = new (std::nothrow) double[strassenWorkSize(rows, other.cols, cols, cutover)];
+    if (!work || !strassen(rows, other.cols, cols, data, cols, other.data, other.cols, result.data, result.cols,
+                           work, cutover, 0))
+        result.error = MATRIX_ERR_ALLOC;
+    delete[] work;
+    return result;
+}
+
+Matrix Matrix::multiplyStrassen(const Matrix &other) const
+{
+    if (cols != other.rows)
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_DIM_MISMATCH;
+        return result;
+    }
+    // every dimension padded with zeros to a multiple of 2^levels, so that
+    // no level has an odd edge to peel
+    size_t cutover = strassenCutover;
+    size_t levels = 0;
+    for (size_t d = std::min(rows, std::min(cols, other.cols)); d > cutover; d = (d + 1) / 2)
+        ++levels;
+    size_t unit = (size_t)1 << levels;
+    size_t m = (rows + unit - 1) / unit * unit, k = (cols + unit - 1) / unit * unit;
+    size_t n = (other.cols + unit - 1) / unit * unit;
+    if (m == rows && k == cols && n == other.cols)
+        return multiplyStrassenRecursive(other);
+
+    Matrix a = resize(m, k), b = other.resize(k, n), c(m, n);
+    if (a.error != MATRIX_SUCCESS || b.error != MATRIX_SUCCESS || c.error != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_ALLOC;
+        return result;
+    }
+    double *work = new (std::nothrow) double[strassenWorkSize(m, n, k, cutover)];
+    bool ok = work && strassen(m, n, k, a.data, k, b.data, n, c.data, n, work, cutover, 0);
+    delete[] work;
+    Matrix result = c.resize(rows, other.cols);
+    if (!ok)
+        result.error = MATRIX_ERR_ALLOC;
+    return result;
+}
+
+Matrix Matrix::multiplyStrassenPowerOf2(const Matrix &other) const
+{
+    if (cols != other.rows)
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_DIM_MISMATCH;
+        return result;
+    }
+    if (rows != cols || other.rows != other.cols || (rows & (rows - 1)))
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_INVALID;
+        return result;
+    }
+    return multiplyStrassenRecursive(other);
+}
+
+// ---- Transpose ----
+
+// tiles up to this size go to the register kernel: source and destination
+// tiles then both sit in L1, whatever the matrix size
+#define TRANSPOSE_TILE 32
+// rows per task of a parallel transpose
+#define TRANSPOSE_BAND 256
+
+// a split point near the middle that keeps register blocks whole
+static size_t transposeSplit(size_t n)
+{
+    return (n / 2 + 7) & ~(size_t)7;
+}
+
+// dst (cols x rows) = src^T (rows x cols), cache-obliviously: halve the
+// longer side until the tile fits the register kernel, so every level of
+// the cache hierarchy sees blocks it can hold without knowing its size
+static void transposeRecursive(TransposeFunction tile, size_t rows, size_t cols, const double *src, size_t lds,
+                               double *dst, size_t ldd)
+{
+    if (rows <= TRANSPOSE_TILE && cols <= TRANSPOSE_TILE)
+    {
+        tile(rows, cols, src, lds, dst, ldd);
+        return;
+    }
+    if (rows >= cols)
+    {
+        size_t h = transposeSplit(rows);
+        transposeRecursive(tile, h, cols, src, lds, dst, ldd);
+        transposeRecursive(tile, rows - h, cols, src + h * lds, lds, dst + h, ldd);
+    }
+    else
+    {
+        size_t h = transposeSplit(cols);
+        transposeRecursive(tile, rows, h, src, lds, dst, ldd);
+        transposeRecursive(tile, rows, cols - h, src + h, lds, dst + h * ldd, ldd);
+    }
+}
+
+static void transposeBlock(size_t rows, size_t cols, const double *src, size_t lds, double *dst, size_t ldd)
+{
+    static const TransposeFunction best = bestTranspose();
+    transposeRecursive(best, rows, cols, src, lds, dst, ldd);
+}
+
+// transposeBlock in bands of source rows across the threads
+static void parallelTranspose(size_t rows, size_t cols, const double *src, size_t lds, double *dst, size_t ldd,
+                              unsigned threads)
+{
+    threads = resolveThreads(threads);
+    if (threads == 1 || rows * cols < PARALLEL_MIN_ELEMENTS || rows <= TRANSPOSE_BAND)
+    {
+        transposeBlock(rows, cols, src, lds, dst, ldd);
+        return;
+    }
+    workerPool().run((rows + TRANSPOSE_BAND - 1) / TRANSPOSE_BAND, threads, [&](size_t t) {
+        size_t i = t * TRANSPOSE_BAND;
+        transposeBlock(std::min(rows - i, (size_t)TRANSPOSE_BAND), cols, src + i * lds, lds, dst + i, ldd);
+    });
+}
+
+// x (rows x cols) and y (cols x rows), disjoint blocks of one matrix: x
+// becomes y^T and y becomes x^T, tile by tile through a small buffer
+static void swapTransposed(TransposeFunction tile, size_t rows, size_t cols, double *x, double *y, size_t ld)
+{
+    if (rows <= TRANSPOSE_TILE && cols <= TRANSPOSE_TILE)
+    {
+        double t[TRANSPOSE_TILE * TRANSPOSE_TILE];
+        tile(rows, cols, x, ld, t, rows);
+        tile(cols, rows, y, ld, x, ld);
+        for (size_t i = 0; i < cols; ++i)
+            std::memcpy(y + i * ld, t + i * rows, sizeof(double) * rows);
+        return;
+    }
+    if (rows >= cols)
+    {
+        size_t h = transposeSplit(rows);
+        swapTransposed(tile, h, cols, x, y, ld);
+        swapTransposed(tile, rows - h, cols, x + h * ld, y + h, ld);
+    }
+    else
+    {
+        size_t h = transposeSplit(cols);
+        swapTransposed(tile, rows, h, x, y, ld);
+        swapTransposed(tile, rows, cols - h, x + h, y + h * ld, ld);
+    }
+}
+
+// square n x n in place: the diagonal tile by element swaps, the rest as
+// pairs of mirrored tiles
+static void transposeSquareTile(size_t n, double *a, size_t lda)
+{
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = i + 1; j < n; ++j)
+            std::swap(a[i * lda + j], a[j * lda + i]);
+}
+
+// square in place across the threads: band t takes its diagonal block and
+// swaps the blocks right of it with their mirrors below the diagonal
+static void transposeSquareInPlace(size_t n, double *a, unsigned threads)
+{
+    static const TransposeFunction best = bestTranspose();
+    size_t bands = (n + TRANSPOSE_BAND - 1) / TRANSPOSE_BAND;
+    auto band = [&](size_t t) {
+        size_t i = t * TRANSPOSE_BAND, h = std::min(n - i, (size_t)TRANSPOSE_BAND);
+        for (size_t d = 0; d < h; d += TRANSPOSE_TILE)
+        {
+            size_t hd = std::min(h - d, (size_t)TRANSPOSE_TILE);
+            transposeSquareTile(hd, a + (i + d) * n + i + d, n);
+            swapTransposed(best, hd, h - d - hd, a + (i + d) * n + i + d + hd, a + (i + d + hd) * n + i + d, n);
+        }
+        swapTransposed(best, h, n - i - h, a + i * n + i + h, a + (i + h) * n + i, n);
+    };
+    threads = resolveThreads(threads);
+    if (threads == 1 || n * n < PARALLEL_MIN_ELEMENTS)
+        for (size_t t = 0; t < bands; ++t)
+            band(t);
+    else
+        workerPool().run(bands, threads, band);
+}
+
+// rows x cols in place by following the cycles of the permutation that
+// sends element k to k * rows mod (rows * cols - 1), with a bit per
+// element marking those already moved; false if the bitmap cannot be had
+static bool transposeCyclesInPlace(size_t rows, size_t cols, double *a)
+{
+    size_t n = rows * cols;
+    if (n < 3)
+        return true;
+    unsigned long long *done = new (std::nothrow) unsigned long long[(n + 63) / 64]();
+    if (!done)
+        return false;
+    size_t last = n - 1;
+    for (size_t start = 1; start < last; ++start)
+    {
+        if (done[start / 64] >> (start % 64) & 1)
+            continue;
+        size_t k = start;
+        double carried = a[start];
+        do
+        {
+            k = (size_t)((unsigned __int128)k * rows % last);
+            std::swap(carried, a[k]);
+            done[k / 64] |= 1ULL << (k % 64);
+        } while (k != start);
+    }
+    delete[] done;
+    return true;
+}
+
+Matrix Matrix::transpose() const
+{
+    Matrix result(cols, rows, MATRIX_UNINITIALIZED);
+    if (result.error == MATRIX_SUCCESS)
+        parallelTranspose(rows, cols, data, cols, result.data, rows, 0);
+    return result;
+}
+
+void Matrix::transposeInPlace()
+{
+    if (rows == cols)
+        transposeSquareInPlace(rows, data, 0);
+    else if (!transposeCyclesInPlace(rows, cols, data))
+    {
+        error = MATRIX_ERR_ALLOC;
+        return;
+    }
+    std::swap(rows, cols);
+}
+
+// ---- File I/O ----
+
+#define TEXT_CHUNK ((size_t)8 << 20) // bytes read per round
+#define TEXT_PIECE ((size_t)1 << 20) // fewest bytes worth a thread
+#define TEXT_NUMBER 32               // room for any shortest double, and a separator
+
+static inline bool textSeparator(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == ',' || c == ';' || c == '\v' || c == '\f';
+}
+
+// the start of the first value at or after p, or end
+static inline const char *skipSeparators(const char *p, const char *end)
+{
+    while (p < end && textSeparator(*p))
+        ++p;
+    return p;
+}
+
+static size_t countTextValues(const char *p, const char *end)
+{
+    size_t n = 0;
+    bool inValue = false;
+    for (; p < end; ++p)
+    {
+        bool value = !textSeparator(*p);
+        n += value && !inValue;
+        inValue = value;
+    }
+    return n;
+}
+
+// what the decimal value in [p, end), too large or too small for a double,
+// rounds to: +-inf when its decimal exponent (that of the first significant
+// digit) is positive, +-0 otherwise
+static double outOfRangeValue(const char *p, const char *end)
+{
+    bool negative = *p == '-';
+    p += negative;
+    long long leading = 0; // digits before the point from the first nonzero one,
+    long long zeros = 0;   // or else zeros after the point before it
+    bool point = false, significant = false;
+    for (; p < end && ((*p >= '0' && *p <= '9') || *p == '.'); ++p)
+    {
+        if (*p == '.')
+        {
+            point = true;
+            continue;
+        }
+        significant = significant || *p != '0';
+        if (!point)
+            leading += significant;
+        else if (!significant)
+            ++zeros;
+    }
+    long long exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        bool down = *++p == '-';
+        p += *p == '-' || *p == '+';
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            exponent = std::min(exponent * 10 + (*p - '0'), 1000000000LL); // saturates, far past any double
+        if (down)
+            exponent = -exponent;
+    }
+    double v = exponent + (leading ? leading : -zeros) > 0 ? HUGE_VAL : 0.0;
+    return negative ? -v : v;
+}
+
+// one value at p into x, locale-free; the next byte, or nullptr if the
+// value is malformed
+static const char *parseTextValue(const char *p, const char *end, double &x)
+{
+    // from_chars takes no leading '+'
+    const char *q = p + (*p == '+' && end - p > 1 && p[1] != '-' && p[1] != '+');
+    std::from_chars_result r = std::from_chars(q, end, x);
+    if (r.ec == std::errc::invalid_argument || (r.ptr < end && !textSeparator(*r.ptr)))
+        return nullptr;
+    if (r.ec == std::errc::result_out_of_range)
+        x = outOfRangeValue(q, r.ptr); // from_chars leaves x alone
+    return r.ptr;
+}
+
+// the values in [p, end) into out[0, capacity); the count parsed, with bad
+// and reason set at the first value that is malformed or one too many
+static size_t parseTextValues(const char *p, const char *end, double *out, size_t capacity, const char *&bad,
+                              const char *&reason)
+{
+    size_t n = 0;
+    while ((p = skipSeparators(p, end)) < end)
+    {
+        if (n == capacity)
+        {
+            bad = p;
+            reason = "more values than rows * cols";
+            return n;
+        }
+        const char *next = parseTextValue(p, end, out[n]);
+        if (!next)
+        {
+            bad = p;
+            reason = "not a number";
+            return n;
+        }
+        ++n;
+        p = next;
+    }
+    return n;
+}
+
+// Text read a chunk at a time: buf[begin, cut) is whole values ready to
+// parse, and line and column give the position of buf[begin]. A stream in
+// exact mode is read a line at a time and never past the line holding the
+// last value wanted.
+struct TextInput
+{
+    FILE *file;
+    bool exact;
+    bool eof;
+    bool failed; // a read error
+    std::vector<char> buf;
+    size_t begin;
+    size_t cut;
+    size_t line;
+    size_t column;
+
+    TextInput(FILE *f, bool exactMode)
+        : file(f), exact(exactMode), eof(false), failed(false), begin(0), cut(0), line(1), column(1)
+    {
+    }
+
+    const char *first() const { return buf.data() + begin; }
+    const char *last() const { return buf.data() + cut; }
+
+    // the line and column of p
+    MatrixParseError where(const char *p) const
+    {
+        const char *b = first(), *nl = p;
+        while (nl > b && nl[-1] != '\n')
+            --nl;
+        MatrixParseError e = {line, column, nullptr};
+        if (nl > b)
+        {
+            e.line += std::count(b, nl, '\n');
+            e.column = 1;
+        }
+        e.column += p - nl;
+        return e;
+    }
+
+    // move past [first(), p)
+    void consume(const char *p)
+    {
+        MatrixParseError e = where(p);
+        line = e.line;
+        column = e.column;
+        begin = p - buf.data();
+    }
+
+    // read on, past whatever is pending; in exact mode until wanted values
+    // are pending
+    void fill(size_t wanted)
+    {
+        buf.erase(buf.begin(), buf.begin() + begin);
+        begin = cut = 0;
+        if (!exact)
+        {
+            size_t have = buf.size();
+            buf.resize(have + TEXT_CHUNK);
+            size_t got = fread(buf.data() + have, 1, TEXT_CHUNK, file);
+            buf.resize(have + got);
+            eof = got < TEXT_CHUNK;
+        }
+        else
+        {
+            size_t pending = countTextValues(buf.data(), buf.data() + buf.size());
+            char part[1 << 16];
+            bool lineEnd = true;
+            while (!eof && (pending < wanted || !lineEnd))
+            {
+                if (!fgets(part, sizeof part, file))
+                {
+                    eof = true;
+                    break;
+                }
+                size_t len = strlen(part), have = buf.size();
+                lineEnd = len && part[len - 1] == '\n';
+                // a value cut between two fgets calls counts once
+                bool joined = have && !textSeparator(buf[have - 1]) && len && !textSeparator(part[0]);
+                buf.insert(buf.end(), part, part + len);
+                pending += countTextValues(part, part + len) - joined;
+            }
+        }
+        failed = failed || ferror(file);
+        cut = buf.size();
+        // hold back a value the chunk may have cut in two
+        if (!eof)
+            while (cut > 0 && !textSeparator(buf[cut - 1]))
+                --cut;
+    }
+};
+
+Matrix Matrix::readText(FILE *stream, bool exact, MatrixParseError *where)
+{
+    Matrix result;
+    TextInput in(stream, exact);
+    const char *bad = nullptr, *reason = nullptr;
+
+    // rows and cols
+    size_t dims[2];
+    int found = 0;
+    in.fill(2);
+    while (found < 2 && !in.failed)
+    {
+        const char *p = skipSeparators(in.first(), in.last());
+        if (p == in.last())
+        {
+            in.consume(p);
+            if (in.eof)
+            {
+                bad = p;
+                reason = "missing rows and cols";
+                break;
+            }
+            in.fill(2 - found);
+            continue;
+        }
+        std::from_chars_result r = std::from_chars(p, in.last(), dims[found]);
+        if (r.ec != std::errc() || (r.ptr < in.last() && !textSeparator(*r.ptr)))
+        {
+            bad = p;
+            reason = "rows and cols must be non-negative integers";
+            break;
+        }
+        ++found;
+        in.consume(r.ptr);
+    }
+    if (!bad && !in.failed && dims[1] && dims[0] > SIZE_MAX / dims[1])
+        result.error = MATRIX_ERR_INVALID;
+    else if (!bad && !in.failed && !result.allocate(dims[0], dims[1], MATRIX_UNINITIALIZED))
+        result.error = MATRIX_ERR_ALLOC;
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+
+    // the values, a chunk at a time; large chunks are cut at separators into
+    // pieces, counted and then parsed on the worker threads
+    size_t n = result.rows * result.cols, filled = 0;
+    unsigned threads = resolveThreads(0);
+    while (!bad && !in.failed)
+    {
+        const char *b = in.first(), *e = in.last();
+        size_t pieces = std::min((size_t)4 * threads, (size_t)(e - b) / TEXT_PIECE);
+        if (threads == 1 || pieces < 2)
+            filled += parseTextValues(b, e, result.data + filled, n - filled, bad, reason);
+        else
+        {
+            std::vector<const char *> cuts(pieces + 1), bads(pieces, nullptr), reasons(pieces, nullptr);
+            std::vector<size_t> offsets(pieces + 1, 0);
+            cuts[0] = b;
+            cuts[pieces] = e;
+            for (size_t t = 1; t < pieces; ++t)
+            {
+                const char *c = std::max(cuts[t - 1], b + (e - b) / pieces * t);
+                while (c < e && !textSeparator(*c))
+                    ++c;
+                cuts[t] = c;
+            }
+            workerPool().run(pieces, threads,
+                             [&](size_t t) { offsets[t + 1] = countTextValues(cuts[t], cuts[t + 1]); });
+            for (size_t t = 0; t < pieces; ++t)
+                offsets[t + 1] += offsets[t];
+            workerPool().run(pieces, threads, [&](size_t t) {
+                size_t at = std::min(filled + offsets[t], n);
+                parseTextValues(cuts[t], cuts[t + 1], result.data + at, n - at, bads[t], reasons[t]);
+            });
+            for (size_t t = 0; t < pieces && !bad; ++t)
+            {
+                bad = bads[t];
+                reason = reasons[t];
+            }
+            filled = std::min(filled + offsets[pieces], n);
+        }
+        if (bad || in.eof || (exact && filled == n))
+            break;
+        in.consume(e);
+        in.fill(n - filled);
+    }
+    if (!bad && !in.failed && filled < n)
+    {
+        bad = in.last();
+        reason = "fewer values than rows * cols";
+    }
+
+    if (in.failed || bad)
+    {
+        result = Matrix();
+        result.error = in.failed ? MATRIX_ERR_IO : MATRIX_ERR_PARSE;
+        if (where && bad)
+        {
+            *where = in.where(bad);
+            where->reason = reason;
+        }
+    }
+    return result;
+}
+
+// digits of x into p, shortest round-trip form; the end
+static char *formatTextValue(char *p, double x)
+{
+    return std::to_chars(p, p + TEXT_NUMBER, x).ptr;
+}
+
+bool Matrix::saveToText(const char *filename) const
+{
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        return false;
+    char head[2 * TEXT_NUMBER];
+    char *h = std::to_chars(head, head + TEXT_NUMBER, rows).ptr;
+    *h++ = ' ';
+    h = std::to_chars(h, h + TEXT_NUMBER, cols).ptr;
+    *h++ = '\n';
+    bool ok = fwrite(head, 1, h - head, f) == (size_t)(h - head);
+
+    // blocks of rows formatted on the worker threads, written in order
+    unsigned threads = resolveThreads(0);
+    size_t blockRows = std::max((size_t)1, TEXT_PIECE / TEXT_NUMBER / std::max(cols, (size_t)1));
+    size_t blocks = std::max((size_t)1, std::min((size_t)4 * threads, (rows + blockRows - 1) / blockRows));
+    std::vector<std::vector<char> > text(blocks);
+    std::vector<size_t> used(blocks);
+    for (size_t i0 = 0; ok && i0 < rows; i0 += blocks * blockRows)
+    {
+        auto format = [&](size_t t) {
+            size_t first = std::min(rows, i0 + t * blockRows), end = std::min(rows, first + blockRows);
+            text[t].resize((end - first) * (cols * TEXT_NUMBER + 1));
+            char *p = text[t].data();
+            for (size_t i = first; i < end; ++i)
+            {
+                const double *row = data + i * cols;
+                for (size_t j = 0; j < cols; ++j)
+                {
+                    p = formatTextValue(p, row[j]);
+                    *p++ = ' ';
+                }
+                if (cols)
+                    p[-1] = '\n';
+                else
+                    *p++ = '\n';
+            }
+            used[t] = p - text[t].data();
+        };
+        if (threads == 1 || blocks == 1)
+            for (size_t t = 0; t < blocks; ++t)
+                format(t);
+        else
+            workerPool().run(blocks, threads, format);
+        for (size_t t = 0; ok && t < blocks; ++t)
+            ok = fwrite(text[t].data(), 1, used[t], f) == used[t];
+    }
+    return fclose(f) == 0 && ok;
+}
+
+// The binary format: a BINARY_HEADER-byte header of little-endian fields
+//    0  magic                     8  version (4 bytes)
+//   12  element type (4 bytes)   16  rows
+//   24  cols                     32  payload offset
+//   40  payload checksum         48  header checksum of bytes [0, 48)
+//   56  reserved (zero)
+// then rows * cols little-endian doubles in row-major order from the
+// payload offset, which is a multiple of MATRIX_ALIGNMENT.
+#define BINARY_HEADER 64
+#define BINARY_VERSION 1
+#define BINARY_FLOAT64 1 // IEEE 754 binary64
+#define BINARY_LEGACY_HEADER (2 * sizeof(size_t))
+static const unsigned char binaryMagic[8] = {'M', 'A', 'T', 'R', 'I', 'X', '\0', '\x1a'};
+
+#define CHECK_PRIME1 0x9E3779B185EBCA87ULL
+#define CHECK_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define CHECK_PRIME3 0x165667B19E3779F9ULL
+
+static inline uint64_t rotateLeft(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t checkRound(uint64_t h, uint64_t w)
+{
+    return rotateLeft(h + w * CHECK_PRIME2, 31) * CHECK_PRIME1;
+}
+
+// 64-bit hash of n native 8-byte words (the bit patterns of doubles), in
+// xxHash64-style rounds over four interleaved lanes so that the multiplies
+// overlap; several GB/s, and any flipped bit changes it
+static uint64_t checksumWords(const void *p, size_t n)
+{
+    const unsigned char *b = static_cast<const unsigned char *>(p);
+    uint64_t h[4] = {CHECK_PRIME1 + CHECK_PRIME2, CHECK_PRIME2, 0, 0 - CHECK_PRIME1};
+    uint64_t w;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        for (int l = 0; l < 4; ++l)
+        {
+            std::memcpy(&w, b + 8 * (i + l), 8);
+            h[l] = checkRound(h[l], w);
+        }
+    uint64_t r = rotateLeft(h[0], 1) + rotateLeft(h[1], 7) + rotateLeft(h[2], 12) + rotateLeft(h[3], 18) + n;
+    for (; i < n; ++i)
+    {
+        std::memcpy(&w, b + 8 * i, 8);
+        r = rotateLeft(r ^ checkRound(0, w), 27) * CHECK_PRIME1 + CHECK_PRIME3;
+    }
+    r ^= r >> 33;
+    r *= CHECK_PRIME2;
+    r ^= r >> 29;
+    r *= CHECK_PRIME3;
+    return r ^ (r >> 32);
+}
+
+static void storeLittle(unsigned char *p, uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t loadLittle(const unsigned char *p, int bytes)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t headerChecksum(const unsigned char *h)
+{
+    uint64_t fields[6];
+    for (int i = 0; i < 6; ++i)
+        fields[i] = loadLittle(h + 8 * i, 8);
+    return checksumWords(fields, 6);
+}
+
+struct BinaryLayout
+{
+    size_t rows;
+    size_t cols;
+    uint64_t offset;
+    uint64_t checksum;
+    bool summed; // false for the headerless format, which has no checksum
+};
+
+// the layout of a file of size bytes from its first got (up to
+// BINARY_HEADER) bytes: MATRIX_ERR_IO if it is cut short or its header is
+// damaged, MATRIX_ERR_INVALID if it is not a matrix this version can read
+static MatrixError parseBinaryHeader(const unsigned char *h, size_t got, uint64_t size, BinaryLayout &out)
+{
+    if (got >= sizeof binaryMagic && std::memcmp(h, binaryMagic, sizeof binaryMagic) == 0)
+    {
+        if (got < BINARY_HEADER || headerChecksum(h) != loadLittle(h + 48, 8))
+            return MATRIX_ERR_IO;
+        uint64_t version = loadLittle(h + 8, 4), type = loadLittle(h + 12, 4);
+        uint64_t r = loadLittle(h + 16, 8), c = loadLittle(h + 24, 8);
+        out.offset = loadLittle(h + 32, 8);
+        out.checksum = loadLittle(h + 40, 8);
+        out.summed = true;
+        if (version == 0 || version > BINARY_VERSION || type != BINARY_FLOAT64 || out.offset < BINARY_HEADER ||
+            out.offset % sizeof(double) || r > SIZE_MAX || c > SIZE_MAX)
+            return MATRIX_ERR_INVALID;
+        out.rows = (size_t)r;
+        out.cols = (size_t)c;
+    }
+    else
+    {
+        // the headerless format: native rows and cols, then exactly the payload
+        if (got < BINARY_LEGACY_HEADER)
+            return MATRIX_ERR_IO;
+        std::memcpy(&out.rows, h, sizeof(size_t));
+        std::memcpy(&out.cols, h + sizeof(size_t), sizeof(size_t));
+        out.offset = BINARY_LEGACY_HEADER;
+        out.checksum = 0;
+        out.summed = false;
+    }
+    if (out.cols && out.rows > SIZE_MAX / sizeof(double) / out.cols)
+        return MATRIX_ERR_INVALID;
+    uint64_t bytes = (uint64_t)out.rows * out.cols * sizeof(double);
+    if (size < out.offset || size - out.offset < bytes)
+        return out.summed ? MATRIX_ERR_IO : MATRIX_ERR_INVALID;
+    if (!out.summed && size - out.offset != bytes)
+        return MATRIX_ERR_INVALID;
+    return MATRIX_SUCCESS;
+}
+
+static bool fileSize(FILE *f, uint64_t &size)
+{
+#ifdef MAT_HAVE_MMAP
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0)
+        return false;
+    size = (uint64_t)st.st_size;
+    return true;
+#else
+    long end;
+    if (fseek(f, 0, SEEK_END) != 0 || (end = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0)
+        return false;
+    size = (uint64_t)end;
+    return true;
+#endif
+}
+
+#ifdef MAT_BIG_ENDIAN
+static void swapWords(double *x, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t w;
+        std::memcpy(&w, x + i, 8);
+        w = __builtin_bswap64(w);
+        std::memcpy(x + i, &w, 8);
+    }
+}
+#endif
+
+bool Matrix::saveToBinary(const char *filename) const
+{
+    FILE *f = fopen(filename, "wb");
+    if (!f)
+        return false;
+    size_t n = rows * cols;
+    unsigned char header[BINARY_HEADER] = {0};
+    std::memcpy(header, binaryMagic, sizeof binaryMagic);
+    storeLittle(header + 8, BINARY_VERSION, 4);
+    storeLittle(header + 12, BINARY_FLOAT64, 4);
+    storeLittle(header + 16, rows, 8);
+    storeLittle(header + 24, cols, 8);
+    storeLittle(header + 32, BINARY_HEADER, 8);
+    storeLittle(header + 40, checksumWords(data, n), 8);
+    storeLittle(header + 48, headerChecksum(header), 8);
+    bool ok = fwrite(header, 1, BINARY_HEADER, f) == BINARY_HEADER;
+#ifdef MAT_BIG_ENDIAN
+    // byte-swapped through a buffer, a chunk at a time
+    double chunk[1024];
+    for (size_t i = 0; ok && i < n; i += 1024)
+    {
+        size_t m = std::min(n - i, (size_t)1024);
+        std::memcpy(chunk, data + i, m * sizeof(double));
+        swapWords(chunk, m);
+        ok = fwrite(chunk, sizeof(double), m, f) == m;
+    }
+#else
+    ok = ok && (n == 0 || fwrite(data, sizeof(double), n, f) == n);
+#endif
+    return fclose(f) == 0 && ok;
+}
+
+Matrix Matrix::loadFromText(const char *filename, MatrixParseError *where)
+{
+    FILE *f = fopen(filename, "r");
+    if (!f)
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_IO;
+        return result;
+    }
+    Matrix result = readText(f, false, where);
+    fclose(f);
+    return result;
+}
+
+Matrix Matrix::loadFromBinary(const char *filename)
+{
+    Matrix result;
+    FILE *f = fopen(filename, "rb");
+    uint64_t size = 0;
+    if (!f || !fileSize(f, size))
+    {
+        if (f)
+            fclose(f);
+        result.error = MATRIX_ERR_IO;
+        return result;
+    }
+    unsigned char header[BINARY_HEADER];
+    BinaryLayout layout;
+    MatrixError e = parseBinaryHeader(header, fread(header, 1, BINARY_HEADER, f), size, layout);
+    if (e == MATRIX_SUCCESS && fseek(f, (long)layout.offset, SEEK_SET) != 0)
+        e = MATRIX_ERR_IO;
+    // every element is read, so the storage need not be zeroed first
+    if (e == MATRIX_SUCCESS && !result.allocate(layout.rows, layout.cols, MATRIX_UNINITIALIZED))
+        e = result.error;
+    size_t n = layout.rows * layout.cols;
+    if (e == MATRIX_SUCCESS && n && fread(result.data, sizeof(double), n, f) != n)
+        e = MATRIX_ERR_IO;
+    fclose(f);
+#ifdef MAT_BIG_ENDIAN
+    if (e == MATRIX_SUCCESS && layout.summed)
+        swapWords(result.data, n);
+#endif
+    if (e == MATRIX_SUCCESS && layout.summed && checksumWords(result.data, n) != layout.checksum)
+        e = MATRIX_ERR_IO;
+    if (e != MATRIX_SUCCESS)
+    {
+        result = Matrix();
+        result.error = e;
+    }
+    return result;
 }
 
 void Matrix::print(FILE *stream) const
 {
-    for (size_t i = 0; i < rows; ++i)
+    for (size_t i = 0; i < rows; ++i)
+    {
+        for (size_t j = 0; j < cols; ++j)
+            fprintf(stream, "%.2lf ", at(i, j));
+        fprintf(stream, "\n");
+    }
+}
+
+Matrix Matrix::read(FILE *stream, MatrixParseError *where)
+{
+    return readText(stream, true, where);
+}
+
+size_t Matrix::numRows() const
+{
+    return rows;
+}
+
+size_t Matrix::numCols() const
+{
+    return cols;
+}
+
+MatrixError Matrix::getError() const
+{
+    return error;
+}
+
+void Matrix::clearError()
+{
+    error = MATRIX_SUCCESS;
+}
+
+Matrix Matrix::scalarMultiply(double scalar, unsigned threads) const
+{
+    Matrix result;
+    result.assign(*this * scalar, threads);
+    return result;
+}
+
+Matrix Matrix::resize(size_t newRows, size_t newCols) const
+{
+    Matrix result(newRows, newCols);
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+    size_t r = std::min(rows, newRows), c = std::min(cols, newCols);
+    result.block(0, 0, r, c) = block(0, 0, r, c);
+    return result;
+}
+
+void Matrix::swapRows(size_t row1, size_t row2)
+{
+    if (row1 >= rows || row2 >= rows)
+        return;
+    for (size_t j = 0; j < cols; ++j)
+        std::swap(at(row1, j), at(row2, j));
+}
+
+void Matrix::scaleRow(size_t row, double scalar)
+{
+    if (row >= rows)
+        return;
+    for (size_t j = 0; j < cols; ++j)
+        at(row, j) *= scalar;
+}
+
+void Matrix::addRows(size_t srcRow, size_t destRow, double scalar)
+{
+    if (srcRow >= rows || destRow >= rows)
+        return;
+    for (size_t j = 0; j < cols; ++j)
+        at(destRow, j) += at(srcRow, j) * scalar;
+}
+
+void Matrix::swapCols(size_t col1, size_t col2)
+{
+    if (col1 >= cols || col2 >= cols)
+        return;
+    for (size_t i = 0; i < rows; ++i)
+        std::swap(at(i, col1), at(i, col2));
+}
+
+void Matrix::scaleCol(size_t col, double scalar)
+{
+    if (col >= cols)
+        return;
+    for (size_t i = 0; i < rows; ++i)
+        at(i, col) *= scalar;
+}
+
+void Matrix::addCols(size_t srcCol, size_t destCol, double scalar)
+{
+    if (srcCol >= cols || destCol >= cols)
+        return;
+    for (size_t i = 0; i < rows; ++i)
+        at(i, destCol) += at(i, srcCol) * scalar;
+}
+
+Matrix Matrix::cofactor() const
+{
+    if (rows != cols)
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_INVALID;
+        return result;
+    }
+    // cof(A) = det(A) * inverse(A)^T when A is invertible
+    LUDecomposition lu(*this);
+    if (lu.getError() == MATRIX_SUCCESS && !lu.isSingular())
+        return lu.inverse().transpose().scalarMultiply(lu.determinant());
+
+    Matrix result(rows, cols);
+    Matrix sub(rows - 1, cols - 1);
+    if (result.error != MATRIX_SUCCESS || (rows && sub.error != MATRIX_SUCCESS))
+    {
+        result.error = MATRIX_ERR_ALLOC;
+        return result;
+    }
+    for (size_t i = 0; i < rows; ++i)
+    {
+        for (size_t j = 0; j < cols; ++j)
+        {
+            for (size_t r = 0, sr = 0; r < rows; ++r)
+            {
+                if (r == i)
+                    continue;
+                for (size_t c = 0, sc = 0; c < cols; ++c)
+                {
+                    if (c == j)
+                        continue;
+                    sub.at(sr, sc++) = at(r, c);
+                }
+                sr++;
+            }
+            result.at(i, j) = ((i + j) % 2 ? -1.0 : 1.0) * sub.determinant();
+        }
+    }
+    return result;
+}
+
+double Matrix::determinant() const
+{
+    if (rows != cols)
+        return 0.0;
+    if (rows == 1)
+        return at(0, 0);
+    if (rows == 2)
+        return at(0, 0) * at(1, 1) - at(0, 1) * at(1, 0);
+    return LUDecomposition(*this).determinant();
+}
+
+Matrix Matrix::adjoint() const
+{
+    return cofactor().transpose();
+}
+
+Matrix Matrix::inverse() const
+{
+    LUDecomposition lu(*this);
+    if (lu.getError() != MATRIX_SUCCESS || lu.isSingular())
+    {
+        Matrix result;
+        result.error = MATRIX_ERR_INVALID;
+        return result;
+    }
+    return lu.inverse();
+}
+
+// ---- LU decomposition ----
+
+// panels at most this wide are factored column by column, and triangular
+// solves at most this large are done by substitution
+#define LU_BLOCK 32
+// up to this many right-hand sides, triangular solves run row by row as dot
+// products with the contiguous rows of L and U
+#define LU_DOT_RHS 4
+
+// P A = L U of an m x n panel (m >= n) with partial pivoting, one column
+// at a time; pivots are relative to the panel's first row. A zero pivot
+// column is left as it is.
+static void luPanel(size_t m, size_t n, double *a, size_t lda, size_t *piv)
+{
+    for (size_t j = 0; j < n; ++j)
+    {
+        size_t p = j;
+        double best = std::fabs(a[j * lda + j]);
+        for (size_t i = j + 1; i < m; ++i)
+            if (std::fabs(a[i * lda + j]) > best)
+            {
+                best = std::fabs(a[i * lda + j]);
+                p = i;
+            }
+        piv[j] = p;
+        if (best == 0.0)
+            continue;
+        if (p != j)
+            std::swap_ranges(a + j * lda, a + j * lda + n, a + p * lda);
+        double d = a[j * lda + j];
+        for (size_t i = j + 1; i < m; ++i)
+        {
+            double *row = a + i * lda;
+            double l = row[j] /= d;
+            const double *top = a + j * lda;
+            for (size_t c = j + 1; c < n; ++c)
+                row[c] -= l * top[c];
+        }
+    }
+}
+
+// the row swaps piv[from..to) applied to columns [0, n) of a
+static void applyPivots(size_t n, double *a, size_t lda, const size_t *piv, size_t from, size_t to)
+{
+    for (size_t i = from; i < to; ++i)
+        if (piv[i] != i)
+            std::swap_ranges(a + i * lda, a + i * lda + n, a + piv[i] * lda);
+}
+
+// B (n x m) = L^-1 B, L lower triangular n x n with a unit diagonal (not
+// read) when unit is set; recursive halving puts most of the work in the
+// blocked kernel
+static bool solveLower(size_t n, size_t m, const double *l, size_t ldl, double *b, size_t ldb, bool unit)
+{
+    if (m <= LU_DOT_RHS)
+    {
+        for (size_t j = 0; j < m; ++j)
+            for (size_t i = 0; i < n; ++i)
+            {
+                const double *row = l + i * ldl;
+                double s = b[i * ldb + j];
+                for (size_t p = 0; p < i; ++p)
+                    s -= row[p] * b[p * ldb + j];
+                b[i * ldb + j] = unit ? s : s / row[i];
+            }
+        return true;
+    }
+    if (n <= LU_BLOCK)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t p = 0; p < i; ++p)
+            {
+                double lip = l[i * ldl + p];
+                for (size_t j = 0; j < m; ++j)
+                    b[i * ldb + j] -= lip * b[p * ldb + j];
+            }
+            if (!unit)
+            {
+                double d = l[i * ldl + i];
+                for (size_t j = 0; j < m; ++j)
+                    b[i * ldb + j] /= d;
+            }
+        }
+        return true;
+    }
+    size_t n1 = n / 2;
+    bool ok = solveLower(n1, m, l, ldl, b, ldb, unit);
+    ok &= parallelGemm(n - n1, m, n1, l + n1 * ldl, ldl, b, ldb, b + n1 * ldb, ldb, 0, -1.0);
+    ok &= solveLower(n - n1, m, l + n1 * ldl + n1, ldl, b + n1 * ldb, ldb, unit);
+    return ok;
+}
+
+// B (n x m) = U^-1 B, U upper triangular n x n
+static bool solveUpper(size_t n, size_t m, const double *u, size_t ldu, double *b, size_t ldb)
+{
+    if (m <= LU_DOT_RHS)
+    {
+        for (size_t j = 0; j < m; ++j)
+            for (size_t i = n; i-- > 0;)
+            {
+                const double *row = u + i * ldu;
+                double s = b[i * ldb + j];
+                for (size_t p = i + 1; p < n; ++p)
+                    s -= row[p] * b[p * ldb + j];
+                b[i * ldb + j] = s / row[i];
+            }
+        return true;
+    }
+    if (n <= LU_BLOCK)
+    {
+        for (size_t i = n; i-- > 0;)
+        {
+            for (size_t p = i + 1; p < n; ++p)
+            {
+                double uip = u[i * ldu + p];
+                for (size_t j = 0; j < m; ++j)
+                    b[i * ldb + j] -= uip * b[p * ldb + j];
+            }
+            double d = u[i * ldu + i];
+            for (size_t j = 0; j < m; ++j)
+                b[i * ldb + j] /= d;
+        }
+        return true;
+    }
+    size_t n1 = n / 2;
+    bool ok = solveUpper(n - n1, m, u + n1 * ldu + n1, ldu, b + n1 * ldb, ldb);
+    ok &= parallelGemm(n1, m, n - n1, u + n1, ldu, b + n1 * ldb, ldb, b, ldb, 0, -1.0);
+    ok &= solveUpper(n1, m, u, ldu, b, ldb);
+    return ok;
+}
+
+// recursive LU of an m x n block (m >= n): factor the left half, update
+// and factor the right half, so the bulk of the flops is one large
+// trailing product per level and the working set halves at each step
+static bool luRecursive(size_t m, size_t n, double *a, size_t lda, size_t *piv)
+{
+    if (n <= LU_BLOCK)
+    {
+        luPanel(m, n, a, lda, piv);
+        return true;
+    }
+    size_t n1 = n / 2, n2 = n - n1;
+    bool ok = luRecursive(m, n1, a, lda, piv);
+    applyPivots(n2, a + n1, lda, piv, 0, n1);
+    ok &= solveLower(n1, n2, a, lda, a + n1, lda, true);
+    ok &= parallelGemm(m - n1, n2, n1, a + n1 * lda, lda, a + n1, lda, a + n1 * lda + n1, lda, 0, -1.0);
+    ok &= luRecursive(m - n1, n2, a + n1 * lda + n1, lda, piv + n1);
+    for (size_t i = n1; i < n; ++i)
+        piv[i] += n1;
+    applyPivots(n1, a, lda, piv, n1, n);
+    return ok;
+}
+
+LUDecomposition::LUDecomposition() : error(MATRIX_ERR_INVALID) {}
+
+LUDecomposition::LUDecomposition(ConstMatrixView a) : error(MATRIX_SUCCESS)
+{
+    factor(a);
+}
+
+MatrixError LUDecomposition::factor(ConstMatrixView a)
+{
+    if (a.numRows() != a.numCols())
+        return error = MATRIX_ERR_INVALID;
+    lu = a;
+    return decompose();
+}
+
+MatrixError LUDecomposition::factor(Matrix &&a)
+{
+    if (a.rows != a.cols)
+        return error = MATRIX_ERR_INVALID;
+    lu = std::move(a);
+    return decompose();
+}
+
+MatrixError LUDecomposition::decompose()
+{
+    if (lu.error != MATRIX_SUCCESS)
+        return error = lu.error;
+    pivots.resize(lu.rows);
+    error = luRecursive(lu.rows, lu.rows, lu.data, lu.cols, pivots.data()) ? MATRIX_SUCCESS : MATRIX_ERR_ALLOC;
+    return error;
+}
+
+size_t LUDecomposition::size() const
+{
+    return lu.rows;
+}
+
+MatrixError LUDecomposition::getError() const
+{
+    return error;
+}
+
+const Matrix &LUDecomposition::packed() const
+{
+    return lu;
+}
+
+const std::vector<size_t> &LUDecomposition::pivotRows() const
+{
+    return pivots;
+}
+
+bool LUDecomposition::isSingular() const
+{
+    for (size_t i = 0; i < lu.rows; ++i)
+        if (lu.at(i, i) == 0.0)
+            return true;
+    return false;
+}
+
+size_t LUDecomposition::rank() const
+{
+    double largest = 0.0;
+    for (size_t i = 0; i < lu.rows; ++i)
+        largest = std::max(largest, std::fabs(lu.at(i, i)));
+    double tol = largest * lu.rows * DBL_EPSILON;
+    size_t r = 0;
+    for (size_t i = 0; i < lu.rows; ++i)
+        if (std::fabs(lu.at(i, i)) > tol)
+            ++r;
+    return r;
+}
+
+double LUDecomposition::determinant() const
+{
+    if (error != MATRIX_SUCCESS)
+        return 0.0;
+    double det = 1.0;
+    for (size_t i = 0; i < lu.rows; ++i)
+        det *= pivots[i] != i ? -lu.at(i, i) : lu.at(i, i);
+    return det;
+}
+
+double LUDecomposition::logDeterminant(int &sign) const
+{
+    sign = error == MATRIX_SUCCESS ? 1 : 0;
+    double logDet = 0.0;
+    for (size_t i = 0; i < lu.rows && sign; ++i)
+    {
+        double u = lu.at(i, i);
+        if (u == 0.0)
+            sign = 0;
+        if ((u < 0) != (pivots[i] != i))
+            sign = -sign;
+        logDet += std::log(std::fabs(u));
+    }
+    return sign ? logDet : -HUGE_VAL;
+}
+
+Matrix LUDecomposition::inverse() const
+{
+    Matrix x(lu.rows, lu.rows);
+    if (x.error != MATRIX_SUCCESS)
+        return x;
+    for (size_t i = 0; i < lu.rows; ++i)
+        x.at(i, i) = 1.0;
+    MatrixError e = solveInPlace(x);
+    if (e != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = e;
+        return result;
+    }
+    return x;
+}
+
+// the solves work on row-major right-hand sides: a view with strided
+// columns is solved through a copy, which solve() writes back
+static MatrixError solveThroughCopy(MatrixView b, MatrixError (*solve)(const void *, MatrixView),
+                                    const void *factorization)
+{
+    Matrix t = b;
+    if (t.getError() != MATRIX_SUCCESS)
+        return t.getError();
+    MatrixError e = solve(factorization, t);
+    if (e == MATRIX_SUCCESS)
+        b = t;
+    return e;
+}
+
+template <class F>
+static MatrixError solveFactorization(const void *f, MatrixView b)
+{
+    return static_cast<const F *>(f)->solveInPlace(b);
+}
+
+MatrixError LUDecomposition::solveInPlace(MatrixView b) const
+{
+    if (error != MATRIX_SUCCESS)
+        return error;
+    if (b.numRows() != lu.rows)
+        return MATRIX_ERR_DIM_MISMATCH;
+    if (isSingular())
+        return MATRIX_ERR_INVALID;
+    if (b.colStride() != 1 && b.numCols() > 1)
+        return solveThroughCopy(b, &solveFactorization<LUDecomposition>, this);
+    // L U X = P B
+    size_t k = b.numCols(), ldb = b.rowStride();
+    applyPivots(k, b.data(), ldb, pivots.data(), 0, lu.rows);
+    if (!solveLower(lu.rows, k, lu.data, lu.cols, b.data(), ldb, true) ||
+        !solveUpper(lu.rows, k, lu.data, lu.cols, b.data(), ldb))
+        return MATRIX_ERR_ALLOC;
+    return MATRIX_SUCCESS;
+}
+
+Matrix LUDecomposition::solve(ConstMatrixView b) const
+{
+    Matrix x = b;
+    MatrixError e = solveInPlace(x);
+    if (e != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = e;
+        return result;
+    }
+    return x;
+}
+
+Matrix solve(ConstMatrixView a, ConstMatrixView b)
+{
+    if (a.numRows() != a.numCols() || a.numRows() != b.numRows())
+    {
+        Matrix result;
+        result.error = a.numRows() != a.numCols() ? MATRIX_ERR_INVALID : MATRIX_ERR_DIM_MISMATCH;
+        return result;
+    }
+    return LUDecomposition(a).solve(b);
+}
+
+// ---- Cholesky decomposition ----
+
+// diagonal blocks of the symmetric trailing update up to this size are
+// updated in full by the blocked kernel
+#define CHOL_SYRK_BLOCK 128
+
+// lower triangle of C (n x n) -= L T, L n x k and T = L^T k x n; blocks off
+// the diagonal go to the blocked kernel and the diagonal ones recurse, so
+// only a thin band above the diagonal is computed needlessly
+static bool syrkLower(size_t n, size_t k, const double *l, size_t ldl, const double *t, size_t ldt, double *c,
+                      size_t ldc)
+{
+    if (n <= CHOL_SYRK_BLOCK)
+        return parallelGemm(n, n, k, l, ldl, t, ldt, c, ldc, 0, -1.0);
+    size_t n1 = n / 2;
+    bool ok = syrkLower(n1, k, l, ldl, t, ldt, c, ldc);
+    ok &= parallelGemm(n - n1, n1, k, l + n1 * ldl, ldl, t, ldt, c + n1 * ldc, ldc, 0, -1.0);
+    ok &= syrkLower(n - n1, k, l + n1 * ldl, ldl, t + n1, ldt, c + n1 * ldc + n1, ldc);
+    return ok;
+}
+
+// B (n x m) = L^-T B, L lower triangular n x n. Past LU_DOT_RHS columns and
+// LU_BLOCK rows the off-diagonal block of L is transposed into work, which
+// holds (n / 2) * (n - n / 2) doubles, for the blocked kernel.
+static bool solveLowerTrans(size_t n, size_t m, const double *l, size_t ldl, double *b, size_t ldb, double *work)
+{
+    if (m <= LU_DOT_RHS || n <= LU_BLOCK)
+    {
+        for (size_t i = n; i-- > 0;)
+        {
+            const double *row = l + i * ldl;
+            double *bi = b + i * ldb;
+            for (size_t j = 0; j < m; ++j)
+                bi[j] /= row[i];
+            for (size_t p = 0; p < i; ++p)
+                for (size_t j = 0; j < m; ++j)
+                    b[p * ldb + j] -= row[p] * bi[j];
+        }
+        return true;
+    }
+    size_t n1 = n / 2, n2 = n - n1;
+    bool ok = solveLowerTrans(n2, m, l + n1 * ldl + n1, ldl, b + n1 * ldb, ldb, work);
+    transposeBlock(n2, n1, l + n1 * ldl, ldl, work, n2);
+    ok &= parallelGemm(n1, m, n2, work, n2, b + n1 * ldb, ldb, b, ldb, 0, -1.0);
+    ok &= solveLowerTrans(n1, m, l, ldl, b, ldb, work);
+    return ok;
+}
+
+// A = L L^T from the lower triangle of an n x n block, L written over it:
+// factor the leading half, solve for the panel below it, update the trailing
+// half symmetrically and recurse. work holds (n / 2) * (n - n / 2) doubles.
+static MatrixError choleskyRecursive(size_t n, double *a, size_t lda, double *work)
+{
+    if (n <= LU_BLOCK)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            double *rj = a + j * lda;
+            double d = rj[j];
+            for (size_t p = 0; p < j; ++p)
+                d -= rj[p] * rj[p];
+            if (!(d > 0.0))
+                return MATRIX_ERR_INVALID;
+            d = rj[j] = std::sqrt(d);
+            for (size_t i = j + 1; i < n; ++i)
+            {
+                double *ri = a + i * lda;
+                double s = ri[j];
+                for (size_t p = 0; p < j; ++p)
+                    s -= ri[p] * rj[p];
+                ri[j] = s / d;
+            }
+        }
+        return MATRIX_SUCCESS;
+    }
+    size_t n1 = n / 2, n2 = n - n1;
+    MatrixError e = choleskyRecursive(n1, a, lda, work);
+    if (e != MATRIX_SUCCESS)
+        return e;
+    // L21 = A21 L11^-T, computed transposed as L11^-1 A21^T; the transposed
+    // panel is then the right operand of the trailing update
+    transposeBlock(n2, n1, a + n1 * lda, lda, work, n2);
+    bool ok = solveLower(n1, n2, a, lda, work, n2, false);
+    transposeBlock(n1, n2, work, n2, a + n1 * lda, lda);
+    ok &= syrkLower(n2, n1, a + n1 * lda, lda, work, n2, a + n1 * lda + n1, lda);
+    if (!ok)
+        return MATRIX_ERR_ALLOC;
+    return choleskyRecursive(n2, a + n1 * lda + n1, lda, work);
+}
+
+CholeskyDecomposition::CholeskyDecomposition() : error(MATRIX_ERR_INVALID) {}
+
+CholeskyDecomposition::CholeskyDecomposition(ConstMatrixView a) : error(MATRIX_SUCCESS)
+{
+    factor(a);
+}
+
+MatrixError CholeskyDecomposition::factor(ConstMatrixView a)
+{
+    if (a.numRows() != a.numCols())
+        return error = MATRIX_ERR_INVALID;
+    l = a;
+    return decompose();
+}
+
+MatrixError CholeskyDecomposition::factor(Matrix &&a)
+{
+    if (a.rows != a.cols)
+        return error = MATRIX_ERR_INVALID;
+    l = std::move(a);
+    return decompose();
+}
+
+MatrixError CholeskyDecomposition::decompose()
+{
+    if (l.error != MATRIX_SUCCESS)
+        return error = l.error;
+    size_t n = l.rows;
+    work.resize((n / 2) * (n - n / 2));
+    error = choleskyRecursive(n, l.data, n, work.data());
+    if (error == MATRIX_SUCCESS)
+        for (size_t i = 0; i < n; ++i)
+            std::fill(l.data + i * n + i + 1, l.data + (i + 1) * n, 0.0);
+    return error;
+}
+
+size_t CholeskyDecomposition::size() const
+{
+    return l.rows;
+}
+
+MatrixError CholeskyDecomposition::getError() const
+{
+    return error;
+}
+
+const Matrix &CholeskyDecomposition::lower() const
+{
+    return l;
+}
+
+double CholeskyDecomposition::determinant() const
+{
+    if (error != MATRIX_SUCCESS)
+        return 0.0;
+    double det = 1.0;
+    for (size_t i = 0; i < l.rows; ++i)
+        det *= l.at(i, i) * l.at(i, i);
+    return det;
+}
+
+double CholeskyDecomposition::logDeterminant() const
+{
+    if (error != MATRIX_SUCCESS)
+        return -HUGE_VAL;
+    double logDet = 0.0;
+    for (size_t i = 0; i < l.rows; ++i)
+        logDet += std::log(l.at(i, i));
+    return 2.0 * logDet;
+}
+
+MatrixError CholeskyDecomposition::solveInPlace(MatrixView b) const
+{
+    if (error != MATRIX_SUCCESS)
+        return error;
+    if (b.numRows() != l.rows)
+        return MATRIX_ERR_DIM_MISMATCH;
+    if (b.colStride() != 1 && b.numCols() > 1)
+        return solveThroughCopy(b, &solveFactorization<CholeskyDecomposition>, this);
+    // L L^T X = B
+    size_t n = l.rows, k = b.numCols(), ldb = b.rowStride();
+    std::vector<double> t(k > LU_DOT_RHS ? (n / 2) * (n - n / 2) : 0);
+    if (!solveLower(n, k, l.data, n, b.data(), ldb, false) ||
+        !solveLowerTrans(n, k, l.data, n, b.data(), ldb, t.data()))
+        return MATRIX_ERR_ALLOC;
+    return MATRIX_SUCCESS;
+}
+
+Matrix CholeskyDecomposition::solve(ConstMatrixView b) const
+{
+    Matrix x = b;
+    MatrixError e = solveInPlace(x);
+    if (e != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = e;
+        return result;
+    }
+    return x;
+}
+
+// ---- QR decomposition ----
+
+// columns per Householder panel, applied to the rest as one block reflector
+#define QR_BLOCK 32
+
+// H = I - tau v v^T with H x = (beta, 0, ..., 0)^T for the n entries x[0],
+// x[inc], ...: beta replaces x[0] and v[1..] the rest (v[0] = 1 is implied).
+// Returns tau, 0 when x is already reduced. The norm is taken on x scaled by
+// its largest entry, so it cannot overflow.
+static double householder(size_t n, double *x, size_t inc)
+{
+    double scale = 0.0;
+    for (size_t i = 1; i < n; ++i)
+        scale = std::max(scale, std::fabs(x[i * inc]));
+    if (scale == 0.0)
+        return 0.0;
+    double ss = 0.0;
+    for (size_t i = 1; i < n; ++i)
+    {
+        double t = x[i * inc] / scale;
+        ss += t * t;
+    }
+    double alpha = x[0];
+    double beta = -std::copysign(std::hypot(alpha, scale * std::sqrt(ss)), alpha);
+    double f = 1.0 / (alpha - beta);
+    for (size_t i = 1; i < n; ++i)
+        x[i * inc] *= f;
+    x[0] = beta;
+    return (beta - alpha) / beta;
+}
+
+// unblocked QR of an m x nb panel, each reflector applied to the panel
+// columns right of it a row at a time; w holds nb doubles
+static void qrPanel(size_t m, size_t nb, double *a, size_t lda, double *tau, double *w)
+{
+    for (size_t c = 0; c < nb && c < m; ++c)
+    {
+        tau[c] = householder(m - c, a + c * lda + c, lda);
+        size_t q = nb - c - 1;
+        if (tau[c] == 0.0 || q == 0)
+            continue;
+        double *top = a + c * lda + c + 1;
+        std::memcpy(w, top, sizeof(double) * q);
+        for (size_t i = c + 1; i < m; ++i)
+        {
+            double v = a[i * lda + c];
+            const double *row = a + i * lda + c + 1;
+            for (size_t j = 0; j < q; ++j)
+                w[j] += v * row[j];
+        }
+        for (size_t j = 0; j < q; ++j)
+            top[j] -= w[j] *= tau[c];
+        for (size_t i = c + 1; i < m; ++i)
+        {
+            double v = a[i * lda + c];
+            double *row = a + i * lda + c + 1;
+            for (size_t j = 0; j < q; ++j)
+                row[j] -= v * w[j];
+        }
+    }
+}
+
+// V (m x nb, unit lower trapezoidal) and V^T from the reflectors stored
+// below the diagonal of a panel
+static void loadReflectors(size_t m, size_t nb, const double *a, size_t lda, double *v, double *vt)
+{
+    for (size_t i = 0; i < m; ++i)
+        for (size_t k = 0; k < nb; ++k)
+        {
+            double x = i > k ? a[i * lda + k] : i == k ? 1.0 : 0.0;
+            v[i * nb + k] = x;
+            vt[k * m + i] = x;
+        }
+}
+
+// upper triangular T (nb x nb) with H_0 H_1 ... H_nb-1 = I - V T V^T
+static void reflectorFactor(size_t m, size_t nb, const double *vt, const double *tau, double *t)
+{
+    for (size_t i = 0; i < nb; ++i)
+    {
+        t[i * nb + i] = tau[i];
+        for (size_t k = i + 1; k < nb; ++k)
+            t[k * nb + i] = 0.0;
+        // z = V[:, 0:i]^T v_i into column i, then T[0:i, i] = -tau_i T[0:i, 0:i] z
+        for (size_t k = 0; k < i; ++k)
+        {
+            double z = 0.0;
+            for (size_t r = i; r < m; ++r)
+                z += vt[k * m + r] * vt[i * m + r];
+            t[k * nb + i] = z;
+        }
+        for (size_t r = 0; r < i; ++r)
+        {
+            double s = 0.0;
+            for (size_t k = r; k < i; ++k)
+                s += t[r * nb + k] * t[k * nb + i];
+            t[r * nb + i] = -tau[i] * s;
+        }
+    }
+}
+
+// C (m x n) = (I - V T V^T) C, or with T^T when trans is set (Q^T C); w
+// holds nb * n doubles
+static bool applyBlockReflector(size_t m, size_t n, size_t nb, const double *v, const double *vt,
+                                const double *t, double *c, size_t ldc, double *w, bool trans)
+{
+    std::fill(w, w + nb * n, 0.0);
+    bool ok = parallelGemm(nb, n, m, vt, m, c, ldc, w, n, 0);
+    if (trans)
+        for (size_t r = nb; r-- > 0;)
+        {
+            double *wr = w + r * n;
+            for (size_t j = 0; j < n; ++j)
+                wr[j] *= t[r * nb + r];
+            for (size_t k = 0; k < r; ++k)
+            {
+                double tkr = t[k * nb + r];
+                const double *wk = w + k * n;
+                for (size_t j = 0; j < n; ++j)
+                    wr[j] += tkr * wk[j];
+            }
+        }
+    else
+        for (size_t r = 0; r < nb; ++r)
+        {
+            double *wr = w + r * n;
+            for (size_t j = 0; j < n; ++j)
+                wr[j] *= t[r * nb + r];
+            for (size_t k = r + 1; k < nb; ++k)
+            {
+                double trk = t[r * nb + k];
+                const double *wk = w + k * n;
+                for (size_t j = 0; j < n; ++j)
+                    wr[j] += trk * wk[j];
+            }
+        }
+    ok &= parallelGemm(m, n, nb, v, nb, w, n, c, ldc, 0, -1.0);
+    return ok;
+}
+
+// doubles of workspace for applying the reflectors of an m-row QR to n columns
+static size_t qrWorkSize(size_t m, size_t n)
+{
+    return 2 * m * QR_BLOCK + QR_BLOCK * std::max(n, (size_t)QR_BLOCK);
+}
+
+// C (m x n) = Q^T C, or Q C without trans, for the factorization packed in
+// a (m x k) with the block factors blocks; work holds qrWorkSize(m, n)
+static bool applyQ(size_t m, size_t k, const double *a, size_t lda, const double *blocks, double *c, size_t ldc,
+                   size_t n, double *work, bool trans)
+{
+    double *v = work, *vt = work + m * QR_BLOCK, *w = vt + m * QR_BLOCK;
+    size_t panels = (k + QR_BLOCK - 1) / QR_BLOCK;
+    bool ok = true;
+    for (size_t p = 0; p < panels; ++p)
+    {
+        size_t j = (trans ? p : panels - 1 - p) * QR_BLOCK;
+        size_t nb = std::min(k - j, (size_t)QR_BLOCK);
+        loadReflectors(m - j, nb, a + j * lda + j, lda, v, vt);
+        ok &= applyBlockReflector(m - j, n, nb, v, vt, blocks + j * QR_BLOCK, c + j * ldc, ldc, w, trans);
+    }
+    return ok;
+}
+
+QRDecomposition::QRDecomposition() : error(MATRIX_ERR_INVALID) {}
+
+QRDecomposition::QRDecomposition(ConstMatrixView a) : error(MATRIX_SUCCESS)
+{
+    factor(a);
+}
+
+MatrixError QRDecomposition::factor(ConstMatrixView a)
+{
+    if (a.numRows() < a.numCols())
+        return error = MATRIX_ERR_INVALID;
+    qr = a;
+    return decompose();
+}
+
+MatrixError QRDecomposition::factor(Matrix &&a)
+{
+    if (a.rows < a.cols)
+        return error = MATRIX_ERR_INVALID;
+    qr = std::move(a);
+    return decompose();
+}
+
+// blocked Householder QR: each panel is factored unblocked, and its
+// reflectors reach the trailing columns as one block reflector, two
+// products in the blocked kernel
+MatrixError QRDecomposition::decompose()
+{
+    if (qr.error != MATRIX_SUCCESS)
+        return error = qr.error;
+    size_t m = qr.rows, n = qr.cols;
+    tau.resize(n);
+    blocks.resize(n * QR_BLOCK);
+    work.resize(qrWorkSize(m, n));
+    double *v = work.data(), *vt = v + m * QR_BLOCK, *w = vt + m * QR_BLOCK;
+    bool ok = true;
+    for (size_t j = 0; j < n; j += QR_BLOCK)
     {
-        for (size_t j = 0; j < cols; ++j)
-            fprintf(stream, "%.2lf ", at(i, j));
-        fprintf(stream, "\n");
+        size_t nb = std::min(n - j, (size_t)QR_BLOCK);
+        double *panel = qr.data + j * n + j;
+        qrPanel(m - j, nb, panel, n, tau.data() + j, w);
+        loadReflectors(m - j, nb, panel, n, v, vt);
+        reflectorFactor(m - j, nb, vt, tau.data() + j, blocks.data() + j * QR_BLOCK);
+        if (j + nb < n)
+            ok &= applyBlockReflector(m - j, n - j - nb, nb, v, vt, blocks.data() + j * QR_BLOCK, panel + nb, n,
+                                      w, true);
     }
+    return error = ok ? MATRIX_SUCCESS : MATRIX_ERR_ALLOC;
 }
 
-Matrix Matrix::read(FILE *stream)
+size_t QRDecomposition::numRows() const
 {
-    size_t r, c;
-    fscanf(stream, "%zu %zu", &r, &c);
-    Matrix result(r, c);
-    for (size_t i = 0; i < r; ++i)
-        for (size_t j = 0; j < c; ++j)
-            fscanf(stream, "%lf", &result.at(i, j));
+    return qr.rows;
+}
+
+size_t QRDecomposition::numCols() const
+{
+    return qr.cols;
+}
+
+MatrixError QRDecomposition::getError() const
+{
+    return error;
+}
+
+const Matrix &QRDecomposition::packed() const
+{
+    return qr;
+}
+
+bool QRDecomposition::isRankDeficient() const
+{
+    for (size_t i = 0; i < qr.cols; ++i)
+        if (qr.at(i, i) == 0.0)
+            return true;
+    return false;
+}
+
+Matrix QRDecomposition::r() const
+{
+    if (error != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = error;
+        return result;
+    }
+    size_t n = qr.cols;
+    Matrix result(n, n);
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+    for (size_t i = 0; i < n; ++i)
+        std::memcpy(result.data + i * n + i, qr.data + i * n + i, sizeof(double) * (n - i));
     return result;
 }
-size_t Matrix::numRows() const
+
+Matrix QRDecomposition::q() const
+{
+    if (error != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = error;
+        return result;
+    }
+    size_t m = qr.rows, n = qr.cols;
+    Matrix result(m, n);
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+    for (size_t i = 0; i < n; ++i)
+        result.at(i, i) = 1.0;
+    std::vector<double> w(qrWorkSize(m, n));
+    if (!applyQ(m, n, qr.data, n, blocks.data(), result.data, n, n, w.data(), false))
+        result.error = MATRIX_ERR_ALLOC;
+    return result;
+}
+
+MatrixError QRDecomposition::solveInPlace(MatrixView b) const
+{
+    if (error != MATRIX_SUCCESS)
+        return error;
+    if (b.numRows() != qr.rows)
+        return MATRIX_ERR_DIM_MISMATCH;
+    if (isRankDeficient())
+        return MATRIX_ERR_INVALID;
+    if (b.colStride() != 1 && b.numCols() > 1)
+        return solveThroughCopy(b, &solveFactorization<QRDecomposition>, this);
+    size_t m = qr.rows, n = qr.cols, k = b.numCols(), ldb = b.rowStride();
+    double *y = b.data();
+    // Q^T B, reflector by reflector for a few columns, else blockwise
+    if (k <= LU_DOT_RHS)
+    {
+        for (size_t c = 0; c < n; ++c)
+        {
+            if (tau[c] == 0.0)
+                continue;
+            for (size_t j = 0; j < k; ++j)
+            {
+                double s = y[c * ldb + j];
+                for (size_t i = c + 1; i < m; ++i)
+                    s += qr.data[i * n + c] * y[i * ldb + j];
+                s *= tau[c];
+                y[c * ldb + j] -= s;
+                for (size_t i = c + 1; i < m; ++i)
+                    y[i * ldb + j] -= qr.data[i * n + c] * s;
+            }
+        }
+    }
+    else
+    {
+        std::vector<double> w(qrWorkSize(m, k));
+        if (!applyQ(m, n, qr.data, n, blocks.data(), y, ldb, k, w.data(), true))
+            return MATRIX_ERR_ALLOC;
+    }
+    // R X = (Q^T B)[0, n)
+    if (!solveUpper(n, k, qr.data, n, y, ldb))
+        return MATRIX_ERR_ALLOC;
+    return MATRIX_SUCCESS;
+}
+
+Matrix QRDecomposition::solve(ConstMatrixView b) const
+{
+    Matrix y = b;
+    MatrixError e = solveInPlace(y);
+    if (e != MATRIX_SUCCESS)
+    {
+        Matrix result;
+        result.error = e;
+        return result;
+    }
+    return y.block(0, 0, qr.cols, y.cols);
+}
+
+Matrix leastSquares(ConstMatrixView a, ConstMatrixView b)
+{
+    if (a.numRows() < a.numCols() || a.numRows() != b.numRows())
+    {
+        Matrix result;
+        result.error = a.numRows() < a.numCols() ? MATRIX_ERR_INVALID : MATRIX_ERR_DIM_MISMATCH;
+        return result;
+    }
+    return QRDecomposition(a).solve(b);
+}
+
+// ---- Sparse matrices ----
+
+// the largest row or column count four-byte indices can address
+#define SPARSE_MAX_DIM ((size_t)UINT32_MAX)
+
+// offsets of n buckets from the counts in start[1..n]; start[b] then serves
+// as the fill cursor of bucket b, and unshiftBuckets restores the offsets
+static void prefixBuckets(size_t *start, size_t n)
+{
+    for (size_t b = 0; b < n; ++b)
+        start[b + 1] += start[b];
+}
+
+static void unshiftBuckets(size_t *start, size_t n)
+{
+    for (size_t b = n; b > 0; --b)
+        start[b] = start[b - 1];
+    start[0] = 0;
+}
+
+// the other compressed form of the same matrix: n slices over m indices in,
+// m slices over n out, by a stable counting sort, so every slice comes out
+// in increasing index order
+static void transposeCompressed(size_t n, size_t m, const size_t *ptr, const uint32_t *idx, const double *val,
+                                size_t *tptr, uint32_t *tidx, double *tval)
+{
+    std::fill(tptr, tptr + m + 1, (size_t)0);
+    for (size_t p = 0; p < ptr[n]; ++p)
+        ++tptr[idx[p] + 1];
+    prefixBuckets(tptr, m);
+    for (size_t s = 0; s < n; ++s)
+        for (size_t p = ptr[s]; p < ptr[s + 1]; ++p)
+        {
+            size_t q = tptr[idx[p]]++;
+            tidx[q] = (uint32_t)s;
+            tval[q] = val[p];
+        }
+    unshiftBuckets(tptr, m);
+}
+
+SparseMatrix::SparseMatrix() : rows(0), cols(0), format(SPARSE_CSR), ptr(1, 0), error(MATRIX_SUCCESS) {}
+
+SparseMatrix::SparseMatrix(size_t r, size_t c, SparseFormat f)
+    : rows(r), cols(c), format(f), error(MATRIX_SUCCESS)
+{
+    if (r > SPARSE_MAX_DIM || c > SPARSE_MAX_DIM)
+    {
+        rows = cols = 0;
+        error = MATRIX_ERR_INVALID;
+    }
+    ptr.assign((format == SPARSE_CSR ? rows : cols) + 1, 0);
+}
+
+SparseMatrix SparseMatrix::fromDense(ConstMatrixView a, double tolerance, SparseFormat format)
+{
+    // rows are contiguous in the usual layouts, so CSC goes through CSR
+    if (format == SPARSE_CSC)
+        return fromDense(a, tolerance, SPARSE_CSR).convert(SPARSE_CSC);
+    SparseMatrix s(a.numRows(), a.numCols());
+    if (s.error != MATRIX_SUCCESS)
+        return s;
+    // NaNs are kept: they are not within tolerance of zero
+    for (size_t i = 0; i < s.rows; ++i)
+    {
+        size_t count = 0;
+        for (size_t j = 0; j < s.cols; ++j)
+            count += !(std::fabs(a.at(i, j)) <= tolerance);
+        s.ptr[i + 1] = s.ptr[i] + count;
+    }
+    s.idx.resize(s.ptr[s.rows]);
+    s.val.resize(s.ptr[s.rows]);
+    for (size_t i = 0; i < s.rows; ++i)
+    {
+        size_t q = s.ptr[i];
+        for (size_t j = 0; j < s.cols; ++j)
+        {
+            double x = a.at(i, j);
+            if (!(std::fabs(x) <= tolerance))
+            {
+                s.idx[q] = (uint32_t)j;
+                s.val[q++] = x;
+            }
+        }
+    }
+    return s;
+}
+
+Matrix SparseMatrix::toDense() const
+{
+    Matrix result(rows, cols);
+    if (error != MATRIX_SUCCESS)
+        result.error = error;
+    if (result.error != MATRIX_SUCCESS)
+        return result;
+    // element (slice s, index j) of either form
+    size_t sliceStride = format == SPARSE_CSR ? cols : 1, indexStride = format == SPARSE_CSR ? 1 : cols;
+    for (size_t s = 0; s + 1 < ptr.size(); ++s)
+        for (size_t p = ptr[s]; p < ptr[s + 1]; ++p)
+            result.data[s * sliceStride + idx[p] * indexStride] = val[p];
+    return result;
+}
+
+SparseMatrix SparseMatrix::convert(SparseFormat f) const
+{
+    if (f == format || error != MATRIX_SUCCESS)
+        return *this;
+    SparseMatrix t(rows, cols, f);
+    t.idx.resize(idx.size());
+    t.val.resize(val.size());
+    size_t n = ptr.size() - 1, m = t.ptr.size() - 1;
+    transposeCompressed(n, m, ptr.data(), idx.data(), val.data(), t.ptr.data(), t.idx.data(), t.val.data());
+    return t;
+}
+
+SparseMatrix SparseMatrix::transpose() const
+{
+    // the rows of A are the columns of A^T
+    SparseMatrix t = *this;
+    std::swap(t.rows, t.cols);
+    t.format = format == SPARSE_CSR ? SPARSE_CSC : SPARSE_CSR;
+    return t;
+}
+
+size_t SparseMatrix::numRows() const
 {
     return rows;
 }
 
-size_t Matrix::numCols() const
+size_t SparseMatrix::numCols() const
 {
     return cols;
 }
 
-MatrixError Matrix::getError() const
+size_t SparseMatrix::nonZeros() const
+{
+    return val.size();
+}
+
+SparseFormat SparseMatrix::getFormat() const
+{
+    return format;
+}
+
+MatrixError SparseMatrix::getError() const
 {
     return error;
 }
 
-void Matrix::clearError()
+const std::vector<size_t> &SparseMatrix::offsets() const
 {
-    error = MATRIX_SUCCESS;
+    return ptr;
 }
 
-Matrix Matrix::scalarMultiply(double scalar) const
+const std::vector<uint32_t> &SparseMatrix::indices() const
 {
-    Matrix result(rows, cols);
-    for (size_t i = 0; i < rows * cols; ++i)
-        result.data[i] = data[i] * scalar;
-    return result;
+    return idx;
 }
 
-Matrix Matrix::operator*(double scalar) const
+const std::vector<double> &SparseMatrix::values() const
 {
-    return scalarMultiply(scalar);
+    return val;
 }
 
-Matrix operator*(double scalar, const Matrix &mat)
+double SparseMatrix::coeff(size_t row, size_t col) const
 {
-    return mat.scalarMultiply(scalar);
+    size_t s = format == SPARSE_CSR ? row : col, j = format == SPARSE_CSR ? col : row;
+    const uint32_t *first = idx.data() + ptr[s], *last = idx.data() + ptr[s + 1];
+    const uint32_t *p = std::lower_bound(first, last, (uint32_t)j);
+    return p != last && *p == j ? val[p - idx.data()] : 0.0;
 }
 
-Matrix Matrix::resize(size_t newRows, size_t newCols) const
+MatrixError SparseMatrix::multiplyInto(ConstMatrixView x, MatrixView y, unsigned threads) const
 {
-    Matrix result(newRows, newCols);
-    for (size_t i = 0; i < std::min(rows, newRows); ++i)
-        for (size_t j = 0; j < std::min(cols, newCols); ++j)
-            result.at(i, j) = at(i, j);
+    if (error != MATRIX_SUCCESS)
+        return error;
+    size_t k = x.numCols();
+    if (x.numRows() != cols || y.numRows() != rows || y.numCols() != k)
+        return MATRIX_ERR_DIM_MISMATCH;
+
+    if (format == SPARSE_CSC)
+    {
+        // Y = 0, then column c of A times row c of X scattered into Y
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < k; ++j)
+                y.at(i, j) = 0.0;
+        for (size_t c = 0; c < cols; ++c)
+            for (size_t p = ptr[c]; p < ptr[c + 1]; ++p)
+            {
+                double a = val[p];
+                for (size_t j = 0; j < k; ++j)
+                    y.at(idx[p], j) += a * x.at(c, j);
+            }
+        return MATRIX_SUCCESS;
+    }
+
+    // the kernels walk rows of X and Y; other layouts go through a copy
+    if (k > 1 && x.colStride() != 1)
+    {
+        Matrix copy = x;
+        if (copy.error != MATRIX_SUCCESS)
+            return copy.error;
+        return multiplyInto(copy, y, threads);
+    }
+    if (k > 1 && y.colStride() != 1)
+    {
+        Matrix t(rows, k, MATRIX_UNINITIALIZED);
+        if (t.error != MATRIX_SUCCESS)
+            return t.error;
+        MatrixError e = multiplyInto(x, t, threads);
+        return e == MATRIX_SUCCESS ? y.assign(t, threads) : e;
+    }
+
+    // the vector gathers take signed 32-bit indices, so a CSR matrix with
+    // more than 2^31 columns does its one-column products in scalar code
+    static const SparseFunction fastest = bestSparse();
+    SparseFunction best = k == 1 && cols > (size_t)INT32_MAX + 1 ? sparseScalar : fastest;
+    const double *xd = x.data();
+    double *yd = y.data();
+    size_t ldx = x.rowStride(), ldy = y.rowStride(), nnz = val.size();
+    threads = resolveThreads(threads);
+    if (threads == 1 || nnz * k < PARALLEL_MIN_ELEMENTS)
+    {
+        best(0, rows, ptr.data(), idx.data(), val.data(), xd, ldx, k, yd, ldy);
+        return MATRIX_SUCCESS;
+    }
+    // row ranges of about equal entry counts, cut by binary search in the
+    // offsets; each row is summed the same way whichever range it is in
+    size_t chunks = std::min((size_t)4 * threads, nnz * k / (PARALLEL_MIN_ELEMENTS / 4));
+    auto cut = [&](size_t t) {
+        return t == chunks ? rows
+                           : (size_t)(std::lower_bound(ptr.begin(), ptr.begin() + rows, t * nnz / chunks) -
+                                      ptr.begin());
+    };
+    workerPool().run(chunks, threads, [&](size_t t) {
+        best(cut(t), cut(t + 1), ptr.data(), idx.data(), val.data(), xd, ldx, k, yd, ldy);
+    });
+    return MATRIX_SUCCESS;
+}
+
+Matrix SparseMatrix::multiply(ConstMatrixView x, unsigned threads) const
+{
+    Matrix result;
+    result.error = error != MATRIX_SUCCESS ? error : x.numRows() != cols ? MATRIX_ERR_DIM_MISMATCH : MATRIX_SUCCESS;
+    if (result.error != MATRIX_SUCCESS || !result.allocate(rows, x.numCols(), MATRIX_UNINITIALIZED))
+        return result;
+    multiplyInto(x, result, threads);
     return result;
 }
 
-void Matrix::swapRows(size_t row1, size_t row2)
+Matrix operator*(const SparseMatrix &a, ConstMatrixView x)
 {
-    if (row1 >= rows || row2 >= rows)
-        return;
-    for (size_t j = 0; j < cols; ++j)
-        std::swap(at(row1, j), at(row2, j));
+    return a.multiply(x);
 }
 
-void Matrix::scaleRow(size_t row, double scalar)
+SparseMatrixBuilder::SparseMatrixBuilder(size_t r, size_t c) : rows(r), cols(c), error(MATRIX_SUCCESS)
 {
-    if (row >= rows)
-        return;
-    for (size_t j = 0; j < cols; ++j)
-        at(row, j) *= scalar;
+    if (r > SPARSE_MAX_DIM || c > SPARSE_MAX_DIM)
+        error = MATRIX_ERR_INVALID;
 }
 
-void Matrix::addRows(size_t srcRow, size_t destRow, double scalar)
+void SparseMatrixBuilder::reserve(size_t entries)
 {
-    if (srcRow >= rows || destRow >= rows)
-        return;
-    for (size_t j = 0; j < cols; ++j)
-        at(destRow, j) += at(srcRow, j) * scalar;
+    rowIndex.reserve(entries);
+    colIndex.reserve(entries);
+    value.reserve(entries);
 }
 
-void Matrix::swapCols(size_t col1, size_t col2)
+void SparseMatrixBuilder::add(size_t row, size_t col, double v)
 {
-    if (col1 >= cols || col2 >= cols)
+    if (row >= rows || col >= cols)
+    {
+        error = MATRIX_ERR_INVALID;
         return;
-    for (size_t i = 0; i < rows; ++i)
-        std::swap(at(i, col1), at(i, col2));
+    }
+    rowIndex.push_back((uint32_t)row);
+    colIndex.push_back((uint32_t)col);
+    value.push_back(v);
 }
 
-void Matrix::scaleCol(size_t col, double scalar)
+size_t SparseMatrixBuilder::size() const
 {
-    if (col >= cols)
-        return;
-    for (size_t i = 0; i < rows; ++i)
-        at(i, col) *= scalar;
+    return value.size();
 }
 
-void Matrix::addCols(size_t srcCol, size_t destCol, double scalar)
+void SparseMatrixBuilder::clear()
 {
-    if (srcCol >= cols || destCol >= cols)
-        return;
-    for (size_t i = 0; i < rows; ++i)
-        at(i, destCol) += at(i, srcCol) * scalar;
+    rowIndex.clear();
+    colIndex.clear();
+    value.clear();
+    error = rows > SPARSE_MAX_DIM || cols > SPARSE_MAX_DIM ? MATRIX_ERR_INVALID : MATRIX_SUCCESS;
 }
 
-Matrix Matrix::cofactor() const
+SparseMatrix SparseMatrixBuilder::build(SparseFormat format) const
 {
-    if (rows != cols)
+    if (error != MATRIX_SUCCESS)
     {
-        Matrix result;
-        result.error = MATRIX_ERR_INVALID;
+        SparseMatrix result;
+        result.error = error;
         return result;
     }
-    Matrix result(rows, cols);
-    for (size_t i = 0; i < rows; ++i)
+    SparseMatrix s(rows, cols, format);
+    const std::vector<uint32_t> &major = format == SPARSE_CSR ? rowIndex : colIndex;
+    const std::vector<uint32_t> &minor = format == SPARSE_CSR ? colIndex : rowIndex;
+    size_t n = s.ptr.size() - 1, m = (format == SPARSE_CSR ? cols : rows), nnz = value.size();
+
+    // bucket the triplets by minor index, then transpose the buckets into
+    // slices: both sorts are stable, so each slice comes out in increasing
+    // index order with repeated positions adjacent
+    std::vector<size_t> bptr(m + 1, 0);
+    std::vector<uint32_t> bidx(nnz);
+    std::vector<double> bval(nnz);
+    for (size_t q = 0; q < nnz; ++q)
+        ++bptr[minor[q] + 1];
+    prefixBuckets(bptr.data(), m);
+    for (size_t q = 0; q < nnz; ++q)
     {
-        for (size_t j = 0; j < cols; ++j)
+        size_t d = bptr[minor[q]]++;
+        bidx[d] = major[q];
+        bval[d] = value[q];
+    }
+    unshiftBuckets(bptr.data(), m);
+    s.idx.resize(nnz);
+    s.val.resize(nnz);
+    transposeCompressed(m, n, bptr.data(), bidx.data(), bval.data(), s.ptr.data(), s.idx.data(), s.val.data());
+
+    // sum the repeats in place
+    size_t w = 0, p = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t end = s.ptr[i + 1], first = w;
+        s.ptr[i] = w;
+        for (; p < end; ++p)
         {
-            Matrix sub(rows - 1, cols - 1);
-            for (size_t r = 0, sr = 0; r < rows; ++r)
+            if (w > first && s.idx[w - 1] == s.idx[p])
+                s.val[w - 1] += s.val[p];
+            else
             {
-                if (r == i)
-                    continue;
-                for (size_t c = 0, sc = 0; c < cols; ++c)
-                {
-                    if (c == j)
-                        continue;
-                    sub.at(sr, sc++) = at(r, c);
-                }
-                sr++;
+                s.idx[w] = s.idx[p];
+                s.val[w++] = s.val[p];
             }
-            result.at(i, j) = std::pow(-1, i + j) * sub.determinant();
         }
     }
-    return result;
+    s.ptr[n] = w;
+    if (w < nnz)
+    {
+        s.idx.resize(w);
+        s.val.resize(w);
+        s.idx.shrink_to_fit();
+        s.val.shrink_to_fit();
+    }
+    return s;
 }
 
-double Matrix::determinant() const
+// ---- Mapped files ----
+
+MappedMatrix::MappedMatrix()
+    : map(nullptr), length(0), elements(nullptr), rows(0), cols(0), checksum(0), summed(false),
+      error(MATRIX_SUCCESS)
 {
-    if (rows != cols)
-        return 0.0;
-    if (rows == 1)
-        return at(0, 0);
-    if (rows == 2)
-        return at(0, 0) * at(1, 1) - at(0, 1) * at(1, 0);
+}
 
-    double det = 0.0;
-    for (size_t j = 0; j < cols; ++j)
+MappedMatrix::MappedMatrix(const char *filename, bool verify) : MappedMatrix()
+{
+    open(filename, verify);
+}
+
+MappedMatrix::MappedMatrix(MappedMatrix &&other) noexcept : MappedMatrix()
+{
+    *this = std::move(other);
+}
+
+MappedMatrix &MappedMatrix::operator=(MappedMatrix &&other) noexcept
+{
+    if (this != &other)
     {
-        Matrix sub(rows - 1, cols - 1);
-        for (size_t r = 1; r < rows; ++r)
-            for (size_t c = 0, sc = 0; c < cols; ++c)
-                if (c != j)
-                    sub.at(r - 1, sc++) = at(r, c);
-        det += std::pow(-1, j) * at(0, j) * sub.determinant();
+        close();
+        map = other.map;
+        length = other.length;
+        elements = other.elements;
+        rows = other.rows;
+        cols = other.cols;
+        checksum = other.checksum;
+        summed = other.summed;
+        copy = std::move(other.copy);
+        error = other.error;
+        other.map = nullptr;
+        other.close();
     }
-    return det;
+    return *this;
 }
 
-Matrix Matrix::adjoint() const
+MappedMatrix::~MappedMatrix()
 {
-    return cofactor().transpose();
+    close();
 }
 
-Matrix Matrix::inverse() const
+MatrixError MappedMatrix::open(const char *filename, bool verifyNow)
 {
-    double det = determinant();
-    if (det == 0.0)
+    close();
+#if defined(MAT_HAVE_MMAP) && !defined(MAT_BIG_ENDIAN)
+    int fd = ::open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
     {
-        Matrix result;
-        result.error = MATRIX_ERR_INVALID;
-        return result;
+        if (fd >= 0)
+            ::close(fd);
+        return error = MATRIX_ERR_IO;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    if (size < BINARY_LEGACY_HEADER || size > SIZE_MAX)
+    {
+        ::close(fd);
+        return error = MATRIX_ERR_IO;
     }
-    return adjoint().scalarMultiply(1.0 / det);
+    // the mapping outlives the descriptor
+    void *p = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return error = MATRIX_ERR_IO;
+    BinaryLayout layout;
+    MatrixError e = parseBinaryHeader(static_cast<const unsigned char *>(p),
+                                      (size_t)std::min(size, (uint64_t)BINARY_HEADER), size, layout);
+    if (e != MATRIX_SUCCESS)
+    {
+        munmap(p, (size_t)size);
+        return error = e;
+    }
+    map = p;
+    length = (size_t)size;
+    elements = reinterpret_cast<const double *>(static_cast<const char *>(p) + layout.offset);
+    rows = layout.rows;
+    cols = layout.cols;
+    checksum = layout.checksum;
+    summed = layout.summed;
+#else
+    // read (and checksum) the whole file instead
+    copy = Matrix::loadFromBinary(filename);
+    if (copy.getError() != MATRIX_SUCCESS)
+    {
+        error = copy.getError();
+        copy = Matrix();
+        return error;
+    }
+    rows = copy.numRows();
+    cols = copy.numCols();
+    elements = ConstMatrixView(copy).data();
+#endif
+    if (verifyNow)
+    {
+        MatrixError check = verify();
+        if (check != MATRIX_SUCCESS)
+        {
+            close();
+            error = check;
+        }
+    }
+    return error;
+}
+
+void MappedMatrix::close()
+{
+#ifdef MAT_HAVE_MMAP
+    if (map)
+        munmap(map, length);
+#endif
+    map = nullptr;
+    length = 0;
+    elements = nullptr;
+    rows = cols = 0;
+    checksum = 0;
+    summed = false;
+    copy = Matrix();
+    error = MATRIX_SUCCESS;
+}
+
+MatrixError MappedMatrix::verify() const
+{
+    if (error != MATRIX_SUCCESS || !summed)
+        return error;
+    return checksumWords(elements, rows * cols) == checksum ? MATRIX_SUCCESS : MATRIX_ERR_IO;
+}
+
+size_t MappedMatrix::numRows() const
+{
+    return rows;
+}
+
+size_t MappedMatrix::numCols() const
+{
+    return cols;
+}
+
+MatrixError MappedMatrix::getError() const
+{
+    return error;
+}
+
+ConstMatrixView MappedMatrix::view() const
+{
+    return ConstMatrixView(elements, rows, cols, cols);
 }
@@ -3,7 +3,11 @@
 
 #include <iostream>
 #include <cstdio>
+#include <cstdint>
 #include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 enum MatrixError
 {
@@ -11,33 +15,169 @@ enum MatrixError
     MATRIX_ERR_ALLOC,
     MATRIX_ERR_DIM_MISMATCH,
     MATRIX_ERR_IO,
-    MATRIX_ERR_INVALID
+    MATRIX_ERR_INVALID,
+    MATRIX_ERR_PARSE
 };
 
-class Matrix
+enum MatrixInit
 {
+    MATRIX_ZERO = 0,
+    MATRIX_UNINITIALIZED
+};
+
+// Storage for Matrix elements, in blocks aligned to MATRIX_ALIGNMENT bytes
+// (a cache line, and a full AVX-512 vector). A matrix gives its block back
+// to the allocator it came from, so the current allocator can be switched
+// at any time, but an allocator must outlive the matrices it served.
+#define MATRIX_ALIGNMENT 64
+
+class MatrixAllocator
+{
+public:
+    virtual ~MatrixAllocator() {}
+    // count doubles, aligned and uninitialized; nullptr on failure
+    virtual double *allocate(size_t count) = 0;
+    virtual void release(double *p, size_t count) = 0;
+};
+
+// aligned blocks straight from the heap (the default)
+class MatrixHeapAllocator : public MatrixAllocator
+{
+public:
+    double *allocate(size_t count) override;
+    void release(double *p, size_t count) override;
+};
+
+// Keeps released blocks on free lists by power-of-two size class and hands
+// them out again, so a loop that creates and drops matrices of the same
+// sizes stops reaching the heap after its first pass. Thread-safe; blocks
+// beyond maxCachedBytes go back to the heap.
+class MatrixBufferPool : public MatrixAllocator
+{
+private:
+    std::mutex lock;
+    std::vector<double *> freeLists[64];
+    size_t cached;
+    size_t limit;
+    size_t hitCount;
+
+public:
+    explicit MatrixBufferPool(size_t maxCachedBytes = (size_t)256 << 20);
+    ~MatrixBufferPool();
+
+    double *allocate(size_t count) override;
+    void release(double *p, size_t count) override;
+
+    void trim(); // return every cached block to the heap
+    size_t cachedBytes();
+    size_t hits(); // allocations served from a free list
+};
+
+// Process-wide counts of Matrix storage taken and returned, through any
+// allocator; a loop is allocation-free if allocations does not move.
+struct MatrixAllocStats
+{
+    size_t allocations;
+    size_t releases;
+    size_t bytesAllocated; // total over all allocations
+    size_t bytesInUse;
+    size_t peakBytesInUse;
+};
+
+class Matrix;
+
+// Lazy element-wise expressions. +, - and scalar * on matrices and views
+// build a tree of these instead of temporaries; constructing or assigning
+// a Matrix (or a MatrixView) from one evaluates the whole tree in a single
+// pass with no intermediate storage. Every node has numRows(), numCols(),
+// conformable() (operand shapes agree), coeff(r, c) and aliases(dst) (it
+// reads the storage of dst other than element for element). Matrix operands
+// are held by reference, so an expression must not outlive the matrices in
+// it: auto s = a + b holds the expression, not its value (write Matrix s or
+// (a + b).eval()).
+template <class E>
+struct MatrixExpr
+{
+    const E &self() const { return static_cast<const E &>(*this); }
+};
+
+// how a node holds an operand: matrices by reference, nodes by value
+template <class E>
+struct MatrixOperand
+{
+    typedef E type;
+};
+
+template <>
+struct MatrixOperand<Matrix>
+{
+    typedef const Matrix &type;
+};
+
+class ConstMatrixView;
+class MatrixView;
+
+// where text input was malformed (MATRIX_ERR_PARSE)
+struct MatrixParseError
+{
+    size_t line;        // 1-based
+    size_t column;      // 1-based, in bytes
+    const char *reason; // a static string
+};
+
+class Matrix : public MatrixExpr<Matrix>
+{
+    friend class MatrixView;
+    friend class LUDecomposition;
+    friend class CholeskyDecomposition;
+    friend class QRDecomposition;
+    friend class SparseMatrix;
+    friend Matrix multiply(ConstMatrixView a, ConstMatrixView b, unsigned threads);
+    friend Matrix solve(ConstMatrixView a, ConstMatrixView b);
+    friend Matrix leastSquares(ConstMatrixView a, ConstMatrixView b);
+
 private:
     size_t rows;
     size_t cols;
     double *data;
     MatrixError error;
+    MatrixAllocator *allocator; // the one data came from
 
-    void allocate(size_t r, size_t c);
+    bool allocate(size_t r, size_t c, MatrixInit init);
     void deallocate();
     void copyFrom(const Matrix &other);
     void moveFrom(Matrix &other);
 
+    template <class E>
+    void assign(const E &expr, unsigned threads);
+    // the text format from stream; exact stops at the end of the line with
+    // the last value instead of reading ahead
+    static Matrix readText(FILE *stream, bool exact, MatrixParseError *where);
+    // r x c without zero-filling, keeping the buffer when the element count
+    // is unchanged; false (and MATRIX_ERR_ALLOC) if it cannot be allocated
+    bool prepare(size_t r, size_t c);
+    // kernel(context, begin, end) over chunks of [0, n) across threads
+    static void parallelFor(size_t n, unsigned threads, void (*kernel)(const void *, size_t, size_t),
+                            const void *context);
+
 public:
     // Constructors and Destructor
     Matrix();
-    Matrix(size_t rows, size_t cols);
+    Matrix(size_t rows, size_t cols, MatrixInit init = MATRIX_ZERO);
     Matrix(const Matrix &other);
     Matrix(Matrix &&other) noexcept;
+    template <class E>
+    Matrix(const MatrixExpr<E> &expr);
     ~Matrix();
 
-    // Assignment Operators
+    // Assignment Operators (an expression of the same size is evaluated
+    // into the existing storage, even when it reads this matrix; one that
+    // reads it through a view of another shape or layout is evaluated into
+    // new storage, and the old is released after)
     Matrix &operator=(const Matrix &other);
     Matrix &operator=(Matrix &&other) noexcept;
+    template <class E>
+    Matrix &operator=(const MatrixExpr<E> &expr);
 
     // Element Access
     double &at(size_t row, size_t col);
@@ -50,28 +190,56 @@ public:
     const char *getErrorMessage() const;
     void clearError();
 
+    // Expression Protocol
+    bool conformable() const { return true; }
+    double coeff(size_t r, size_t c) const { return data[r * cols + c]; }
+    bool aliases(const ConstMatrixView &dst) const;
+
+    // Views: no copy, valid while the matrix keeps its storage. A block
+    // must lie inside the matrix.
+    MatrixView view();
+    ConstMatrixView view() const;
+    MatrixView block(size_t row, size_t col, size_t numRows, size_t numCols);
+    ConstMatrixView block(size_t row, size_t col, size_t numRows, size_t numCols) const;
+
     // Comparison
     bool operator==(const Matrix &other) const;
 
-    // Arithmetic Operators
-    Matrix operator+(const Matrix &other) const;
-    Matrix operator-(const Matrix &other) const;
+    // Arithmetic Operators (+, - and scalar * are lazy expressions, below)
     Matrix operator*(const Matrix &other) const;
-    Matrix operator*(double scalar) const;
 
     // Friend Operator
-    friend Matrix operator*(double scalar, const Matrix &mat);
     friend std::ostream &operator<<(std::ostream &out, const Matrix &mat);
 
-    // Functional Alternatives
-    Matrix add(const Matrix &other) const;
-    Matrix subtract(const Matrix &other) const;
-    Matrix multiply(const Matrix &other) const;
-    Matrix scalarMultiply(double scalar) const;
+    // Functional Alternatives (threads: 0 uses the setThreads value)
+    Matrix add(const Matrix &other, unsigned threads = 0) const;
+    Matrix subtract(const Matrix &other, unsigned threads = 0) const;
+    Matrix multiply(const Matrix &other, unsigned threads = 0) const;
+    Matrix scalarMultiply(double scalar, unsigned threads = 0) const;
+
+    // Parallel Execution: threads used by the arithmetic above and the
+    // operators; 0 (the default) means one per hardware thread. Small
+    // operands stay on the calling thread, and results are the same bits
+    // for any thread count. Below the Strassen cutover, multiply gives the
+    // bits of the triple loop (products rounded, then summed in k order) on
+    // every CPU.
+    static void setThreads(unsigned threads);
+    static unsigned getThreads();
+
+    // Storage: new matrices take their elements from the current allocator;
+    // nullptr restores the aligned heap default
+    static void setAllocator(MatrixAllocator *allocator);
+    static MatrixAllocator *getAllocator();
+    static MatrixAllocStats getAllocStats();
+    static void resetAllocStats(); // zero the counters; peak restarts at bytesInUse
 
     // Matrix Manipulation
     Matrix resize(size_t newRows, size_t newCols) const;
     Matrix transpose() const;
+    // square matrices swap mirrored tiles in place; other shapes follow
+    // the permutation's cycles with a bitmap of rows * cols bits, which is
+    // slower than transpose() but needs no second copy of the elements
+    void transposeInPlace();
     Matrix cofactor() const;
     Matrix adjoint() const;
     Matrix inverse() const;
@@ -86,20 +254,698 @@ public:
     void scaleCol(size_t col, double scalar);
     void addCols(size_t srcCol, size_t destCol, double scalar);
 
-    // Strassen multiplication interfaces
+    // Strassen multiplication interfaces: seven half-size products per
+    // level until the smallest dimension reaches the cutover, then the
+    // blocked kernel. multiplyStrassen pads each dimension to a multiple of
+    // 2^levels, multiplyStrassenRecursive peels odd edges instead, and
+    // multiplyStrassenPowerOf2 takes square 2^k operands only. The error is
+    // bounded normwise, not per element, and grows with the level count.
     Matrix multiplyStrassen(const Matrix &other) const;
     Matrix multiplyStrassenRecursive(const Matrix &other) const;
     Matrix multiplyStrassenPowerOf2(const Matrix &other) const;
+    static void setStrassenCutover(size_t n);
+    static size_t getStrassenCutover();
 
-    // File I/O
+    // File I/O. The binary format is a 64-byte little-endian header (magic,
+    // version, element type, shape, payload offset and checksums) followed by
+    // the row-major doubles, 64-byte aligned so MappedMatrix can use them in
+    // place. loadFromBinary checks the header and the payload checksum
+    // (MATRIX_ERR_INVALID or MATRIX_ERR_IO), and still reads the headerless
+    // files of earlier versions.
+    // The text format is "rows cols" and then the values, separated by any
+    // mix of whitespace, commas and semicolons; saveToText writes a row per
+    // line in the shortest form that reads back to the same double. Text is
+    // read in large chunks and parsed on the worker threads, and the value
+    // count must match rows * cols: anything else, or a value that does not
+    // parse, is MATRIX_ERR_PARSE, located in *where when given.
     bool saveToText(const char *filename) const;
     bool saveToBinary(const char *filename) const;
-    static Matrix loadFromText(const char *filename);
+    static Matrix loadFromText(const char *filename, MatrixParseError *where = nullptr);
     static Matrix loadFromBinary(const char *filename);
 
-    // Stream I/O
+    // Stream I/O (read takes the text format and consumes the stream up to
+    // the end of the line holding the last value)
     void print(FILE *stream = stdout) const;
-    static Matrix read(FILE *stream);
+    static Matrix read(FILE *stream, MatrixParseError *where = nullptr);
+};
+
+// ---- views ----
+
+// A read-only window on matrix storage: element (r, c) is at
+// data()[r * rowStride() + c * colStride()]. Views are small values that
+// copy freely; submatrices, transposes and single rows or columns are
+// views of the same storage, made in O(1). The arithmetic, the products
+// and the factorizations take views wherever they take matrices.
+class ConstMatrixView : public MatrixExpr<ConstMatrixView>
+{
+protected:
+    double *base;
+    size_t rows;
+    size_t cols;
+    size_t rstride;
+    size_t cstride;
+
+public:
+    ConstMatrixView(const Matrix &m);
+    ConstMatrixView(const double *data, size_t rows, size_t cols, size_t rowStride, size_t colStride = 1)
+        : base(const_cast<double *>(data)), rows(rows), cols(cols), rstride(rowStride), cstride(colStride)
+    {
+    }
+
+    size_t numRows() const { return rows; }
+    size_t numCols() const { return cols; }
+    size_t rowStride() const { return rstride; }
+    size_t colStride() const { return cstride; }
+    const double *data() const { return base; }
+    const double &at(size_t r, size_t c) const { return base[r * rstride + c * cstride]; }
+
+    bool conformable() const { return true; }
+    double coeff(size_t r, size_t c) const { return base[r * rstride + c * cstride]; }
+    // the storage overlaps that of dst, and not as the same window
+    bool aliases(const ConstMatrixView &dst) const
+    {
+        if (!rows || !cols || !dst.rows || !dst.cols)
+            return false;
+        if (base == dst.base && rows == dst.rows && cols == dst.cols && rstride == dst.rstride &&
+            cstride == dst.cstride)
+            return false;
+        return base < dst.end() && dst.base < end();
+    }
+
+    ConstMatrixView block(size_t row, size_t col, size_t numRows, size_t numCols) const
+    {
+        return ConstMatrixView(&at(row, col), numRows, numCols, rstride, cstride);
+    }
+    ConstMatrixView transposed() const { return ConstMatrixView(base, cols, rows, cstride, rstride); }
+
+protected:
+    // one past the last element, for a view that is not empty
+    const double *end() const { return base + (rows - 1) * rstride + (cols - 1) * cstride + 1; }
+
+public:
+    ConstMatrixView row(size_t r) const { return block(r, 0, 1, cols); }
+    ConstMatrixView col(size_t c) const { return block(0, c, rows, 1); }
+};
+
+// A writable window. Assigning a view or an expression to it writes the
+// elements into the window (it never rebinds); the shapes must agree, and
+// operator= writes nothing when they do not (assign reports that). An
+// expression that reads the window's storage other than element for
+// element (a shifted block, a transpose) is evaluated into a temporary
+// first.
+class MatrixView : public ConstMatrixView
+{
+public:
+    MatrixView(Matrix &m);
+    MatrixView(double *data, size_t rows, size_t cols, size_t rowStride, size_t colStride = 1)
+        : ConstMatrixView(data, rows, cols, rowStride, colStride)
+    {
+    }
+    MatrixView(const MatrixView &other) = default;
+
+    double *data() const { return base; }
+    double &at(size_t r, size_t c) const { return base[r * rstride + c * cstride]; }
+
+    MatrixView block(size_t row, size_t col, size_t numRows, size_t numCols) const
+    {
+        return MatrixView(&at(row, col), numRows, numCols, rstride, cstride);
+    }
+    MatrixView transposed() const { return MatrixView(base, cols, rows, cstride, rstride); }
+    MatrixView row(size_t r) const { return block(r, 0, 1, cols); }
+    MatrixView col(size_t c) const { return block(0, c, rows, 1); }
+
+    template <class E>
+    MatrixError assign(const MatrixExpr<E> &expr, unsigned threads = 0) const;
+    template <class E>
+    const MatrixView &operator=(const MatrixExpr<E> &expr) const
+    {
+        assign(expr);
+        return *this;
+    }
+    const MatrixView &operator=(const MatrixView &other) const
+    {
+        assign(other);
+        return *this;
+    }
+};
+
+inline ConstMatrixView::ConstMatrixView(const Matrix &m)
+    : base(m.numRows() && m.numCols() ? const_cast<double *>(&m.at(0, 0)) : nullptr), rows(m.numRows()),
+      cols(m.numCols()), rstride(m.numCols()), cstride(1)
+{
+}
+
+inline MatrixView::MatrixView(Matrix &m) : ConstMatrixView(m) {}
+
+inline bool Matrix::aliases(const ConstMatrixView &dst) const
+{
+    return view().aliases(dst);
+}
+
+inline MatrixView Matrix::view()
+{
+    return MatrixView(*this);
+}
+
+inline ConstMatrixView Matrix::view() const
+{
+    return ConstMatrixView(*this);
+}
+
+inline MatrixView Matrix::block(size_t row, size_t col, size_t numRows, size_t numCols)
+{
+    return view().block(row, col, numRows, numCols);
+}
+
+inline ConstMatrixView Matrix::block(size_t row, size_t col, size_t numRows, size_t numCols) const
+{
+    return view().block(row, col, numRows, numCols);
+}
+
+// A (m x k) * B (k x n) through the blocked kernel, reading both operands
+// in place whatever their strides
+Matrix multiply(ConstMatrixView a, ConstMatrixView b, unsigned threads = 0);
+
+// ---- element-wise expressions ----
+
+struct MatrixAddOp
+{
+    static double apply(double x, double y) { return x + y; }
+};
+
+struct MatrixSubtractOp
+{
+    static double apply(double x, double y) { return x - y; }
+};
+
+// What a node offers of the Matrix interface by evaluating itself, so that
+// a + b still goes wherever a matrix or a view is read: getError(), eval(),
+// and conversion to ConstMatrixView (CholeskyDecomposition(a * 2.0),
+// solve(a + b, c)). The result is kept in the node, so a view of it is valid
+// to the end of the full expression for a temporary node; copies of a node
+// start unevaluated.
+template <class E>
+class MatrixLazyExpr : public MatrixExpr<E>
+{
+private:
+    mutable Matrix value;
+    mutable bool evaluated;
+
+    const Matrix &evaluate() const
+    {
+        if (!evaluated)
+        {
+            value = this->self();
+            evaluated = true;
+        }
+        return value;
+    }
+
+public:
+    MatrixLazyExpr() : evaluated(false) {}
+    MatrixLazyExpr(const MatrixLazyExpr &) : evaluated(false) {}
+
+    Matrix eval() const { return evaluated ? value : Matrix(this->self()); }
+    MatrixError getError() const { return evaluate().getError(); }
+    const char *getErrorMessage() const { return evaluate().getErrorMessage(); }
+    operator ConstMatrixView() const { return evaluate(); }
+};
+
+template <class L, class R, class Op>
+class MatrixBinary : public MatrixLazyExpr<MatrixBinary<L, R, Op> >
+{
+private:
+    typename MatrixOperand<L>::type lhs;
+    typename MatrixOperand<R>::type rhs;
+
+public:
+    MatrixBinary(const L &l, const R &r) : lhs(l), rhs(r) {}
+
+    size_t numRows() const { return lhs.numRows(); }
+    size_t numCols() const { return lhs.numCols(); }
+    bool conformable() const
+    {
+        return lhs.conformable() && rhs.conformable() && lhs.numRows() == rhs.numRows() &&
+               lhs.numCols() == rhs.numCols();
+    }
+    double coeff(size_t r, size_t c) const { return Op::apply(lhs.coeff(r, c), rhs.coeff(r, c)); }
+    bool aliases(const ConstMatrixView &dst) const { return lhs.aliases(dst) || rhs.aliases(dst); }
+};
+
+template <class E>
+class MatrixScaled : public MatrixLazyExpr<MatrixScaled<E> >
+{
+private:
+    typename MatrixOperand<E>::type operand;
+    double scalar;
+
+public:
+    MatrixScaled(const E &e, double s) : operand(e), scalar(s) {}
+
+    size_t numRows() const { return operand.numRows(); }
+    size_t numCols() const { return operand.numCols(); }
+    bool conformable() const { return operand.conformable(); }
+    double coeff(size_t r, size_t c) const { return operand.coeff(r, c) * scalar; }
+    bool aliases(const ConstMatrixView &dst) const { return operand.aliases(dst); }
+};
+
+template <class L, class R>
+MatrixBinary<L, R, MatrixAddOp> operator+(const MatrixExpr<L> &l, const MatrixExpr<R> &r)
+{
+    return MatrixBinary<L, R, MatrixAddOp>(l.self(), r.self());
+}
+
+template <class L, class R>
+MatrixBinary<L, R, MatrixSubtractOp> operator-(const MatrixExpr<L> &l, const MatrixExpr<R> &r)
+{
+    return MatrixBinary<L, R, MatrixSubtractOp>(l.self(), r.self());
+}
+
+template <class E>
+MatrixScaled<E> operator*(const MatrixExpr<E> &e, double scalar)
+{
+    return MatrixScaled<E>(e.self(), scalar);
+}
+
+template <class E>
+MatrixScaled<E> operator*(double scalar, const MatrixExpr<E> &e)
+{
+    return MatrixScaled<E>(e.self(), scalar);
+}
+
+// An rvalue operand lends its storage to the result: the expression is
+// evaluated into it in place and no new matrix is allocated.
+template <class R>
+Matrix operator+(Matrix &&l, const MatrixExpr<R> &r)
+{
+    l = l + r.self();
+    return std::move(l);
+}
+
+template <class L>
+Matrix operator+(const MatrixExpr<L> &l, Matrix &&r)
+{
+    r = l.self() + r;
+    return std::move(r);
+}
+
+inline Matrix operator+(Matrix &&l, Matrix &&r)
+{
+    l = l + r;
+    return std::move(l);
+}
+
+template <class R>
+Matrix operator-(Matrix &&l, const MatrixExpr<R> &r)
+{
+    l = l - r.self();
+    return std::move(l);
+}
+
+template <class L>
+Matrix operator-(const MatrixExpr<L> &l, Matrix &&r)
+{
+    r = l.self() - r;
+    return std::move(r);
+}
+
+inline Matrix operator-(Matrix &&l, Matrix &&r)
+{
+    l = l - r;
+    return std::move(l);
+}
+
+inline Matrix operator*(Matrix &&m, double scalar)
+{
+    m = m * scalar;
+    return std::move(m);
+}
+
+inline Matrix operator*(double scalar, Matrix &&m)
+{
+    m = m * scalar;
+    return std::move(m);
+}
+
+// an operand of a product: matrices and views are read in place, other
+// expressions are evaluated first
+template <class E>
+struct MatrixProductOperand
+{
+    Matrix value;
+    ConstMatrixView view;
+    MatrixProductOperand(const E &e) : value(e), view(value) {}
+};
+
+template <>
+struct MatrixProductOperand<Matrix>
+{
+    ConstMatrixView view;
+    MatrixProductOperand(const Matrix &m) : view(m) {}
+};
+
+template <>
+struct MatrixProductOperand<ConstMatrixView>
+{
+    ConstMatrixView view;
+    MatrixProductOperand(const ConstMatrixView &v) : view(v) {}
+};
+
+template <class L, class R>
+Matrix operator*(const MatrixExpr<L> &l, const MatrixExpr<R> &r)
+{
+    return multiply(MatrixProductOperand<L>(l.self()).view, MatrixProductOperand<R>(r.self()).view);
+}
+
+// evaluation of an expression into storage with the given strides, over a
+// range of its row-major element indices (a chunk of a parallel pass)
+template <class E>
+struct MatrixEvaluation
+{
+    const E *expr;
+    double *dst;
+    size_t rowStride;
+    size_t colStride;
+
+    static void run(const void *context, size_t begin, size_t end)
+    {
+        const MatrixEvaluation &ev = *static_cast<const MatrixEvaluation *>(context);
+        const E &e = *ev.expr;
+        size_t cols = e.numCols();
+        while (begin < end)
+        {
+            size_t r = begin / cols, c = begin % cols;
+            size_t stop = end - begin < cols - c ? c + (end - begin) : cols;
+            begin += stop - c;
+            double *row = ev.dst + r * ev.rowStride;
+            if (ev.colStride == 1)
+                for (; c < stop; ++c)
+                    row[c] = e.coeff(r, c);
+            else
+                for (; c < stop; ++c)
+                    row[c * ev.colStride] = e.coeff(r, c);
+        }
+    }
+};
+
+template <class E>
+void Matrix::assign(const E &expr, unsigned threads)
+{
+    if (!expr.conformable())
+    {
+        deallocate();
+        error = MATRIX_ERR_DIM_MISMATCH;
+        return;
+    }
+    if (data && expr.aliases(view()))
+    {
+        // prepare would reshape or free storage the expression still reads
+        Matrix fresh;
+        fresh.assign(expr, threads);
+        *this = std::move(fresh);
+        return;
+    }
+    if (prepare(expr.numRows(), expr.numCols()))
+    {
+        MatrixEvaluation<E> ev = {&expr, data, cols, 1};
+        parallelFor(rows * cols, threads, &MatrixEvaluation<E>::run, &ev);
+    }
+}
+
+template <class E>
+MatrixError MatrixView::assign(const MatrixExpr<E> &expr, unsigned threads) const
+{
+    const E &e = expr.self();
+    if (!e.conformable() || e.numRows() != rows || e.numCols() != cols)
+        return MATRIX_ERR_DIM_MISMATCH;
+    if (e.aliases(*this))
+    {
+        // writing the window would overwrite elements still to be read
+        Matrix copy(e);
+        if (copy.getError() != MATRIX_SUCCESS)
+            return copy.getError();
+        return assign(copy, threads);
+    }
+    MatrixEvaluation<E> ev = {&e, base, rstride, cstride};
+    Matrix::parallelFor(rows * cols, threads, &MatrixEvaluation<E>::run, &ev);
+    return MATRIX_SUCCESS;
+}
+
+template <class E>
+Matrix::Matrix(const MatrixExpr<E> &expr)
+    : rows(0), cols(0), data(nullptr), error(MATRIX_SUCCESS), allocator(nullptr)
+{
+    assign(expr.self(), 0);
+}
+
+template <class E>
+Matrix &Matrix::operator=(const MatrixExpr<E> &expr)
+{
+    assign(expr.self(), 0);
+    return *this;
+}
+
+// LU factorization with partial pivoting, P A = L U, of a square matrix.
+// L (unit lower triangular) and U are packed into one matrix; row i was
+// swapped with row pivotRows()[i] at step i. Factor once, then read the
+// determinant, inverse or rank off the factors in O(n^2) or O(n^3).
+class LUDecomposition
+{
+private:
+    Matrix lu;
+    std::vector<size_t> pivots;
+    MatrixError error;
+
+    MatrixError decompose();
+
+public:
+    LUDecomposition();
+    explicit LUDecomposition(ConstMatrixView a);
+
+    // refactor, reusing the storage when the size is unchanged, or taking
+    // over the storage of an rvalue
+    MatrixError factor(ConstMatrixView a);
+    MatrixError factor(Matrix &&a);
+
+    size_t size() const;
+    MatrixError getError() const;
+    const Matrix &packed() const;
+    const std::vector<size_t> &pivotRows() const;
+
+    bool isSingular() const; // some pivot is exactly zero
+    // pivots above n * eps * the largest one; partial pivoting is not
+    // rank-revealing, so this is an estimate for nearly dependent rows
+    size_t rank() const;
+    double determinant() const;
+    double logDeterminant(int &sign) const; // log |det A|; sign is -1, 0 or 1
+    Matrix inverse() const;
+
+    // X with A X = B, B n x k (one column per right-hand side): two
+    // triangular solves, O(n^2 k). solveInPlace overwrites B with X and
+    // allocates nothing, for repeated solves against the same A.
+    Matrix solve(ConstMatrixView b) const;
+    MatrixError solveInPlace(MatrixView b) const;
+};
+
+// X with A X = B through a one-off LU factorization of A
+Matrix solve(ConstMatrixView a, ConstMatrixView b);
+
+// A = L L^T for symmetric positive definite A, from its lower triangle
+// only; about half the flops of LU. The factor(Matrix &&) overload works in
+// the caller's storage, and a reused object keeps its workspace.
+class CholeskyDecomposition
+{
+private:
+    Matrix l;
+    std::vector<double> work;
+    MatrixError error;
+
+    MatrixError decompose();
+
+public:
+    CholeskyDecomposition();
+    explicit CholeskyDecomposition(ConstMatrixView a);
+
+    // MATRIX_ERR_INVALID unless A is square and numerically positive definite
+    MatrixError factor(ConstMatrixView a);
+    MatrixError factor(Matrix &&a);
+
+    size_t size() const;
+    MatrixError getError() const;
+    const Matrix &lower() const; // L, zero above the diagonal
+
+    double determinant() const;
+    double logDeterminant() const;
+
+    // X with A X = B, B n x k; more than four right-hand sides take a
+    // transient n^2 / 4 buffer, fewer allocate nothing
+    Matrix solve(ConstMatrixView b) const;
+    MatrixError solveInPlace(MatrixView b) const;
+};
+
+// A = Q R by blocked Householder reflections for m x n A with m >= n. The
+// packed form keeps R on and above the diagonal and the reflectors below
+// it; factor(Matrix &&) works in the caller's storage, and a reused object
+// keeps its workspace.
+class QRDecomposition
+{
+private:
+    Matrix qr;
+    std::vector<double> tau;
+    std::vector<double> blocks; // triangular factor of each panel's block reflector
+    std::vector<double> work;
+    MatrixError error;
+
+    MatrixError decompose();
+
+public:
+    QRDecomposition();
+    explicit QRDecomposition(ConstMatrixView a);
+
+    MatrixError factor(ConstMatrixView a); // MATRIX_ERR_INVALID for m < n
+    MatrixError factor(Matrix &&a);
+
+    size_t numRows() const;
+    size_t numCols() const;
+    MatrixError getError() const;
+    const Matrix &packed() const;
+
+    bool isRankDeficient() const; // some diagonal entry of R is exactly zero
+    Matrix r() const;             // n x n upper triangular
+    Matrix q() const;             // m x n with orthonormal columns
+
+    // least-squares X minimizing |A X - B|, B m x k. solveInPlace leaves X in
+    // the first n rows of B and Q^T times the residual in the other m - n,
+    // whose norm is the residual norm.
+    Matrix solve(ConstMatrixView b) const;
+    MatrixError solveInPlace(MatrixView b) const;
+};
+
+// least-squares X through a one-off QR factorization of A
+Matrix leastSquares(ConstMatrixView a, ConstMatrixView b);
+
+// ---- sparse ----
+
+enum SparseFormat
+{
+    SPARSE_CSR = 0, // compressed rows: the products split across threads by row
+    SPARSE_CSC      // compressed columns: cheap column access, A^T X by row
+};
+
+// A sparse matrix in compressed form: slice s (row s for CSR, column s for
+// CSC) holds the entries [offsets()[s], offsets()[s + 1]) of indices() and
+// values(), in increasing index order with no repeats. Memory and product
+// cost grow with the number of stored entries, not rows * cols. Row and
+// column counts are limited to 2^32 - 1 so that indices take four bytes;
+// past 2^31 columns, CSR times a single vector runs without SIMD gathers.
+class SparseMatrix
+{
+    friend class SparseMatrixBuilder;
+
+private:
+    size_t rows;
+    size_t cols;
+    SparseFormat format;
+    std::vector<size_t> ptr;
+    std::vector<uint32_t> idx;
+    std::vector<double> val;
+    MatrixError error;
+
+public:
+    SparseMatrix();
+    // all zero
+    SparseMatrix(size_t rows, size_t cols, SparseFormat format = SPARSE_CSR);
+
+    // the entries of A with magnitude above tolerance
+    static SparseMatrix fromDense(ConstMatrixView a, double tolerance = 0.0, SparseFormat format = SPARSE_CSR);
+    Matrix toDense() const;
+    SparseMatrix convert(SparseFormat format) const; // O(nnz + rows + cols)
+    SparseMatrix transpose() const;                  // the same arrays, read the other way
+
+    size_t numRows() const;
+    size_t numCols() const;
+    size_t nonZeros() const;
+    SparseFormat getFormat() const;
+    MatrixError getError() const;
+    const std::vector<size_t> &offsets() const;
+    const std::vector<uint32_t> &indices() const;
+    const std::vector<double> &values() const;
+    double coeff(size_t row, size_t col) const; // binary search in the slice
+
+    // Y = A X for dense X (cols x k; a vector is one column). CSR products
+    // split the rows across threads, balanced by entry count, and give the
+    // same bits for any thread count; CSC products run on the calling
+    // thread. multiplyInto writes an existing Y, which must not overlap X,
+    // and allocates nothing for CSR with X and Y of unit column stride.
+    Matrix multiply(ConstMatrixView x, unsigned threads = 0) const;
+    MatrixError multiplyInto(ConstMatrixView x, MatrixView y, unsigned threads = 0) const;
+};
+
+Matrix operator*(const SparseMatrix &a, ConstMatrixView x);
+
+// Collects (row, col, value) triplets in any order; build() sorts them into
+// compressed form in linear time and sums repeated positions. An entry out
+// of range makes the built matrix MATRIX_ERR_INVALID.
+class SparseMatrixBuilder
+{
+private:
+    size_t rows;
+    size_t cols;
+    std::vector<uint32_t> rowIndex;
+    std::vector<uint32_t> colIndex;
+    std::vector<double> value;
+    MatrixError error;
+
+public:
+    SparseMatrixBuilder(size_t rows, size_t cols);
+
+    void reserve(size_t entries);
+    void add(size_t row, size_t col, double value);
+    size_t size() const;
+    void clear(); // drop the entries, keeping the capacity
+
+    SparseMatrix build(SparseFormat format = SPARSE_CSR) const;
+};
+
+// ---- mapped files ----
+
+// A file written by Matrix::saveToBinary, mapped read-only and used in
+// place: opening costs the header, pages are read on first touch, and
+// every process mapping the same file shares them in the page cache. The
+// view is valid until the object is closed or destroyed. Without mmap (or
+// on big-endian hosts) the file is read into memory instead.
+class MappedMatrix
+{
+private:
+    void *map;
+    size_t length;
+    const double *elements;
+    size_t rows;
+    size_t cols;
+    uint64_t checksum;
+    bool summed; // the file carries a payload checksum
+    Matrix copy; // the elements when the file could not be mapped
+    MatrixError error;
+
+public:
+    MappedMatrix();
+    // verify: checksum the payload now, reading the whole file
+    explicit MappedMatrix(const char *filename, bool verify = false);
+    MappedMatrix(MappedMatrix &&other) noexcept;
+    MappedMatrix &operator=(MappedMatrix &&other) noexcept;
+    MappedMatrix(const MappedMatrix &) = delete;
+    MappedMatrix &operator=(const MappedMatrix &) = delete;
+    ~MappedMatrix();
+
+    MatrixError open(const char *filename, bool verify = false);
+    void close();
+    MatrixError verify() const; // MATRIX_ERR_IO if the payload does not match its checksum
+
+    size_t numRows() const;
+    size_t numCols() const;
+    MatrixError getError() const;
+    ConstMatrixView view() const;
+    operator ConstMatrixView() const { return view(); }
 };
 
 #endif // MATRIX_H_INCLUDED
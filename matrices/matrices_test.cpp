@@ -0,0 +1,592 @@
+// Regression tests of the matrices module. Each check prints the failing
+// expression; the exit status is the number of failures.
+//
+// Build:
+//   g++ -std=c++17 -O2 matrices/matrices_test.cpp matrices/matrices.cpp -pthread -o matrices_test
+
+#include "matrices.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                                             \
+    do                                                                                                          \
+    {                                                                                                           \
+        if (!(cond))                                                                                            \
+        {                                                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                            \
+            ++failures;                                                                                         \
+        }                                                                                                       \
+    } while (0)
+
+// r x c with distinct entries
+static Matrix numbered(size_t r, size_t c)
+{
+    Matrix m(r, c);
+    for (size_t i = 0; i < r; ++i)
+        for (size_t j = 0; j < c; ++j)
+            m.at(i, j) = (double)(i * c + j);
+    return m;
+}
+
+// r x c with entries in [-1, 1) from a fixed sequence
+static Matrix random(size_t r, size_t c, unsigned seed)
+{
+    Matrix m(r, c);
+    unsigned long long state = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    for (size_t i = 0; i < r; ++i)
+        for (size_t j = 0; j < c; ++j)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            m.at(i, j) = (double)(state >> 11) * 0x1p-52 - 1.0;
+        }
+    return m;
+}
+
+// A B by the textbook triple loop, summed in long double
+static Matrix naiveProduct(ConstMatrixView a, ConstMatrixView b)
+{
+    Matrix p(a.numRows(), b.numCols());
+    for (size_t i = 0; i < a.numRows(); ++i)
+        for (size_t j = 0; j < b.numCols(); ++j)
+        {
+            long double t = 0;
+            for (size_t k = 0; k < a.numCols(); ++k)
+                t += (long double)a.at(i, k) * b.at(k, j);
+            p.at(i, j) = (double)t;
+        }
+    return p;
+}
+
+// A B by the loop multiply used to be: result(i, j) += a(i, k) * b(k, j)
+// in k order, each product rounded before the add (volatile keeps the
+// compiler from fusing them)
+static Matrix loopProduct(ConstMatrixView a, ConstMatrixView b)
+{
+    Matrix p(a.numRows(), b.numCols());
+    for (size_t i = 0; i < a.numRows(); ++i)
+        for (size_t j = 0; j < b.numCols(); ++j)
+            for (size_t k = 0; k < a.numCols(); ++k)
+            {
+                volatile double t = a.at(i, k) * b.at(k, j);
+                p.at(i, j) += t;
+            }
+    return p;
+}
+
+static double maxDiff(ConstMatrixView a, ConstMatrixView b)
+{
+    if (a.numRows() != b.numRows() || a.numCols() != b.numCols())
+        return INFINITY;
+    double m = 0;
+    for (size_t i = 0; i < a.numRows(); ++i)
+        for (size_t j = 0; j < a.numCols(); ++j)
+            m = std::fmax(m, std::fabs(a.at(i, j) - b.at(i, j)));
+    return m;
+}
+
+static bool sameBits(const Matrix &a, const Matrix &b)
+{
+    return a.numRows() == b.numRows() && a.numCols() == b.numCols() &&
+           (a.numRows() * a.numCols() == 0 ||
+            std::memcmp(&a.at(0, 0), &b.at(0, 0), sizeof(double) * a.numRows() * a.numCols()) == 0);
+}
+
+// diagonally dominant, so far from singular
+static Matrix wellConditioned(size_t n, unsigned seed)
+{
+    Matrix a = random(n, n, seed);
+    for (size_t i = 0; i < n; ++i)
+        a.at(i, i) += (double)n;
+    return a;
+}
+
+// ---- operations against a naive reference ----
+
+// m x k times k x n below, at and across the kernel's block and tile edges;
+// entries in [-1, 1) keep each dot product's error under k * 2^-52
+static const size_t multiplyShapes[][3] = {{1, 1, 1},    {3, 5, 2},       {7, 13, 5},
+                                           {64, 64, 64}, {129, 67, 131}, {300, 257, 190}};
+
+static void testMultiply()
+{
+    for (const auto &s : multiplyShapes)
+    {
+        Matrix a = random(s[0], s[1], 1), b = random(s[1], s[2], 2);
+        CHECK(maxDiff(a * b, naiveProduct(a, b)) <= 4e-16 * s[1]);
+        // and bit for bit what the loop gave, on every kernel tier
+        CHECK(sameBits(a * b, loopProduct(a, b)));
+    }
+}
+
+// the thread count changes how the work is split, never the bits
+static void testThreads()
+{
+    for (const auto &s : multiplyShapes)
+    {
+        Matrix a = random(s[0], s[1], 1), b = random(s[1], s[2], 2);
+        CHECK(sameBits(a.multiply(b, 1), a.multiply(b, 4)));
+    }
+    // large enough to split the element-wise operations too
+    Matrix x = random(300, 400, 13), y = random(300, 400, 14);
+    CHECK(sameBits(x.add(y, 1), x.add(y, 4)) && sameBits(x.scalarMultiply(3.0, 1), x.scalarMultiply(3.0, 4)));
+}
+
+// Strassen is bounded normwise, a little looser than the kernel
+static void testStrassen()
+{
+    size_t cutover = Matrix::getStrassenCutover();
+    Matrix::setStrassenCutover(16);
+    Matrix p = random(128, 128, 6), q = random(128, 128, 7), odd = random(101, 77, 8), odd2 = random(77, 93, 9);
+    Matrix ref = naiveProduct(p, q);
+    CHECK(maxDiff(p.multiplyStrassen(q), ref) <= 1e-12);
+    CHECK(maxDiff(p.multiplyStrassenPowerOf2(q), ref) <= 1e-12);
+    CHECK(maxDiff(odd.multiplyStrassen(odd2), naiveProduct(odd, odd2)) <= 1e-12);
+    CHECK(maxDiff(odd.multiplyStrassenRecursive(odd2), naiveProduct(odd, odd2)) <= 1e-12);
+    Matrix::setStrassenCutover(cutover);
+}
+
+static void testLU()
+{
+    Matrix m(3, 3);
+    const double v[9] = {2, -1, 0, 4, 3, 1, -2, 5, 6};
+    for (size_t i = 0; i < 9; ++i)
+        m.at(i / 3, i % 3) = v[i];
+    // cofactor expansion along the first row
+    double det = 2 * (3 * 6 - 1 * 5) - -1 * (4 * 6 - 1 * -2) + 0;
+    CHECK(std::fabs(m.determinant() - det) <= 1e-12 * std::fabs(det));
+    CHECK(std::fabs(LUDecomposition(m).determinant() - det) <= 1e-12 * std::fabs(det));
+
+    for (size_t n : {5, 40, 150})
+    {
+        Matrix a = wellConditioned(n, 16);
+        Matrix inv = LUDecomposition(a).inverse();
+        Matrix eye(n, n);
+        for (size_t i = 0; i < n; ++i)
+            eye.at(i, i) = 1;
+        CHECK(maxDiff(naiveProduct(a, inv), eye) <= 1e-13 * n);
+    }
+    Matrix singular(4, 4);
+    CHECK(LUDecomposition(singular).isSingular());
+}
+
+static void testSolve()
+{
+    for (size_t n : {5, 40, 150})
+    {
+        Matrix a = wellConditioned(n, 16), b = random(n, 3, 17);
+        Matrix x = solve(a, b);
+        CHECK(x.getError() == MATRIX_SUCCESS && maxDiff(naiveProduct(a, x), b) <= 1e-13 * n);
+    }
+}
+
+static void testCholeskyQR()
+{
+    for (size_t n : {5, 40, 150})
+    {
+        // A A^T + n I is symmetric positive definite
+        Matrix a = wellConditioned(n, 16), b = random(n, 3, 17);
+        Matrix spd = naiveProduct(a, a.view().transposed());
+        for (size_t i = 0; i < n; ++i)
+            spd.at(i, i) += (double)n;
+        CholeskyDecomposition chol(spd);
+        CHECK(chol.getError() == MATRIX_SUCCESS);
+        CHECK(maxDiff(naiveProduct(spd, chol.solve(b)), b) <= 1e-12 * n * n);
+        CHECK(maxDiff(naiveProduct(chol.lower(), chol.lower().view().transposed()), spd) <= 1e-12 * n * n);
+
+        // least squares: the residual is orthogonal to the columns of A
+        Matrix tall = random(2 * n, n, 18), rhs = random(2 * n, 2, 19);
+        Matrix ls = leastSquares(tall, rhs);
+        Matrix residual = naiveProduct(tall, ls) - rhs;
+        Matrix normal = naiveProduct(tall.view().transposed(), residual);
+        CHECK(ls.getError() == MATRIX_SUCCESS && maxDiff(normal, Matrix(n, 2)) <= 1e-12 * n);
+    }
+    CHECK(CholeskyDecomposition(random(4, 4, 20)).getError() == MATRIX_ERR_INVALID);
+}
+
+static void testElementwise()
+{
+    Matrix a = random(37, 53, 10), b = random(37, 53, 11), c = random(37, 53, 12);
+    Matrix sum = a.add(b), diff = a.subtract(b), scaled = a.scalarMultiply(-2.5);
+    Matrix chain = a + b * 2.0 - c;
+    bool ok = true;
+    for (size_t i = 0; i < 37; ++i)
+        for (size_t j = 0; j < 53; ++j)
+            ok = ok && sum.at(i, j) == a.at(i, j) + b.at(i, j) && diff.at(i, j) == a.at(i, j) - b.at(i, j) &&
+                 scaled.at(i, j) == a.at(i, j) * -2.5 && chain.at(i, j) == (a.at(i, j) + b.at(i, j) * 2.0) - c.at(i, j);
+    CHECK(ok);
+    CHECK(a.add(c).getError() == MATRIX_SUCCESS && a.add(Matrix(53, 37)).getError() == MATRIX_ERR_DIM_MISMATCH);
+}
+
+// operands read in place through strides
+static void testViews()
+{
+    for (const auto &s : multiplyShapes)
+    {
+        Matrix a = random(s[0], s[1], 1), b = random(s[1], s[2], 2);
+        CHECK(maxDiff(multiply(a.view().transposed().transposed(), b), naiveProduct(a, b)) <= 4e-16 * s[1]);
+    }
+    Matrix a = random(90, 70, 3), b = random(90, 50, 4);
+    CHECK(maxDiff(multiply(a.view().transposed(), b), naiveProduct(a.transpose(), b)) <= 4e-16 * 90);
+    Matrix big = random(100, 100, 5);
+    CHECK(maxDiff(multiply(big.block(3, 7, 40, 30), big.block(50, 11, 30, 45)),
+                  naiveProduct(big.block(3, 7, 40, 30), big.block(50, 11, 30, 45))) <= 4e-16 * 30);
+}
+
+static void testTranspose()
+{
+    const size_t shapes[][2] = {{1, 1}, {1, 9}, {37, 61}, {64, 64}, {128, 128}, {250, 130}};
+    for (const auto &s : shapes)
+    {
+        Matrix a = random(s[0], s[1], 15);
+        Matrix t = a.transpose();
+        CHECK(maxDiff(t, a.view().transposed()) == 0);
+        Matrix inPlace = a;
+        inPlace.transposeInPlace();
+        CHECK(sameBits(inPlace, t));
+    }
+}
+
+static void testSparse()
+{
+    const size_t rows = 200, cols = 170;
+    SparseMatrixBuilder builder(rows, cols);
+    Matrix dense(rows, cols);
+    unsigned long long state = 21;
+    for (int e = 0; e < 3000; ++e)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t r = (size_t)(state >> 33) % rows, c = (size_t)(state >> 13) % cols;
+        double v = (double)((state >> 40) % 1000) / 500.0 - 1.0;
+        builder.add(r, c, v); // repeated positions are summed
+        dense.at(r, c) += v;
+    }
+    SparseMatrix csr = builder.build(SPARSE_CSR), csc = builder.build(SPARSE_CSC);
+    CHECK(csr.getError() == MATRIX_SUCCESS && csc.getError() == MATRIX_SUCCESS);
+    CHECK(maxDiff(csr.toDense(), dense) <= 1e-15 && maxDiff(csc.toDense(), dense) <= 1e-15);
+    CHECK(maxDiff(csr.convert(SPARSE_CSC).toDense(), dense) == 0);
+    CHECK(maxDiff(csr.transpose().toDense(), dense.view().transposed()) == 0);
+    CHECK(csr.coeff(5, 7) == csc.coeff(5, 7));
+    CHECK(maxDiff(SparseMatrix::fromDense(dense).toDense(), dense) == 0);
+
+    // one column takes the gather kernel, more the broadcast kernel
+    for (size_t k : {1, 5, 9})
+    {
+        Matrix x = random(cols, k, 22);
+        Matrix ref = naiveProduct(dense, x);
+        CHECK(maxDiff(csr * x, ref) <= 1e-13 && maxDiff(csc * x, ref) <= 1e-13);
+        CHECK(sameBits(csr.multiply(x, 1), csr.multiply(x, 4)));
+    }
+    Matrix wide = random(2 * cols, 3, 23);
+    CHECK(maxDiff(csr.multiply(wide.block(0, 1, cols, 1)), naiveProduct(dense, wide.block(0, 1, cols, 1))) <= 1e-13);
+    SparseMatrixBuilder bad(2, 2);
+    bad.add(2, 0, 1.0);
+    CHECK(bad.build().getError() == MATRIX_ERR_INVALID);
+}
+
+// ---- binary round trips ----
+
+static const char *const binaryFile = "matrices_test.bin";
+
+// a random matrix with the values that tend to go wrong in I/O in its
+// first row: signed zero, infinities, NaN, subnormals and the extremes
+static Matrix awkward(size_t r, size_t c, unsigned seed)
+{
+    Matrix m = random(r, c, seed);
+    const double special[] = {-0.0, INFINITY, -INFINITY, NAN, 4.9e-324, -2.2250738585072009e-308,
+                              DBL_MAX, -DBL_MIN, 0.1, 1e-300, 123456789.0, 1.0 / 3};
+    for (size_t j = 0; j < c && j < sizeof special / sizeof special[0]; ++j)
+        m.at(0, j) = special[j];
+    return m;
+}
+
+static void patchFile(const char *name, long offset, const void *bytes, size_t n)
+{
+    FILE *f = fopen(name, "r+b");
+    if (!f)
+        return;
+    fseek(f, offset, SEEK_SET);
+    fwrite(bytes, 1, n, f);
+    fclose(f);
+}
+
+static void testBinaryRoundTrip()
+{
+    Matrix a = awkward(70, 45, 24);
+    CHECK(a.saveToBinary(binaryFile));
+    Matrix b = Matrix::loadFromBinary(binaryFile);
+    CHECK(b.getError() == MATRIX_SUCCESS && sameBits(a, b));
+
+    {
+        MappedMatrix mapped(binaryFile, true);
+        CHECK(mapped.getError() == MATRIX_SUCCESS && mapped.numRows() == 70 && mapped.numCols() == 45);
+        CHECK(mapped.verify() == MATRIX_SUCCESS && sameBits(Matrix(mapped.view()), a));
+    }
+
+    Matrix empty(0, 4);
+    CHECK(empty.saveToBinary(binaryFile));
+    Matrix e = Matrix::loadFromBinary(binaryFile);
+    CHECK(e.getError() == MATRIX_SUCCESS && e.numRows() == 0 && e.numCols() == 4);
+
+    // a flipped payload bit fails the checksum; a bad magic or a short file
+    // is not read at all
+    CHECK(a.saveToBinary(binaryFile));
+    unsigned char flip = 0x5a;
+    patchFile(binaryFile, 64 + 8 * 100, &flip, 1);
+    CHECK(Matrix::loadFromBinary(binaryFile).getError() == MATRIX_ERR_IO);
+    {
+        MappedMatrix mapped(binaryFile);
+        CHECK(mapped.getError() == MATRIX_SUCCESS && mapped.verify() == MATRIX_ERR_IO);
+    }
+    patchFile(binaryFile, 0, "NOTAMATRIX", 10);
+    CHECK(Matrix::loadFromBinary(binaryFile).getError() != MATRIX_SUCCESS);
+
+    // the headerless files of earlier versions: native rows and cols, then
+    // the elements
+    Matrix old = random(3, 5, 25);
+    FILE *f = fopen(binaryFile, "wb");
+    size_t shape[2] = {3, 5};
+    if (f)
+    {
+        fwrite(shape, sizeof shape, 1, f);
+        fwrite(&old.at(0, 0), sizeof(double), 15, f);
+        fclose(f);
+    }
+    Matrix legacy = Matrix::loadFromBinary(binaryFile);
+    CHECK(legacy.getError() == MATRIX_SUCCESS && sameBits(legacy, old));
+    f = fopen(binaryFile, "wb");
+    if (f)
+    {
+        fwrite(shape, sizeof shape, 1, f);
+        fwrite(&old.at(0, 0), sizeof(double), 14, f);
+        fclose(f);
+    }
+    CHECK(Matrix::loadFromBinary(binaryFile).getError() != MATRIX_SUCCESS);
+    CHECK(Matrix::loadFromBinary("matrices_test.missing").getError() == MATRIX_ERR_IO);
+    remove(binaryFile);
+}
+
+// ---- text round trips ----
+
+static const char *const textFile = "matrices_test.txt";
+
+static void writeText(const char *text)
+{
+    FILE *f = fopen(textFile, "wb");
+    if (!f)
+        return;
+    fputs(text, f);
+    fclose(f);
+}
+
+static bool parseFails(const char *text, size_t line, size_t column)
+{
+    writeText(text);
+    MatrixParseError where = {0, 0, nullptr};
+    Matrix m = Matrix::loadFromText(textFile, &where);
+    return m.getError() == MATRIX_ERR_PARSE && where.line == line && where.column == column && where.reason;
+}
+
+static void testTextRoundTrip()
+{
+    Matrix a = awkward(9, 14, 26);
+    CHECK(a.saveToText(textFile));
+    Matrix b = Matrix::loadFromText(textFile);
+    CHECK(b.getError() == MATRIX_SUCCESS && sameBits(a, b));
+
+    // about 10 MB of text: more than one read chunk, parsed on the workers
+    Matrix big = awkward(700, 700, 27);
+    CHECK(big.saveToText(textFile));
+    Matrix bigBack = Matrix::loadFromText(textFile);
+    CHECK(bigBack.getError() == MATRIX_SUCCESS && sameBits(big, bigBack));
+
+    writeText("2 3\n1, 2; 3\n\t-0 inf,nan\n");
+    Matrix mixed = Matrix::loadFromText(textFile);
+    CHECK(mixed.getError() == MATRIX_SUCCESS && mixed.numRows() == 2 && mixed.numCols() == 3);
+    CHECK(mixed.at(0, 2) == 3 && std::signbit(mixed.at(1, 0)) && std::isinf(mixed.at(1, 1)) && std::isnan(mixed.at(1, 2)));
+
+    // out of range: overflow to +-inf, underflow to +-0, whatever the digits look like
+    char range[1024];
+    snprintf(range, sizeof range, "2 4\n1.5e400 -1e-400 -2e99999999999999999999 +1000e-330\n"
+                                  "-0.5e310 0.%0400de-1 1%0400d 0.0000001e-320\n", 1, 0);
+    writeText(range);
+    Matrix extreme = Matrix::loadFromText(textFile);
+    CHECK(extreme.getError() == MATRIX_SUCCESS);
+    CHECK(extreme.at(0, 0) == HUGE_VAL && extreme.at(0, 1) == 0 && std::signbit(extreme.at(0, 1)));
+    CHECK(extreme.at(0, 2) == -HUGE_VAL && extreme.at(0, 3) == 0 && !std::signbit(extreme.at(0, 3)));
+    CHECK(extreme.at(1, 0) == -HUGE_VAL && extreme.at(1, 1) == 0 && extreme.at(1, 2) == HUGE_VAL);
+    CHECK(extreme.at(1, 3) == 0);
+
+    CHECK(parseFails("2 2\n1, 2;\n3 x\n", 3, 3));
+    CHECK(parseFails("2 2\n1 2 3\n", 3, 1));
+    CHECK(parseFails("2 2\n1 2 3 4 5\n", 2, 9));
+
+    // read leaves the stream after the matrix, so matrices can follow each other
+    FILE *f = tmpfile();
+    if (f)
+    {
+        fputs("1 2\n5;6\n2 1\n7,\n8\n", f);
+        rewind(f);
+        Matrix first = Matrix::read(f);
+        Matrix second = Matrix::read(f);
+        CHECK(first.getError() == MATRIX_SUCCESS && first.numCols() == 2 && first.at(0, 1) == 6);
+        CHECK(second.getError() == MATRIX_SUCCESS && second.numRows() == 2 && second.at(1, 0) == 8);
+        fclose(f);
+    }
+    remove(textFile);
+}
+
+// ---- view assignment with aliasing ----
+
+static void testAliasing()
+{
+    // a smaller block of the destination: the old storage must outlive the
+    // evaluation
+    Matrix a = numbered(4, 4);
+    a = a.block(0, 0, 2, 2) * 2.0;
+    CHECK(a.getError() == MATRIX_SUCCESS && a.numRows() == 2 && a.numCols() == 2);
+    CHECK(a.at(0, 0) == 0 && a.at(0, 1) == 2 && a.at(1, 0) == 8 && a.at(1, 1) == 10);
+
+    // the same element count read in another layout
+    Matrix t = numbered(3, 3);
+    t = t.view().transposed();
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            CHECK(t.at(i, j) == (double)(j * 3 + i));
+
+    Matrix s = numbered(2, 8);
+    s = s.view().transposed() + numbered(8, 2);
+    CHECK(s.numRows() == 8 && s.numCols() == 2);
+    for (size_t i = 0; i < 8; ++i)
+        for (size_t j = 0; j < 2; ++j)
+            CHECK(s.at(i, j) == (double)(j * 8 + i) + (double)(i * 2 + j));
+
+    // element for element stays in place
+    Matrix e = numbered(3, 4);
+    const double *before = &e.at(0, 0);
+    e = e * 3.0 - e.view();
+    CHECK(&e.at(0, 0) == before && e.at(2, 3) == 22.0);
+
+    // a window written from an overlapping, shifted window and from its own
+    // transpose
+    Matrix w = numbered(4, 4);
+    w.block(1, 1, 3, 3) = w.block(0, 0, 3, 3);
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            CHECK(w.at(i + 1, j + 1) == (double)(i * 4 + j));
+    Matrix v = numbered(3, 3);
+    v.view() = v.view().transposed();
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            CHECK(v.at(i, j) == (double)(j * 3 + i));
+}
+
+// ---- expressions used where a matrix or a view is read ----
+
+static void testExpressionResults()
+{
+    Matrix a = numbered(2, 2), b = numbered(2, 2), c = numbered(3, 2);
+    CHECK((a + b).getError() == MATRIX_SUCCESS);
+    CHECK((a - c).getError() == MATRIX_ERR_DIM_MISMATCH);
+    Matrix e = (a * 2.0).eval();
+    CHECK(e.at(1, 1) == 6.0);
+
+    // converted to a view of the evaluated result
+    Matrix spd(2, 2);
+    spd.at(0, 0) = 4;
+    spd.at(0, 1) = spd.at(1, 0) = 2;
+    spd.at(1, 1) = 3;
+    CholeskyDecomposition chol(spd * 1.0);
+    CHECK(chol.getError() == MATRIX_SUCCESS);
+    Matrix x = solve(spd + spd, numbered(2, 1) + numbered(2, 1));
+    CHECK(x.getError() == MATRIX_SUCCESS && std::fabs(x.at(0, 0) + 0.25) < 1e-12 &&
+          std::fabs(x.at(1, 0) - 0.5) < 1e-12);
+    Matrix p = multiply(a + b, a.view());
+    CHECK(p.at(1, 1) == 2 * (2.0 * 1 + 3.0 * 3));
+}
+
+// empty shapes: no element is ever addressed
+static void testEmpty()
+{
+    Matrix z(3, 0);
+    ConstMatrixView v = z;
+    CHECK(v.data() == nullptr && v.numRows() == 3 && v.numCols() == 0);
+    Matrix sum = z + z;
+    CHECK(sum.getError() == MATRIX_SUCCESS && sum.numRows() == 3 && sum.numCols() == 0);
+    Matrix p = multiply(z, Matrix(0, 2));
+    CHECK(p.numRows() == 3 && p.numCols() == 2 && p.at(2, 1) == 0.0);
+}
+
+// ---- allocation failures ----
+
+// the heap allocator, refusing every block of more than limit doubles
+class LimitedAllocator : public MatrixAllocator
+{
+public:
+    size_t limit;
+
+    explicit LimitedAllocator(size_t n) : limit(n) {}
+    double *allocate(size_t count) override
+    {
+        return count > limit ? nullptr : heap.allocate(count);
+    }
+    void release(double *p, size_t count) override { heap.release(p, count); }
+
+private:
+    MatrixHeapAllocator heap;
+};
+
+// results that cannot be allocated come back empty with MATRIX_ERR_ALLOC,
+// and nothing is written through their null data
+static void testAllocationFailure()
+{
+    Matrix col = random(400, 1, 28), row = random(1, 400, 29), pow2 = random(32, 32, 30);
+    Matrix square = wellConditioned(40, 31);
+    LUDecomposition lu(square);
+    QRDecomposition qr(square);
+    LimitedAllocator limited(1000);
+    MatrixAllocator *previous = Matrix::getAllocator();
+    Matrix::setAllocator(&limited);
+
+    CHECK(multiply(col, row).getError() == MATRIX_ERR_ALLOC);
+    CHECK(col.multiply(row).getError() == MATRIX_ERR_ALLOC);
+    CHECK(col.multiplyStrassen(row).getError() == MATRIX_ERR_ALLOC);
+    CHECK(pow2.multiplyStrassen(pow2).getError() == MATRIX_ERR_ALLOC);
+    CHECK(square.resize(400, 400).getError() == MATRIX_ERR_ALLOC);
+    // 40 x 40 results no longer fit
+    limited.limit = 1599;
+    CHECK(lu.inverse().getError() == MATRIX_ERR_ALLOC);
+    CHECK(qr.r().getError() == MATRIX_ERR_ALLOC && qr.q().getError() == MATRIX_ERR_ALLOC);
+    CHECK(square.cofactor().getError() == MATRIX_ERR_ALLOC);
+
+    Matrix::setAllocator(previous);
+    CHECK(lu.inverse().getError() == MATRIX_SUCCESS);
+}
+
+int main()
+{
+    testMultiply();
+    testThreads();
+    testStrassen();
+    testLU();
+    testSolve();
+    testCholeskyQR();
+    testElementwise();
+    testViews();
+    testTranspose();
+    testSparse();
+    testBinaryRoundTrip();
+    testTextRoundTrip();
+    testAliasing();
+    testExpressionResults();
+    testEmpty();
+    testAllocationFailure();
+    if (failures)
+        fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        printf("all matrix tests passed\n");
+    return failures;
+}
@@ -0,0 +1,267 @@
+/* Vector kernels behind the Matrix arithmetic, transposes and sparse products.
+ *
+ * This file is included once per ISA tier from matrices.cpp, with
+ *   MAT_VLEN      number of double lanes in a vector (2, 4 or 8)
+ *   MAT_MR        rows of the register tile of C
+ *   MAT_VNAME(x)  x suffixed with the tier name (x_sse2, x_avx2, ...)
+ * defined, and a matching target pragma in effect. It has no include guard
+ * on purpose. */
+
+#define MV MAT_VNAME(mvec)
+#define GEMM_NR (2 * MAT_VLEN)
+
+typedef double MV __attribute__((vector_size(MAT_VLEN * 8)));
+
+/* x in every lane (0 + x would turn -0 into +0) */
+static inline MV MAT_VNAME(msplat)(double x)
+{
+    MV v;
+    for (int l = 0; l < MAT_VLEN; ++l)
+        v[l] = x;
+    return v;
+}
+
+/* c + a * b with the product rounded before the add, as the scalar
+ * c += a * b: the empty asm keeps the two from being fused into an FMA, so
+ * products come out the same on every tier. */
+static inline MV MAT_VNAME(mmuladd)(MV a, MV b, MV c)
+{
+    MV p = a * b;
+    __asm__("" : "+v"(p));
+    return p + c;
+}
+
+/* c[0..mr) x [0..nr) += a * b over kc steps of the packed slivers: a holds
+ * MAT_MR values per step, b GEMM_NR. The MAT_MR x GEMM_NR tile stays in
+ * registers; a partial tile at the bottom or right edge of C goes through
+ * a zero-padded copy. */
+static void MAT_VNAME(gemmKernel)(size_t kc, const double *a, const double *b, double *c, size_t ldc,
+                                  size_t mr, size_t nr)
+{
+    double edge[MAT_MR * GEMM_NR];
+    double *t = c;
+    size_t ldt = ldc;
+    if (mr < MAT_MR || nr < GEMM_NR)
+    {
+        for (size_t i = 0; i < MAT_MR; ++i)
+            for (size_t j = 0; j < GEMM_NR; ++j)
+                edge[i * GEMM_NR + j] = i < mr && j < nr ? c[i * ldc + j] : 0.0;
+        t = edge;
+        ldt = GEMM_NR;
+    }
+
+    MV c0[MAT_MR], c1[MAT_MR];
+#pragma GCC unroll 8
+    for (size_t i = 0; i < MAT_MR; ++i)
+    {
+        std::memcpy(&c0[i], t + i * ldt, sizeof(MV));
+        std::memcpy(&c1[i], t + i * ldt + MAT_VLEN, sizeof(MV));
+    }
+    for (size_t p = 0; p < kc; ++p, a += MAT_MR, b += GEMM_NR)
+    {
+        MV b0, b1;
+        std::memcpy(&b0, b, sizeof b0);
+        std::memcpy(&b1, b + MAT_VLEN, sizeof b1);
+#pragma GCC unroll 8
+        for (size_t i = 0; i < MAT_MR; ++i)
+        {
+            MV ai = MAT_VNAME(msplat)(a[i]);
+            c0[i] = MAT_VNAME(mmuladd)(ai, b0, c0[i]);
+            c1[i] = MAT_VNAME(mmuladd)(ai, b1, c1[i]);
+        }
+    }
+#pragma GCC unroll 8
+    for (size_t i = 0; i < MAT_MR; ++i)
+    {
+        std::memcpy(t + i * ldt, &c0[i], sizeof(MV));
+        std::memcpy(t + i * ldt + MAT_VLEN, &c1[i], sizeof(MV));
+    }
+
+    if (t == edge)
+        for (size_t i = 0; i < mr; ++i)
+            for (size_t j = 0; j < nr; ++j)
+                c[i * ldc + j] = edge[i * GEMM_NR + j];
+}
+
+/* C (m x n) += alpha * A (m x k) * B (k x n). A and B are read through row
+ * and column strides (so views and transposes pack without a copy), C is
+ * row-major with leading dimension ldc; alpha scales A as it is packed
+ * (exactly, for alpha = -1). B is packed one GEMM_KC x GEMM_NC panel at a time into
+ * GEMM_NR-column slivers, A one GEMM_MC x GEMM_KC block at a time into
+ * MAT_MR-row slivers, so the kernel streams both from contiguous memory:
+ * the B sliver it reuses sits in L1, the A block in L2. The k blocks are
+ * taken in order, so every element of C still sums its products in k order.
+ * work holds gemmWorkSize(m, n, k) doubles. */
+static void MAT_VNAME(gemm)(size_t m, size_t n, size_t k, const double *a, size_t rsa, size_t csa,
+                            const double *b, size_t rsb, size_t csb, double *c, size_t ldc, double alpha,
+                            double *work)
+{
+    double *packA = work;
+    double *packB = work + std::min(m + GEMM_MR_MAX, (size_t)GEMM_MC) * std::min(k, (size_t)GEMM_KC);
+
+    for (size_t jc = 0; jc < n; jc += GEMM_NC)
+    {
+        size_t nc = std::min(n - jc, (size_t)GEMM_NC);
+        for (size_t pc = 0; pc < k; pc += GEMM_KC)
+        {
+            size_t kc = std::min(k - pc, (size_t)GEMM_KC);
+            for (size_t jr = 0; jr < nc; jr += GEMM_NR)
+            {
+                size_t nr = std::min(nc - jr, (size_t)GEMM_NR);
+                double *dst = packB + jr * kc;
+                for (size_t p = 0; p < kc; ++p, dst += GEMM_NR)
+                {
+                    const double *src = b + (pc + p) * rsb + (jc + jr) * csb;
+                    for (size_t j = 0; j < GEMM_NR; ++j)
+                        dst[j] = j < nr ? src[j * csb] : 0.0;
+                }
+            }
+
+            for (size_t ic = 0; ic < m; ic += GEMM_MC)
+            {
+                size_t mc = std::min(m - ic, (size_t)GEMM_MC);
+                for (size_t ir = 0; ir < mc; ir += MAT_MR)
+                {
+                    size_t mr = std::min(mc - ir, (size_t)MAT_MR);
+                    double *dst = packA + ir * kc;
+                    const double *src = a + (ic + ir) * rsa + pc * csa;
+                    for (size_t p = 0; p < kc; ++p, dst += MAT_MR)
+                        for (size_t i = 0; i < MAT_MR; ++i)
+                            dst[i] = i < mr ? alpha * src[i * rsa + p * csa] : 0.0;
+                }
+
+                for (size_t jr = 0; jr < nc; jr += GEMM_NR)
+                    for (size_t ir = 0; ir < mc; ir += MAT_MR)
+                        MAT_VNAME(gemmKernel)(kc, packA + ir * kc, packB + jr * kc,
+                                              c + (ic + ir) * ldc + jc + jr, ldc,
+                                              std::min(mc - ir, (size_t)MAT_MR),
+                                              std::min(nc - jr, (size_t)GEMM_NR));
+            }
+        }
+    }
+}
+
+/* dst = src^T for a MAT_VLEN x MAT_VLEN block, in registers: each round
+ * swaps the off-diagonal d x d blocks of every 2d x 2d block, halving d
+ * down to 1, so log2(MAT_VLEN) rounds of two-vector shuffles suffice. */
+static inline void MAT_VNAME(transposeKernel)(const double *src, size_t lds, double *dst, size_t ldd)
+{
+    typedef long long MI __attribute__((vector_size(MAT_VLEN * 8)));
+    MV r[MAT_VLEN];
+#pragma GCC unroll 8
+    for (int i = 0; i < MAT_VLEN; ++i)
+        std::memcpy(&r[i], src + i * lds, sizeof(MV));
+#pragma GCC unroll 4
+    for (int d = MAT_VLEN / 2; d >= 1; d /= 2)
+    {
+        MI lo, hi;
+#pragma GCC unroll 8
+        for (int l = 0; l < MAT_VLEN; ++l)
+        {
+            lo[l] = (l & d) ? MAT_VLEN + l - d : l;
+            hi[l] = (l & d) ? MAT_VLEN + l : l + d;
+        }
+#pragma GCC unroll 8
+        for (int i = 0; i < MAT_VLEN; ++i)
+            if (!(i & d))
+            {
+                MV x = r[i], y = r[i + d];
+                r[i] = __builtin_shuffle(x, y, lo);
+                r[i + d] = __builtin_shuffle(x, y, hi);
+            }
+    }
+#pragma GCC unroll 8
+    for (int i = 0; i < MAT_VLEN; ++i)
+        std::memcpy(dst + i * ldd, &r[i], sizeof(MV));
+}
+
+/* dst (cols x rows) = src^T (rows x cols) for a tile small enough that both
+ * sit in L1: whole register blocks, then the ragged right and bottom rims */
+static void MAT_VNAME(transposeTile)(size_t rows, size_t cols, const double *src, size_t lds, double *dst,
+                                     size_t ldd)
+{
+    size_t rb = rows - rows % MAT_VLEN, cb = cols - cols % MAT_VLEN;
+    for (size_t i = 0; i < rb; i += MAT_VLEN)
+        for (size_t j = 0; j < cb; j += MAT_VLEN)
+            MAT_VNAME(transposeKernel)(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = i < rb ? cb : 0; j < cols; ++j)
+            dst[j * ldd + i] = src[i * lds + j];
+}
+
+/* Y = A X over the rows [begin, end) of a CSR matrix: row i holds the
+ * entries [offsets[i], offsets[i + 1]) of indices and values. X has k
+ * columns and row stride ldx, Y row stride ldy, both unit column stride.
+ * For one column, MAT_VLEN entries of A meet MAT_VLEN gathered elements of
+ * x per step (for a contiguous x); for more, each entry of A is broadcast
+ * over a row of X, 2 * MAT_VLEN columns of the row of Y at a time. */
+static void MAT_VNAME(sparseRows)(size_t begin, size_t end, const size_t *offsets, const uint32_t *indices,
+                                  const double *values, const double *x, size_t ldx, size_t k, double *y,
+                                  size_t ldy)
+{
+    const MV zero = MAT_VNAME(msplat)(0.0);
+    if (k == 1)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            size_t p = offsets[i], e = offsets[i + 1];
+            double t = 0.0;
+            if (ldx == 1 && e - p >= MAT_VLEN)
+            {
+                MV s0 = zero, s1 = zero, v0, v1;
+                for (; p + 2 * MAT_VLEN <= e; p += 2 * MAT_VLEN)
+                {
+                    std::memcpy(&v0, values + p, sizeof v0);
+                    std::memcpy(&v1, values + p + MAT_VLEN, sizeof v1);
+                    s0 = MAT_VNAME(MAT_FMA)(v0, MAT_VNAME(MAT_GATHER)(x, indices + p), s0);
+                    s1 = MAT_VNAME(MAT_FMA)(v1, MAT_VNAME(MAT_GATHER)(x, indices + p + MAT_VLEN), s1);
+                }
+                if (p + MAT_VLEN <= e)
+                {
+                    std::memcpy(&v0, values + p, sizeof v0);
+                    s0 = MAT_VNAME(MAT_FMA)(v0, MAT_VNAME(MAT_GATHER)(x, indices + p), s0);
+                    p += MAT_VLEN;
+                }
+                s0 += s1;
+                for (int l = 0; l < MAT_VLEN; ++l)
+                    t += s0[l];
+            }
+            for (; p < e; ++p)
+                t += values[p] * x[indices[p] * ldx];
+            y[i * ldy] = t;
+        }
+        return;
+    }
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        size_t b = offsets[i], e = offsets[i + 1];
+        double *yi = y + i * ldy;
+        size_t j = 0;
+        for (; j + 2 * MAT_VLEN <= k; j += 2 * MAT_VLEN)
+        {
+            MV c0 = zero, c1 = zero, x0, x1;
+            for (size_t p = b; p < e; ++p)
+            {
+                const double *xr = x + indices[p] * ldx + j;
+                MV a = MAT_VNAME(msplat)(values[p]);
+                std::memcpy(&x0, xr, sizeof x0);
+                std::memcpy(&x1, xr + MAT_VLEN, sizeof x1);
+                c0 = MAT_VNAME(MAT_FMA)(a, x0, c0);
+                c1 = MAT_VNAME(MAT_FMA)(a, x1, c1);
+            }
+            std::memcpy(yi + j, &c0, sizeof c0);
+            std::memcpy(yi + j + MAT_VLEN, &c1, sizeof c1);
+        }
+        for (; j < k; ++j)
+        {
+            double t = 0.0;
+            for (size_t p = b; p < e; ++p)
+                t += values[p] * x[indices[p] * ldx + j];
+            yi[j] = t;
+        }
+    }
+}
+
+#undef GEMM_NR
+#undef MV